@@ -0,0 +1,90 @@
+///////////////////////////////////////////////////////////////////////////////
+// Copyright (c) Lewis Baker
+// Licenced under MIT license. See LICENSE.txt for details.
+///////////////////////////////////////////////////////////////////////////////
+#ifndef CPPCORO_ALIGNED_BUFFER_HPP_INCLUDED
+#define CPPCORO_ALIGNED_BUFFER_HPP_INCLUDED
+
+#include <cstddef>
+#include <new>
+#include <utility>
+
+namespace cppcoro
+{
+	/// Heap buffer whose address and size are multiples of an alignment, as
+	/// needed by reads and writes on files opened with
+	/// file_buffering_mode::unbuffered.
+	class aligned_buffer
+	{
+	public:
+
+		/// Construct an empty buffer.
+		aligned_buffer() noexcept
+			: m_data(nullptr)
+			, m_size(0)
+			, m_alignment(0)
+		{}
+
+		/// Allocate a buffer of at least \a size bytes.
+		///
+		/// \param alignment
+		/// A power of two, eg. file::unbuffered_alignment(). The size is
+		/// rounded up to a multiple of it.
+		///
+		/// \throws std::bad_alloc
+		aligned_buffer(std::size_t size, std::size_t alignment)
+			: m_data(nullptr)
+			, m_size((size + alignment - 1) & ~(alignment - 1))
+			, m_alignment(alignment)
+		{
+			if (m_size != 0)
+			{
+				m_data = static_cast<std::byte*>(
+					::operator new(m_size, std::align_val_t{ m_alignment }));
+			}
+		}
+
+		aligned_buffer(aligned_buffer&& other) noexcept
+			: m_data(std::exchange(other.m_data, nullptr))
+			, m_size(std::exchange(other.m_size, 0))
+			, m_alignment(std::exchange(other.m_alignment, 0))
+		{}
+
+		aligned_buffer& operator=(aligned_buffer&& other) noexcept
+		{
+			aligned_buffer temp{ std::move(other) };
+			std::swap(m_data, temp.m_data);
+			std::swap(m_size, temp.m_size);
+			std::swap(m_alignment, temp.m_alignment);
+			return *this;
+		}
+
+		aligned_buffer(const aligned_buffer&) = delete;
+		aligned_buffer& operator=(const aligned_buffer&) = delete;
+
+		~aligned_buffer()
+		{
+			if (m_data != nullptr)
+			{
+				::operator delete(m_data, m_size, std::align_val_t{ m_alignment });
+			}
+		}
+
+		std::byte* data() noexcept { return m_data; }
+		const std::byte* data() const noexcept { return m_data; }
+
+		/// The allocated size, a multiple of alignment().
+		std::size_t size() const noexcept { return m_size; }
+
+		std::size_t alignment() const noexcept { return m_alignment; }
+
+	private:
+
+		std::byte* m_data;
+		std::size_t m_size;
+		std::size_t m_alignment;
+
+	};
+}
+
+#endif
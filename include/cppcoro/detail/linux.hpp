@@ -24,7 +24,6 @@
 #include <string_view>
 #include <mutex>
 #include <cppcoro/coroutine.hpp>
-#include <functional>
 
 namespace cppcoro
 {
@@ -69,6 +68,9 @@ namespace cppcoro
 				/// Calls close() and sets the fd to -1.
 				void close() noexcept;
 
+				/// Give up ownership of the fd without closing it.
+				fd_t release() noexcept { return std::exchange(m_fd, -1); }
+
 				void swap(safe_fd& other) noexcept { std::swap(m_fd, other.m_fd); }
 
 				/// Test operator
@@ -93,21 +95,73 @@ namespace cppcoro
 				fd_t m_fd;
 			};
 
+			/// Completion record of an I/O request.
+			///
+			/// The continuation is either a coroutine handle, resumed directly,
+			/// or a plain function pointer with a context. Neither requires an
+			/// allocation or type-erased call to dispatch.
 			struct io_message
 			{
-				std::function<void()> resume;
+				using callback_t = void (*)(void* context) noexcept;
+
+				/// Receives each completion of a multishot request, \a more
+				/// being false for the last one. Returns whether to dispatch
+				/// the message's continuation.
+				using multishot_handler_t = bool (*)(void* context, int result, bool more) noexcept;
+
 				int   result = -1;
 
+				/// Provided buffer the operation completed with, see
+				/// io_transaction::recv_provided(), or -1.
+				int   bufferId = -1;
+
+				/// Completions still to be reaped before the message completes,
+				/// 0 unless committed as a chain with io_transaction::link().
+				std::uint32_t pendingCompletions = 0;
+
 				io_message& operator=(coroutine_handle<> coroutine_handle) noexcept {
-					resume = [coroutine_handle]() mutable {
-						coroutine_handle.resume();
-					};
-                    return *this;
+					m_callback = nullptr;
+					m_context = coroutine_handle.address();
+					return *this;
+				}
+
+				/// Invoke \a callback with \a context instead of resuming a coroutine.
+				void set_callback(callback_t callback, void* context) noexcept {
+					m_callback = callback;
+					m_context = context;
+				}
+
+				/// Hand every completion of a multishot request to \a handler as
+				/// it is reaped, on the reaping thread, instead of recording it
+				/// in result. The handler must not block.
+				void set_multishot_handler(multishot_handler_t handler, void* context) noexcept {
+					m_multishotHandler = handler;
+					m_multishotContext = context;
 				}
-                io_message& operator=(std::function<void()> function) noexcept {
-                    resume = std::move(function);
-                    return *this;
-                }
+
+				bool is_multishot() const noexcept { return m_multishotHandler != nullptr; }
+
+				bool on_multishot_completion(int result, bool more) noexcept {
+					return m_multishotHandler(m_multishotContext, result, more);
+				}
+
+				bool has_continuation() const noexcept {
+					return m_callback != nullptr || m_context != nullptr;
+				}
+
+				void resume() {
+					if (m_callback != nullptr) {
+						m_callback(m_context);
+					} else {
+						coroutine_handle<>::from_address(m_context).resume();
+					}
+				}
+
+			private:
+				callback_t m_callback = nullptr;
+				void* m_context = nullptr;
+				multishot_handler_t m_multishotHandler = nullptr;
+				void* m_multishotContext = nullptr;
 			};
 
 		}  // namespace linux
@@ -0,0 +1,317 @@
+///////////////////////////////////////////////////////////////////////////////
+// Copyright (c) Lewis Baker
+// Licenced under MIT license. See LICENSE.txt for details.
+///////////////////////////////////////////////////////////////////////////////
+#ifndef CPPCORO_DETAIL_LINUX_EPOLL_QUEUE_HPP_INCLUDED
+#define CPPCORO_DETAIL_LINUX_EPOLL_QUEUE_HPP_INCLUDED
+
+#include <cppcoro/config.hpp>
+
+#include <cppcoro/detail/linux.hpp>
+
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <mutex>
+#include <unordered_map>
+#include <vector>
+
+#include <linux/time_types.h>
+#include <sys/socket.h>
+#include <sys/uio.h>
+
+namespace cppcoro::detail::lnx
+{
+    class io_transaction;
+
+	/// Readiness based I/O queue for kernels without io_uring.
+	///
+	/// Each operation is first attempted with a non-blocking system call.
+	/// Only if that fails with EAGAIN is the operation parked on its file
+	/// descriptor and interest registered with epoll (EPOLLONESHOT). The
+	/// operation is retried once epoll reports the descriptor as ready.
+	///
+	/// Operations that complete straight away are reported to the caller by
+	/// io_transaction::commit() returning false, with the outcome in the
+	/// message's result, so that the awaiting coroutine doesn't need to
+	/// suspend. Everything else, including nop() and timeout(), completes
+	/// through dequeue().
+	class epoll_queue
+	{
+	public:
+		/// Provided for parity with the io_uring queue, epoll_queue has no
+		/// deferred submission.
+		class dispatch_scope
+		{
+		public:
+			explicit dispatch_scope(epoll_queue&) noexcept {}
+
+			dispatch_scope(const dispatch_scope&) = delete;
+			dispatch_scope& operator=(const dispatch_scope&) = delete;
+		};
+
+		/// \param queue_length
+		/// Maximum number of readiness events fetched by one epoll_wait().
+		explicit epoll_queue(size_t queue_length = 32);
+		~epoll_queue() noexcept;
+		epoll_queue(epoll_queue&&) = delete;
+		epoll_queue& operator=(epoll_queue&&) = delete;
+		epoll_queue(epoll_queue const&) = delete;
+		epoll_queue& operator=(epoll_queue const&) = delete;
+
+		io_transaction transaction(io_message &message) noexcept;
+
+		/// A transaction of \a length operations chained with
+		/// io_transaction::link(), provided for parity with the io_uring
+		/// queue.
+		io_transaction linked_transaction(io_message &message, unsigned length) noexcept;
+
+		/// Maximum number of completions reaped by a single dequeue() call.
+		static constexpr std::size_t max_dequeue_batch = 256;
+
+		bool dequeue(io_message*& message, bool wait);
+
+		/// Reap up to \a maxCount completions.
+		///
+		/// \param wait
+		/// Block in epoll_wait() until at least one completion is available.
+		///
+		/// \return
+		/// The number of completions written to \a messages.
+		std::size_t dequeue(io_message** messages, std::size_t maxCount, bool wait);
+
+		/// Complete \a message through dequeue(), waking a blocked thread.
+		void wake_up(io_message& message) noexcept;
+
+		/// Nothing is ever deferred, provided for parity with uring_queue.
+		void flush() noexcept {}
+
+		/// Set the number and size of the buffers io_transaction::recv_provided()
+		/// picks from. Defaults to 256 buffers of 4 KiB.
+		///
+		/// Must be called before the first provided buffer receive.
+		void set_provided_buffers(std::uint16_t count, std::uint32_t size) noexcept;
+
+		std::byte* provided_buffer(int id) const noexcept
+		{
+			return m_providedMemory + static_cast<std::size_t>(id) * m_providedSize;
+		}
+
+		std::uint32_t provided_buffer_size() const noexcept { return m_providedSize; }
+
+		/// Hand a provided buffer back for reuse.
+		void recycle_provided_buffer(int id) noexcept;
+
+	private:
+		friend class io_transaction;
+
+		enum class op_kind
+		{
+			nop,
+			read,
+			write,
+			readv,
+			writev,
+			recv,
+			recv_provided,
+			send,
+			recvmsg,
+			sendmsg,
+			connect,
+			accept,
+			close,
+			openat,
+			statx,
+			fsync,
+			sync_file_range,
+			fallocate,
+			madvise,
+			sendfile,
+			timeout,
+			timeout_remove,
+			cancel,
+		};
+
+		struct pending_op
+		{
+			op_kind kind = op_kind::nop;
+			io_message* message = nullptr;
+			int fd = -1;
+			void* buffer = nullptr;
+			std::size_t size = 0;
+			std::uint64_t offset = 0;
+			int flags = 0;
+			const void* address = nullptr;
+			socklen_t addressLength = 0;
+			socklen_t* addressLengthPtr = nullptr;
+			bool connectStarted = false;
+			pending_op* next = nullptr;
+		};
+
+		struct fd_state
+		{
+			pending_op* readers = nullptr;
+			pending_op* writers = nullptr;
+			bool registered = false;
+		};
+
+		struct timer
+		{
+			std::chrono::steady_clock::time_point deadline;
+			io_message* message;
+		};
+
+		/// Make one non-blocking attempt at \a op.
+		///
+		/// \return
+		/// false if the operation would block.
+		bool try_perform(pending_op& op) noexcept;
+
+		static bool is_write(op_kind kind) noexcept;
+
+		bool start(const pending_op& op) noexcept;
+		void start_timeout(io_message& message, const __kernel_timespec& ts, bool absolute) noexcept;
+		void remove_timeout(io_message& message) noexcept;
+		void cancel_op(io_message& message) noexcept;
+		void close_fd(int fd) noexcept;
+
+		pending_op* allocate_op();
+		void release_op(pending_op* op) noexcept;
+		bool update_interest(int fd, fd_state& state) noexcept;
+		void process_ready(int fd, std::uint32_t events) noexcept;
+		void process_timers() noexcept;
+		void rearm_timer() noexcept;
+		void complete(io_message& message, int result) noexcept;
+		void notify() noexcept;
+		int take_provided_buffer() noexcept;
+
+		const std::size_t m_maxEvents;
+
+		safe_fd m_epollFd;
+		safe_fd m_wakeUpFd;
+		safe_fd m_timerFd;
+
+		std::mutex m_mux;
+		std::size_t m_waitingThreads = 0;
+
+		std::unordered_map<int, fd_state> m_fds;
+
+		std::vector<timer> m_timers;
+		std::chrono::steady_clock::time_point m_timerDeadline;
+
+		std::vector<io_message*> m_ready;
+		std::size_t m_readyHead = 0;
+
+		std::vector<std::unique_ptr<pending_op>> m_opStorage;
+		pending_op* m_freeOps = nullptr;
+
+		// Provided buffers, allocated on first use. A buffer is only taken
+		// once the socket is readable, idle receives hold none.
+		std::mutex m_providedMux;
+		std::uint16_t m_providedCount = 256;
+		std::uint32_t m_providedSize = 4096;
+		std::unique_ptr<std::byte[]> m_providedStorage;
+		std::byte* m_providedMemory = nullptr;
+		std::vector<int> m_freeProvided;
+	};
+	using io_queue = epoll_queue;
+
+    /// RAII IO transaction
+    class [[nodiscard]] io_transaction final {
+    public:
+        io_transaction(epoll_queue &queue, io_message& message) noexcept;
+
+        /// \return
+        /// true if the operation will complete through epoll_queue::dequeue(),
+        /// false if it has already completed or failed, the outcome being
+        /// stored in the message's result.
+        bool commit() noexcept;
+
+        [[nodiscard]] io_transaction &read(int fd, void *buffer, size_t size, size_t offset) noexcept;
+        [[nodiscard]] io_transaction &write(int fd, const void * buffer, size_t size, size_t offset) noexcept;
+
+        /// There are no registered buffers without io_uring, these are plain
+        /// reads and writes. The iovec is only used with io_uring.
+        [[nodiscard]] io_transaction &read_fixed(
+            int fd, void *buffer, size_t size, size_t offset, int bufferIndex, iovec &fallbackVec) noexcept;
+        [[nodiscard]] io_transaction &write_fixed(
+            int fd, const void *buffer, size_t size, size_t offset, int bufferIndex, iovec &fallbackVec) noexcept;
+
+        [[nodiscard]] io_transaction &readv(int fd, iovec* vec, size_t count, size_t offset) noexcept;
+        [[nodiscard]] io_transaction &writev(int fd, iovec* vec, size_t count, size_t offset) noexcept;
+
+        [[nodiscard]] io_transaction &recv(int fd, void * buffer, size_t size, int flags = 0) noexcept;
+        [[nodiscard]] io_transaction &send(int fd, const void *buffer, size_t size, int flags = 0) noexcept;
+
+        /// Plain send, provided for parity with the io_uring queue.
+        [[nodiscard]] io_transaction &send_zc(int fd, const void *buffer, size_t size, int flags = 0, int bufferIndex = -1) noexcept;
+
+        /// Receive into a provided buffer, see epoll_queue::set_provided_buffers().
+        /// The message's bufferId is set to the buffer received into. Fails
+        /// with -ENOBUFS if all buffers are in use once data arrives.
+        [[nodiscard]] io_transaction &recv_provided(int fd, int flags = 0) noexcept;
+
+        [[nodiscard]] io_transaction &recvmsg(int fd, msghdr *msg, int flags = 0) noexcept;
+        [[nodiscard]] io_transaction &sendmsg(int fd, msghdr *msg, int flags = 0) noexcept;
+
+        [[nodiscard]] io_transaction &connect(int fd, const void* to, size_t to_size) noexcept;
+        [[nodiscard]] io_transaction &close(int fd) noexcept;
+
+        /// openat(2) and statx(2), performed synchronously on commit.
+        [[nodiscard]] io_transaction &openat(int dirfd, const char *path, int flags, mode_t mode) noexcept;
+        [[nodiscard]] io_transaction &statx(int dirfd, const char *path, int flags, unsigned mask, struct statx *buffer) noexcept;
+
+        [[nodiscard]] io_transaction &accept(int fd, const void* to, socklen_t* to_size, int flags = 0) noexcept;
+
+        [[nodiscard]] io_transaction &timeout(__kernel_timespec *ts, bool absolute = false) noexcept;
+        [[nodiscard]] io_transaction &timeout_remove(int flags = 0) noexcept;
+
+        /// Flush \a fd to storage with fsync(), or fdatasync() if \a dataOnly
+        /// is set. Performed synchronously on commit.
+        [[nodiscard]] io_transaction &fsync(int fd, bool dataOnly = false) noexcept;
+
+        /// sync_file_range(2) and fallocate(2), performed synchronously on
+        /// commit.
+        [[nodiscard]] io_transaction &sync_file_range(int fd, std::uint64_t offset, std::uint32_t size, unsigned flags) noexcept;
+        [[nodiscard]] io_transaction &fallocate(int fd, int mode, std::uint64_t offset, std::uint64_t size) noexcept;
+
+        /// madvise(2), performed synchronously on commit.
+        [[nodiscard]] io_transaction &madvise(void *address, std::uint32_t length, int advice) noexcept;
+
+        /// Copy up to \a size bytes from \a inFd at \a offset to \a outFd,
+        /// see sendfile(2), once \a outFd is writable.
+        [[nodiscard]] io_transaction &sendfile(int outFd, int inFd, std::uint64_t offset, std::size_t size) noexcept;
+
+        [[nodiscard]] io_transaction &nop() noexcept;
+
+        [[nodiscard]] io_transaction &cancel(int flags = 0) noexcept;
+
+        /// Link the operation prepared so far to the next one, with the same
+        /// outcome as on the io_uring queue.
+        ///
+        /// Readiness isn't waited for in the middle of a chain, so linked
+        /// operations are performed one after the other without blocking
+        /// and the chain always completes on commit. An operation that
+        /// would block fails with -EAGAIN.
+        [[nodiscard]] io_transaction &link(bool hard = false) noexcept;
+
+    private:
+        /// Perform m_op without waiting for readiness, returning its result.
+        int perform_linked() noexcept;
+
+        epoll_queue &m_queue;
+        io_message& m_message;
+        epoll_queue::pending_op m_op;
+        __kernel_timespec m_timeout{};
+        bool m_absoluteTimeout = false;
+
+        // First error of the operations linked so far, and whether it
+        // cancels the rest of the chain.
+        bool m_linked = false;
+        int m_linkError = 0;
+        bool m_linkBroken = false;
+    };
+}  // namespace cppcoro::detail::lnx
+
+#endif // CPPCORO_DETAIL_LINUX_EPOLL_QUEUE_HPP_INCLUDED
@@ -27,11 +27,8 @@
 
 namespace cppcoro::detail
 {
-#if CPPCORO_USE_IO_RING
+    // Both the io_uring and epoll queues take timeouts as __kernel_timespec.
     using event_timespec = __kernel_timespec;
-#else
-    using event_timespec = timespec;
-#endif
 
     template<typename _Rep, typename _Period>
     constexpr event_timespec duration_to_event_timespec(std::chrono::duration<_Rep, _Period> dur)
@@ -169,8 +166,9 @@ namespace cppcoro::detail
             const bool willCompleteAsynchronously = static_cast<OPERATION*>(this)->try_start();
             if (!willCompleteAsynchronously)
             {
-                // Operation completed synchronously, resume awaiting coroutine immediately.
-                this->m_message.result = error_operation_aborted;
+                // Operation completed synchronously, or failed to start, and its
+                // outcome is already in the message. Resume awaiting coroutine
+                // immediately.
                 return false;
             }
 
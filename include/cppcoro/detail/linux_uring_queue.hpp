@@ -9,14 +9,376 @@
 
 #include <cppcoro/detail/linux.hpp>
 
+#include <atomic>
 #include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <memory>
 #include <mutex>
+#include <vector>
 
 #include <liburing.h>
 
 namespace cppcoro::detail::lnx
 {
-    class uring_queue;
+    class io_transaction;
+
+	/// Counters describing how SQEs were batched into io_uring_submit() calls.
+	struct submit_stats
+	{
+		/// Number of io_uring_submit() calls that submitted at least one SQE.
+		std::uint64_t submit_calls = 0;
+
+		/// Total number of SQEs handed to the kernel.
+		std::uint64_t submitted_sqes = 0;
+
+		/// Largest number of SQEs carried by a single submit.
+		std::uint64_t max_sqes_per_submit = 0;
+	};
+
+	/// Opcodes used by io_transaction that a kernel may lack.
+	///
+	/// Each flag is true when the corresponding IORING_OP_* is used as is,
+	/// and false when io_transaction falls back to an older opcode or
+	/// another mechanism.
+	struct uring_capabilities
+	{
+		/// IORING_OP_READ and IORING_OP_WRITE, else READV/WRITEV.
+		bool read_write = true;
+
+		/// IORING_OP_SEND, else SENDMSG.
+		///
+		/// io_transaction::send() doesn't fall back by itself, the msghdr
+		/// must outlive the operation so the caller provides it.
+		bool send = true;
+
+		/// IORING_OP_RECV, else RECVMSG.
+		///
+		/// As with send, io_transaction::recv() doesn't fall back by itself,
+		/// the kernel writes the msghdr back on completion.
+		bool recv = true;
+
+		/// IORING_OP_ACCEPT, else POLL_ADD followed by accept4().
+		bool accept = true;
+
+		/// IORING_OP_CONNECT, else a non-blocking connect() followed by
+		/// POLL_ADD.
+		bool connect = true;
+
+		/// IORING_OP_CLOSE, else a synchronous close().
+		bool close = true;
+
+		/// IORING_OP_TIMEOUT_REMOVE, else ASYNC_CANCEL if available. Without
+		/// either a cancelled timeout completes when it expires.
+		bool timeout_remove = true;
+
+		/// IORING_OP_ASYNC_CANCEL, else POLL_REMOVE, which only finds polls.
+		/// Without it cancellable socket operations poll for readiness and
+		/// then make the call themselves, as accept and connect do without
+		/// their opcodes; other operations run to completion.
+		bool async_cancel = true;
+
+		/// IORING_OP_SEND_ZC, else SEND.
+		bool send_zc = true;
+
+		/// Provided buffer rings (5.19). Not probed, cleared if setting up
+		/// the ring fails. Without them provided buffer receives poll for
+		/// readiness and then receive into a buffer taken in user space.
+		bool buffer_ring = true;
+
+		/// IORING_OP_FALLOCATE, else a synchronous fallocate().
+		bool fallocate = true;
+
+		/// IORING_OP_OPENAT, else a synchronous openat().
+		bool openat = true;
+
+		/// IORING_OP_STATX, else a synchronous statx().
+		bool statx = true;
+
+		/// IORING_OP_MADVISE, else a synchronous madvise().
+		bool madvise = true;
+
+		/// IORING_OP_SPLICE, else net::socket::send_file() waits for the
+		/// socket to be writable and sends what fits in its buffer with
+		/// sendfile().
+		bool splice = true;
+	};
+
+	class uring_queue
+	{
+		class thread_ring;
+
+	public:
+		/// RAII scope marking the current thread as dispatching completion
+		/// events of \a queue.
+		///
+		/// While a dispatch scope is active, and deferred submission is
+		/// enabled, committed transactions only prepare their SQE. The SQEs
+		/// are submitted together by the next call to flush() or dequeue().
+		///
+		/// In ring-per-thread mode, transactions committed within the scope
+		/// go to the calling thread's own ring.
+		class dispatch_scope
+		{
+		public:
+			explicit dispatch_scope(uring_queue& queue) noexcept;
+			~dispatch_scope();
+
+			dispatch_scope(const dispatch_scope&) = delete;
+			dispatch_scope& operator=(const dispatch_scope&) = delete;
+
+		private:
+			uring_queue* m_previousQueue;
+			thread_ring* m_previousRing;
+		};
+
+		explicit uring_queue(size_t queue_length = 32, uint32_t flags = 0);
+		~uring_queue() noexcept;
+		uring_queue(uring_queue&&) = delete;
+		uring_queue& operator=(uring_queue&&) = delete;
+		uring_queue(uring_queue const&) = delete;
+		uring_queue& operator=(uring_queue const&) = delete;
+
+		io_transaction transaction(io_message &message) noexcept;
+
+		/// A transaction that always goes to the shared ring, for operations
+		/// on resources only registered with it, even while the calling
+		/// thread dispatches events of its own ring.
+		io_transaction shared_transaction(io_message &message) noexcept;
+
+		/// A transaction of \a length operations chained with
+		/// io_transaction::link(). The SQEs are reserved up front, under a
+		/// single lock acquisition, so that the chain is never split across
+		/// two submissions.
+		///
+		/// The transaction fails with -ENOSR if \a length exceeds the
+		/// submission queue.
+		io_transaction linked_transaction(io_message &message, unsigned length) noexcept;
+
+		/// Maximum number of completions reaped by a single dequeue() call.
+		static constexpr std::size_t max_dequeue_batch = 256;
+
+		/// Submits any pending deferred SQEs before looking for a completion.
+		bool dequeue(io_message*& message, bool wait);
+
+		/// Reap up to \a maxCount completions under a single lock acquisition,
+		/// advancing the completion queue once for the whole batch.
+		///
+		/// \param messages
+		/// Receives the message of each reaped completion. Entries may be null
+		/// for completions that carry no message, eg. cancellation requests.
+		///
+		/// \param maxCount
+		/// Capacity of \a messages. Clamped to max_dequeue_batch.
+		///
+		/// \param wait
+		/// Block until at least one completion is available.
+		///
+		/// \return
+		/// The number of completions written to \a messages.
+		std::size_t dequeue(io_message** messages, std::size_t maxCount, bool wait);
+
+		/// Set the number of deferred SQEs that triggers an early submit.
+		///
+		/// \param highWaterMark
+		/// A value of 0 (the default) disables deferred submission so that
+		/// every committed transaction is submitted immediately.
+		void set_submit_high_water_mark(std::size_t highWaterMark) noexcept;
+
+		/// Give every thread that enters the event loop its own ring.
+		///
+		/// Operations started while a thread dispatches completion events are
+		/// submitted to, and complete on, that thread's ring without taking
+		/// any lock. The thread rings are created with SINGLE_ISSUER and
+		/// DEFER_TASKRUN when the kernel supports them. Operations started from
+		/// other threads still use the shared ring, which every thread ring
+		/// polls. Cancellation requests are forwarded to the other rings with
+		/// IORING_OP_MSG_RING.
+		///
+		/// An operation started on a thread's ring only completes while that
+		/// thread keeps running the event loop.
+		///
+		/// Must be called before any thread has entered the event loop.
+		///
+		/// \return
+		/// true if the mode was enabled, false if the kernel lacks
+		/// IORING_OP_MSG_RING and the queue keeps using the shared ring only.
+		bool enable_ring_per_thread() noexcept;
+
+		/// Post a no-op completing with \a message to the shared ring, waking
+		/// a thread blocked in dequeue() whichever ring it is waiting on.
+		///
+		/// Unlike a transaction, this is never deferred nor routed to the
+		/// calling thread's own ring.
+		void wake_up(io_message& message) noexcept;
+
+		/// Submit all SQEs prepared by deferred transactions.
+		void flush() noexcept;
+
+		/// Get a snapshot of the submission counters, summed over all rings.
+		submit_stats stats() noexcept;
+
+		/// Opcodes found by probing the ring at construction, minus any
+		/// disabled with restrict_capabilities().
+		///
+		/// Kernels older than 5.6 can't be probed, in which case only the
+		/// opcodes available since 5.4 are assumed.
+		const uring_capabilities& capabilities() const noexcept { return m_capabilities; }
+
+		/// Stop using the opcodes that are false in \a capabilities, eg. to
+		/// exercise the fallbacks or to avoid a buggy kernel path.
+		///
+		/// Must be called before any operation is started.
+		void restrict_capabilities(const uring_capabilities& capabilities) noexcept;
+
+		/// Register \a buffers with the shared ring so that operations can
+		/// refer to them by index with io_transaction::read_fixed() and the
+		/// like.
+		///
+		/// A ring holds a single table of registered buffers. Kernels before
+		/// 5.13 wait for in-flight operations to complete when registering.
+		///
+		/// \return
+		/// 0 on success, else a negative errno, eg. -EBUSY if buffers are
+		/// already registered or -ENOMEM if over RLIMIT_MEMLOCK.
+		int register_buffers(const iovec* buffers, unsigned count) noexcept;
+
+		/// Unregister the buffers registered by register_buffers().
+		void unregister_buffers() noexcept;
+
+		/// Install \a fd in the shared ring's fixed file table so that
+		/// operations on it are submitted with IOSQE_FIXED_FILE, saving the
+		/// kernel a lookup in the file descriptor table for each of them.
+		///
+		/// The table slot is the fd itself. The table is registered sparse,
+		/// sized to RLIMIT_NOFILE, on the first call. Descriptors that don't
+		/// fit, or all of them if the kernel lacks sparse tables (5.19), are
+		/// silently left unregistered and used as plain fds.
+		void register_file(int fd) noexcept;
+
+		/// Remove \a fd from the fixed file table. Must be called before the
+		/// fd is closed, operations still in flight keep their reference to
+		/// the file.
+		void unregister_file(int fd) noexcept;
+
+		/// Whether operations on \a fd go out with IOSQE_FIXED_FILE.
+		bool is_registered_file(int fd) const noexcept;
+
+		/// Set the number and size of the buffers io_transaction::recv_provided()
+		/// picks from. Defaults to 256 buffers of 4 KiB.
+		///
+		/// Must be called before the first provided buffer receive.
+		///
+		/// \param count
+		/// A power of two, at most 32768.
+		void set_provided_buffers(std::uint16_t count, std::uint32_t size) noexcept;
+
+		/// Allocate the provided buffers and register them as a buffer ring
+		/// with the shared ring, unless already done.
+		///
+		/// \return
+		/// capabilities().buffer_ring, false if the kernel couldn't set up
+		/// the ring in which case the buffers are handed out with
+		/// take_provided_buffer() instead.
+		bool init_provided_buffers() noexcept;
+
+		std::byte* provided_buffer(int id) const noexcept
+		{
+			return m_providedMemory + static_cast<std::size_t>(id) * m_providedSize;
+		}
+
+		std::uint32_t provided_buffer_size() const noexcept { return m_providedSize; }
+
+		/// Take a provided buffer without the kernel, when there is no
+		/// buffer ring.
+		///
+		/// \return
+		/// The buffer's id, or -1 if all are in use.
+		int take_provided_buffer() noexcept;
+
+		/// Hand a provided buffer back for reuse.
+		void recycle_provided_buffer(int id) noexcept;
+
+    private:
+        friend class io_transaction;
+
+		struct ring_state
+		{
+			io_uring ring{};
+
+			// Only touched by the thread submitting to this ring, read
+			// without a lock by flush() and stats().
+			std::atomic<std::size_t> pendingSqes{0};
+			std::atomic<std::uint64_t> submitCalls{0};
+			std::atomic<std::uint64_t> submittedSqes{0};
+			std::atomic<std::uint64_t> maxSqesPerSubmit{0};
+		};
+
+		struct cancel_request
+		{
+			/// IORING_OP_ASYNC_CANCEL, IORING_OP_TIMEOUT_REMOVE or IORING_OP_POLL_REMOVE.
+			std::uint8_t opcode;
+			io_message* message;
+			int flags;
+		};
+
+		static void prep_cancel_request(io_uring_sqe* sqe, const cancel_request& request) noexcept;
+
+		ring_state& submission_ring() noexcept;
+		io_uring_sqe* get_sqe(ring_state& ring) noexcept;
+        int submit(ring_state& ring, std::size_t sqeCount = 1) noexcept;
+		int submit_pending(ring_state& ring) noexcept;
+
+		std::size_t dequeue_shared(io_message** messages, unsigned maxCount, bool wait);
+		std::size_t dequeue_thread(thread_ring& ring, io_message** messages, unsigned maxCount, bool wait);
+
+		thread_ring* cached_thread_ring() noexcept;
+		thread_ring& current_thread_ring();
+		void arm_doorbell(thread_ring& ring) noexcept;
+		void forward_cancel(const cancel_request& request, ring_state* submittedTo) noexcept;
+		void process_remote_requests(thread_ring& ring) noexcept;
+		bool init_file_table() noexcept;
+		void free_provided_buffers() noexcept;
+
+		static thread_local uring_queue* s_dispatchingQueue;
+		static thread_local thread_ring* s_dispatchingRing;
+		static thread_local thread_ring* s_threadRing;
+		static thread_local std::uint64_t s_threadRingQueueId;
+
+		const std::uint64_t m_id;
+		const std::size_t m_queueLength;
+
+		uring_capabilities m_capabilities;
+
+		std::mutex m_sqeMux;
+		std::mutex m_outMux;
+		ring_state m_sharedRing;
+
+		std::atomic<std::size_t> m_submitHighWaterMark{0};
+
+		std::atomic<bool> m_ringPerThread{false};
+		std::mutex m_threadRingsMux;
+		std::vector<std::unique_ptr<thread_ring>> m_threadRings;
+
+		// Slots of the fixed file table in use, indexed by fd. Allocated
+		// before m_fileTableSize is published.
+		std::mutex m_fileTableMux;
+		bool m_fileTableFailed = false;
+		std::unique_ptr<std::atomic<bool>[]> m_registeredFiles;
+		std::atomic<unsigned> m_fileTableSize{0};
+
+		// Provided buffers, set up on first use. Buffer ring entries are
+		// produced under m_providedMux.
+		static constexpr int provided_buffer_group = 0;
+		std::mutex m_providedMux;
+		std::atomic<bool> m_providedReady{false};
+		std::uint16_t m_providedCount = 256;
+		std::uint32_t m_providedSize = 4096;
+		std::byte* m_providedMemory = nullptr;
+		io_uring_buf_ring* m_bufRing = nullptr;
+		std::vector<int> m_freeProvided;
+	};
+	using io_queue = uring_queue;
 
     /// RAII IO transaction
     class [[nodiscard]] io_transaction final {
@@ -24,8 +386,27 @@ namespace cppcoro::detail::lnx
         io_transaction(uring_queue &queue, io_message& message) noexcept;
         bool commit() noexcept;
 
-        [[nodiscard]] io_transaction &read(int fd, void *buffer, size_t size, size_t offset) noexcept;
-        [[nodiscard]] io_transaction &write(int fd, const void * buffer, size_t size, size_t offset) noexcept;
+        /// \param fallbackVec
+        /// Set to \a buffer and passed to READV, or WRITEV, on kernels
+        /// without IORING_OP_READ and IORING_OP_WRITE. It must outlive the
+        /// operation: those kernels read it again from a worker thread if
+        /// the operation can't complete straight away.
+        [[nodiscard]] io_transaction &read(int fd, void *buffer, size_t size, size_t offset, iovec &fallbackVec) noexcept;
+        [[nodiscard]] io_transaction &write(int fd, const void * buffer, size_t size, size_t offset, iovec &fallbackVec) noexcept;
+
+        /// Read into a buffer registered with uring_queue::register_buffers().
+        ///
+        /// \param bufferIndex
+        /// Index of the registered buffer containing \a buffer. A plain read
+        /// is used instead if negative or if the transaction goes to a
+        /// thread's own ring, which has no registered buffers.
+        ///
+        /// \param fallbackVec
+        /// As for read().
+        [[nodiscard]] io_transaction &read_fixed(
+            int fd, void *buffer, size_t size, size_t offset, int bufferIndex, iovec &fallbackVec) noexcept;
+        [[nodiscard]] io_transaction &write_fixed(
+            int fd, const void *buffer, size_t size, size_t offset, int bufferIndex, iovec &fallbackVec) noexcept;
 
         [[nodiscard]] io_transaction &readv(int fd, iovec* vec, size_t count, size_t offset) noexcept;
         [[nodiscard]] io_transaction &writev(int fd, iovec* vec, size_t count, size_t offset) noexcept;
@@ -33,53 +414,127 @@ namespace cppcoro::detail::lnx
         [[nodiscard]] io_transaction &recv(int fd, void * buffer, size_t size, int flags = 0) noexcept;
         [[nodiscard]] io_transaction &send(int fd, const void *buffer, size_t size, int flags = 0) noexcept;
 
+        /// Zero copy send. The message completes once the kernel no longer
+        /// references \a buffer, with the number of bytes sent as result.
+        ///
+        /// Without IORING_OP_SEND_ZC this is send(), which doesn't fall back
+        /// to SENDMSG either; check uring_capabilities::send_zc first.
+        ///
+        /// \param bufferIndex
+        /// Index of the registered buffer containing \a buffer, or negative
+        /// if it isn't registered.
+        [[nodiscard]] io_transaction &send_zc(int fd, const void *buffer, size_t size, int flags = 0, int bufferIndex = -1) noexcept;
+
+        /// Receive into a buffer the kernel picks from the provided buffer
+        /// ring, see uring_queue::set_provided_buffers(). The message's
+        /// bufferId is set to the buffer received into.
+        ///
+        /// The ring is only registered with the shared ring, use
+        /// uring_queue::shared_transaction(). Fails with -ENOBUFS if all
+        /// buffers are in use once data arrives.
+        [[nodiscard]] io_transaction &recv_provided(int fd, int flags = 0) noexcept;
+
         [[nodiscard]] io_transaction &recvmsg(int fd, msghdr *msg, int flags = 0) noexcept;
         [[nodiscard]] io_transaction &sendmsg(int fd, msghdr *msg, int flags = 0) noexcept;
 
         [[nodiscard]] io_transaction &connect(int fd, const void* to, size_t to_size) noexcept;
         [[nodiscard]] io_transaction &close(int fd) noexcept;
 
+        /// Open \a path relative to \a dirfd, see openat(2), completing with
+        /// the new fd. \a path must stay valid until the operation completes.
+        [[nodiscard]] io_transaction &openat(int dirfd, const char *path, int flags, mode_t mode) noexcept;
+
+        /// Query the attributes of \a path relative to \a dirfd, see statx(2).
+        /// \a path and \a buffer must stay valid until the operation
+        /// completes.
+        [[nodiscard]] io_transaction &statx(int dirfd, const char *path, int flags, unsigned mask, struct statx *buffer) noexcept;
+
         [[nodiscard]] io_transaction &accept(int fd, const void* to, socklen_t* to_size, int flags = 0) noexcept;
 
+        /// Accept connections on \a fd until cancelled or an error occurs,
+        /// with a completion per accepted fd (5.19). The message must have a
+        /// multishot handler, see io_message::set_multishot_handler(). The
+        /// kernel may end the request early, eg. on completion queue
+        /// overflow, in which case the last completion still carries a fd.
+        [[nodiscard]] io_transaction &accept_multishot(int fd, int flags = 0) noexcept;
+
+        /// Complete once \a fd is ready for any of \a events (POLLIN, ...),
+        /// with the ready events as the result.
+        [[nodiscard]] io_transaction &poll(int fd, unsigned events) noexcept;
+
         [[nodiscard]] io_transaction &timeout(__kernel_timespec *ts, bool absolute = false) noexcept;
         [[nodiscard]] io_transaction &timeout_remove(int flags = 0) noexcept;
 
+        /// Flush \a fd to storage, only its data and the metadata needed to
+        /// read it back if \a dataOnly is set (IORING_FSYNC_DATASYNC).
+        [[nodiscard]] io_transaction &fsync(int fd, bool dataOnly = false) noexcept;
+
+        /// Write back the dirty pages of \a fd in the \a size bytes from
+        /// \a offset, see sync_file_range(2). A \a size of 0 extends to the
+        /// end of the file.
+        [[nodiscard]] io_transaction &sync_file_range(int fd, std::uint64_t offset, std::uint32_t size, unsigned flags) noexcept;
+
+        /// Manipulate the space allocated to \a fd, see fallocate(2).
+        [[nodiscard]] io_transaction &fallocate(int fd, int mode, std::uint64_t offset, std::uint64_t size) noexcept;
+
+        /// Give \a advice about the \a length bytes of memory at \a address,
+        /// see madvise(2). \a address must be page aligned.
+        [[nodiscard]] io_transaction &madvise(void *address, std::uint32_t length, int advice) noexcept;
+
+        /// Move \a size bytes from \a fdIn at \a offsetIn to \a fdOut at
+        /// \a offsetOut, see splice(2). One of them must be a pipe, whose
+        /// offset is -1.
+        [[nodiscard]] io_transaction &splice(
+            int fdIn, std::int64_t offsetIn, int fdOut, std::int64_t offsetOut, std::uint32_t size, unsigned flags) noexcept;
+
         [[nodiscard]] io_transaction &nop() noexcept;
 
         [[nodiscard]] io_transaction &cancel(int flags = 0) noexcept;
 
+        /// Link the operation prepared so far to the next one, which is only
+        /// started once it completes (IOSQE_IO_LINK). The transaction must
+        /// come from uring_queue::linked_transaction().
+        ///
+        /// The message completes once, with the first error of the chain or
+        /// else the result of its last operation. A failure cancels the rest
+        /// of the chain, as does a short read or write, which completes the
+        /// message with -EIO.
+        ///
+        /// \param hard
+        /// Start the next operation even if this one fails
+        /// (IOSQE_IO_HARDLINK). The error is still reported.
+        ///
+        /// Operations completing more than once, or synchronously on
+        /// commit, can't be linked.
+        [[nodiscard]] io_transaction &link(bool hard = false) noexcept;
+
     private:
-        uring_queue &m_queue;
-        io_message& m_message;
-        std::scoped_lock<std::mutex> m_sqeLock;
-        io_uring_sqe *m_sqe;
-    };
+        friend class uring_queue;
 
-	class uring_queue
-	{
-	public:
-		explicit uring_queue(size_t queue_length = 32, uint32_t flags = 0);
-		~uring_queue() noexcept;
-		uring_queue(uring_queue&&) = delete;
-		uring_queue& operator=(uring_queue&&) = delete;
-		uring_queue(uring_queue const&) = delete;
-		uring_queue& operator=(uring_queue const&) = delete;
+        io_transaction(uring_queue &queue, io_message& message, uring_queue::ring_state& ring, unsigned length = 1) noexcept;
 
-		io_transaction transaction(io_message &message) noexcept;
+        /// Fill the SQE with a no-op whose completion carries no message.
+        void prep_ignored() noexcept;
 
-		bool dequeue(io_message*& message, bool wait);
+        /// Submit the prepared SQE with IOSQE_FIXED_FILE if its fd is in
+        /// the fixed file table and the opcode takes a fixed file.
+        void use_fixed_file() noexcept;
 
-    private:
-        friend class io_transaction;
+        uring_queue &m_queue;
+        io_message& m_message;
+        uring_queue::ring_state& m_ring;
+        std::unique_lock<std::mutex> m_sqeLock;
+        io_uring_sqe *m_sqe;
+        bool m_forwardCancel = false;
+        uring_queue::cancel_request m_cancelRequest{};
 
-		io_uring_sqe* get_sqe() noexcept;
-        int submit() noexcept;
+        // SQEs reserved for, and linked by, link().
+        unsigned m_linksLeft = 0;
+        unsigned m_linkCount = 0;
 
-		std::mutex m_sqeMux;
-		std::mutex m_outMux;
-		io_uring ring_{};
-	};
-	using io_queue = uring_queue;
+        // Set when the operation was performed synchronously on commit.
+        bool m_completed = false;
+    };
 }  // namespace cppcoro::detail::lnx
 
 #endif // CPPCORO_DETAIL_LINUX_URING_QUEUE_HPP_INCLUDED
@@ -19,9 +19,22 @@
 
 #include <cppcoro/filesystem.hpp>
 
+#if CPPCORO_OS_LINUX
+# include <cppcoro/file_close_operation.hpp>
+# include <cppcoro/file_open_operation.hpp>
+# include <cppcoro/file_size_operation.hpp>
+# include <cppcoro/task.hpp>
+#endif
+
 namespace cppcoro
 {
 	class io_service;
+#if CPPCORO_OS_LINUX
+	namespace net
+	{
+		class socket;
+	}
+#endif
 
 	class file
 	{
@@ -34,8 +47,35 @@ namespace cppcoro
 		/// Get the size of the file in bytes.
 		std::uint64_t size() const;
 
+#if CPPCORO_OS_LINUX
+		/// Get the alignment required of the offset, size and buffer address
+		/// of reads and writes on a file opened with
+		/// file_buffering_mode::unbuffered. See aligned_buffer.
+		///
+		/// Reported by the file system on kernels since 6.1, else the logical
+		/// block size of a block device or the preferred I/O size of a file.
+		std::size_t unbuffered_alignment() const;
+
+		/// Get the size of the file in bytes with IORING_OP_STATX, without
+		/// blocking the calling thread.
+		[[nodiscard]]
+		file_size_operation size_async() const noexcept;
+
+		/// Close the file with IORING_OP_CLOSE, without blocking the calling
+		/// thread, eg. while a network file system flushes it.
+		///
+		/// The file no longer has a handle once the operation is created
+		/// and must not be used other than to be destroyed.
+		[[nodiscard]]
+		file_close_operation close_async() noexcept;
+#endif
+
 	protected:
 
+#if CPPCORO_OS_LINUX
+		friend class net::socket;
+#endif
+
 		explicit file(detail::safe_handle&& fileHandle) noexcept;
 
 		static detail::safe_handle open(
@@ -46,9 +86,20 @@ namespace cppcoro
 			file_share_mode shareMode,
 			file_buffering_mode bufferingMode);
 
+#if CPPCORO_OS_LINUX
+		/// Like open() but opens the file with IORING_OP_OPENAT.
+		static task<detail::safe_handle> open_async(
+			detail::dword_t fileAccess,
+			io_service& ioService,
+			const filesystem::path& path,
+			file_open_mode openMode,
+			file_share_mode shareMode,
+			file_buffering_mode bufferingMode);
+#endif
+
 		detail::safe_handle m_fileHandle;
 #if CPPCORO_OS_LINUX
-		io_service *m_ioService;
+		io_service *m_ioService = nullptr;
 #endif
 	};
 }
@@ -7,6 +7,12 @@
 
 namespace cppcoro
 {
+	/// Hints to the OS on how a file is used, combined with operator|.
+	///
+	/// On Linux sequential and random_access are passed on with
+	/// posix_fadvise(), unbuffered opens the file with O_DIRECT and
+	/// write_through with O_DSYNC. temporary creates an unnamed file with
+	/// O_TMPFILE in the directory the path names.
 	enum class file_buffering_mode
 	{
 		default_ = 0,
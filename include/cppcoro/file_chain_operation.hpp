@@ -0,0 +1,153 @@
+///////////////////////////////////////////////////////////////////////////////
+// Copyright (c) Lewis Baker
+// Licenced under MIT license. See LICENSE.txt for details.
+///////////////////////////////////////////////////////////////////////////////
+#ifndef CPPCORO_FILE_CHAIN_OPERATION_HPP_INCLUDED
+#define CPPCORO_FILE_CHAIN_OPERATION_HPP_INCLUDED
+
+#include <cppcoro/config.hpp>
+#include <cppcoro/cancellation_token.hpp>
+#include <cppcoro/file_durability.hpp>
+
+#if CPPCORO_OS_LINUX
+
+#include <cppcoro/detail/linux_io_operation.hpp>
+#include <cppcoro/io_service.hpp>
+
+#include <cstdint>
+#include <span>
+#include <sys/uio.h>
+
+namespace cppcoro
+{
+	/// One operation of a chain started with writable_file::write_chain().
+	class file_chain_step
+	{
+	public:
+
+		/// Write \a byteCount bytes from \a buffer at \a offset.
+		static file_chain_step write(
+			std::uint64_t offset, const void* buffer, std::size_t byteCount) noexcept
+		{
+			file_chain_step step{ kind::write };
+			step.m_offset = offset;
+			step.m_vec = { const_cast<void*>(buffer), byteCount };
+			return step;
+		}
+
+		/// Flush what was written so far to the storage device, see
+		/// writable_file::flush().
+		static file_chain_step flush(
+			file_durability durability = file_durability::data_and_metadata) noexcept
+		{
+			file_chain_step step{ kind::flush };
+			step.m_durability = durability;
+			return step;
+		}
+
+		/// Run the next step even if this one fails or, for a write, writes
+		/// less than asked. The chain still reports the failure.
+		file_chain_step& continue_on_failure() noexcept
+		{
+			m_continueOnFailure = true;
+			return *this;
+		}
+
+	private:
+
+		friend class file_chain_operation_impl;
+
+		enum class kind
+		{
+			write,
+			flush,
+		};
+
+		explicit file_chain_step(kind k) noexcept
+			: m_kind(k)
+		{}
+
+		kind m_kind;
+		bool m_continueOnFailure = false;
+		file_durability m_durability = file_durability::data_and_metadata;
+		std::uint64_t m_offset = 0;
+		// Writes are submitted as WRITEV, which unlike WRITE every kernel
+		// with linked requests has.
+		iovec m_vec{};
+
+	};
+
+	class file_chain_operation_impl
+	{
+	public:
+
+		/// The steps must outlive the operation.
+		file_chain_operation_impl(
+			detail::handle_t fileHandle, std::span<const file_chain_step> steps) noexcept
+			: m_fileHandle(fileHandle)
+			, m_steps(steps)
+		{}
+
+		bool try_start(cppcoro::detail::io_operation_base& operation) noexcept;
+		void cancel(cppcoro::detail::io_operation_base& operation) noexcept;
+
+	private:
+
+		detail::handle_t m_fileHandle;
+		std::span<const file_chain_step> m_steps;
+
+	};
+
+	class file_chain_operation
+		: public cppcoro::detail::io_operation<file_chain_operation>
+	{
+	public:
+
+		file_chain_operation(
+			io_service& ioService,
+			detail::handle_t fileHandle,
+			std::span<const file_chain_step> steps) noexcept
+			: cppcoro::detail::io_operation<file_chain_operation>(ioService.io_queue())
+			, m_impl(fileHandle, steps)
+		{}
+
+	private:
+
+		friend cppcoro::detail::io_operation<file_chain_operation>;
+
+		bool try_start() noexcept { return m_impl.try_start(*this); }
+
+		file_chain_operation_impl m_impl;
+
+	};
+
+	class file_chain_operation_cancellable
+		: public cppcoro::detail::io_operation_cancellable<file_chain_operation_cancellable>
+	{
+	public:
+
+		file_chain_operation_cancellable(
+			io_service& ioService,
+			detail::handle_t fileHandle,
+			std::span<const file_chain_step> steps,
+			cancellation_token&& ct) noexcept
+			: cppcoro::detail::io_operation_cancellable<file_chain_operation_cancellable>(
+				  ioService.io_queue(), std::move(ct))
+			, m_impl(fileHandle, steps)
+		{}
+
+	private:
+
+		friend cppcoro::detail::io_operation_cancellable<file_chain_operation_cancellable>;
+
+		bool try_start() noexcept { return m_impl.try_start(*this); }
+		void cancel() noexcept { m_impl.cancel(*this); }
+
+		file_chain_operation_impl m_impl;
+
+	};
+}  // namespace cppcoro
+
+#endif  // CPPCORO_OS_LINUX
+
+#endif
@@ -0,0 +1,45 @@
+///////////////////////////////////////////////////////////////////////////////
+// Copyright (c) Lewis Baker
+// Licenced under MIT license. See LICENSE.txt for details.
+///////////////////////////////////////////////////////////////////////////////
+#ifndef CPPCORO_FILE_CLOSE_OPERATION_HPP_INCLUDED
+#define CPPCORO_FILE_CLOSE_OPERATION_HPP_INCLUDED
+
+#include <cppcoro/config.hpp>
+
+#if CPPCORO_OS_LINUX
+
+#include <cppcoro/detail/linux_io_operation.hpp>
+#include <cppcoro/io_service.hpp>
+
+namespace cppcoro
+{
+	/// Closes a file handle with IORING_OP_CLOSE.
+	class file_close_operation
+		: public cppcoro::detail::io_operation<file_close_operation>
+	{
+	public:
+
+		/// Takes ownership of \a fileHandle, which is closed even if the
+		/// operation is never awaited.
+		file_close_operation(io_service& ioService, detail::safe_handle&& fileHandle) noexcept
+			: cppcoro::detail::io_operation<file_close_operation>(ioService.io_queue())
+			, m_fileHandle(std::move(fileHandle))
+		{}
+
+	private:
+
+		friend cppcoro::detail::io_operation<file_close_operation>;
+
+		bool try_start() noexcept;
+
+		void get_result() { io_operation_base::get_result(); }
+
+		detail::safe_handle m_fileHandle;
+
+	};
+}  // namespace cppcoro
+
+#endif  // CPPCORO_OS_LINUX
+
+#endif
@@ -0,0 +1,22 @@
+///////////////////////////////////////////////////////////////////////////////
+// Copyright (c) Lewis Baker
+// Licenced under MIT license. See LICENSE.txt for details.
+///////////////////////////////////////////////////////////////////////////////
+#ifndef CPPCORO_FILE_DURABILITY_HPP_INCLUDED
+#define CPPCORO_FILE_DURABILITY_HPP_INCLUDED
+
+namespace cppcoro
+{
+	/// What writable_file::flush() makes durable.
+	enum class file_durability
+	{
+		/// The data, and only the metadata needed to read it back such as
+		/// the file size (fdatasync).
+		data,
+
+		/// The data and all metadata, including eg. timestamps (fsync).
+		data_and_metadata
+	};
+}
+
+#endif
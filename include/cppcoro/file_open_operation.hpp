@@ -0,0 +1,58 @@
+///////////////////////////////////////////////////////////////////////////////
+// Copyright (c) Lewis Baker
+// Licenced under MIT license. See LICENSE.txt for details.
+///////////////////////////////////////////////////////////////////////////////
+#ifndef CPPCORO_FILE_OPEN_OPERATION_HPP_INCLUDED
+#define CPPCORO_FILE_OPEN_OPERATION_HPP_INCLUDED
+
+#include <cppcoro/config.hpp>
+
+#if CPPCORO_OS_LINUX
+
+#include <cppcoro/detail/linux_io_operation.hpp>
+#include <cppcoro/io_service.hpp>
+
+#include <sys/types.h>
+
+namespace cppcoro
+{
+	/// Opens a file with IORING_OP_OPENAT, yielding its handle.
+	class file_open_operation
+		: public cppcoro::detail::io_operation<file_open_operation>
+	{
+	public:
+
+		/// \param path
+		/// Must stay valid until the operation completes.
+		file_open_operation(
+			io_service& ioService,
+			const char* path,
+			int flags,
+			mode_t mode) noexcept
+			: cppcoro::detail::io_operation<file_open_operation>(ioService.io_queue())
+			, m_path(path)
+			, m_flags(flags)
+			, m_mode(mode)
+		{}
+
+	private:
+
+		friend cppcoro::detail::io_operation<file_open_operation>;
+
+		bool try_start() noexcept;
+
+		detail::safe_handle get_result()
+		{
+			return detail::safe_handle{ static_cast<int>(io_operation_base::get_result()) };
+		}
+
+		const char* m_path;
+		int m_flags;
+		mode_t m_mode;
+
+	};
+}  // namespace cppcoro
+
+#endif  // CPPCORO_OS_LINUX
+
+#endif
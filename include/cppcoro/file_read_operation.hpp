@@ -19,6 +19,8 @@
 #elif CPPCORO_OS_LINUX
 # include <cppcoro/detail/linux_io_operation.hpp>
 # include <cppcoro/io_service.hpp>
+# include <span>
+# include <sys/uio.h>
 #endif
 
 namespace cppcoro
@@ -34,6 +36,30 @@ namespace cppcoro
 			, m_byteCount(byteCount)
 		{}
 
+#if CPPCORO_OS_LINUX
+		/// \param bufferIndex
+		/// Index of the registered buffer containing \a buffer, see
+		/// registered_buffer_pool, or -1 if it isn't registered.
+		file_read_operation_impl(
+			detail::handle_t fileHandle, void* buffer, std::size_t byteCount, int bufferIndex) noexcept
+			: m_fileHandle(fileHandle)
+			, m_buffer(buffer)
+			, m_byteCount(byteCount)
+			, m_bufferIndex(bufferIndex)
+		{}
+
+		/// Read into \a buffers, filled in order, with a single
+		/// READV. The iovec array must outlive the operation.
+		file_read_operation_impl(
+			detail::handle_t fileHandle, std::span<const iovec> buffers) noexcept
+			: m_fileHandle(fileHandle)
+			, m_buffer(nullptr)
+			, m_byteCount(0)
+			, m_vecs(buffers.data())
+			, m_vecCount(buffers.size())
+		{}
+#endif
+
 		bool try_start(cppcoro::detail::io_operation_base& operation) noexcept;
 		void cancel(cppcoro::detail::io_operation_base& operation) noexcept;
 
@@ -42,6 +68,14 @@ namespace cppcoro
 		detail::handle_t m_fileHandle;
 		void* m_buffer;
 		std::size_t m_byteCount;
+#if CPPCORO_OS_LINUX
+		int m_bufferIndex = -1;
+		const iovec* m_vecs = nullptr;
+		std::size_t m_vecCount = 0;
+		// Passed to READV/WRITEV on kernels without IORING_OP_READ/WRITE,
+		// which may read it until the operation completes.
+		iovec m_vec{};
+#endif
 
 	};
 
@@ -65,6 +99,28 @@ namespace cppcoro
 			, m_impl(fileHandle, buffer, byteCount)
 		{}
 
+#if CPPCORO_OS_LINUX
+		file_read_operation(
+			io_service& ioService,
+			detail::handle_t fileHandle,
+			std::uint64_t fileOffset,
+			void* buffer,
+			std::size_t byteCount,
+			int bufferIndex) noexcept
+			: cppcoro::detail::io_operation<file_read_operation>(ioService.io_queue(), fileOffset)
+			, m_impl(fileHandle, buffer, byteCount, bufferIndex)
+		{}
+
+		file_read_operation(
+			io_service& ioService,
+			detail::handle_t fileHandle,
+			std::uint64_t fileOffset,
+			std::span<const iovec> buffers) noexcept
+			: cppcoro::detail::io_operation<file_read_operation>(ioService.io_queue(), fileOffset)
+			, m_impl(fileHandle, buffers)
+		{}
+#endif
+
 	private:
 
 		friend cppcoro::detail::io_operation<file_read_operation>;
@@ -98,6 +154,32 @@ namespace cppcoro
 			, m_impl(fileHandle, buffer, byteCount)
 		{}
 
+#if CPPCORO_OS_LINUX
+		file_read_operation_cancellable(
+			io_service& ioService,
+			detail::handle_t fileHandle,
+			std::uint64_t fileOffset,
+			void* buffer,
+			std::size_t byteCount,
+			int bufferIndex,
+			cancellation_token&& cancellationToken) noexcept
+			: cppcoro::detail::io_operation_cancellable<file_read_operation_cancellable>(
+				  ioService.io_queue(), fileOffset, std::move(cancellationToken))
+			, m_impl(fileHandle, buffer, byteCount, bufferIndex)
+		{}
+
+		file_read_operation_cancellable(
+			io_service& ioService,
+			detail::handle_t fileHandle,
+			std::uint64_t fileOffset,
+			std::span<const iovec> buffers,
+			cancellation_token&& cancellationToken) noexcept
+			: cppcoro::detail::io_operation_cancellable<file_read_operation_cancellable>(
+				  ioService.io_queue(), fileOffset, std::move(cancellationToken))
+			, m_impl(fileHandle, buffers)
+		{}
+#endif
+
 	private:
 
 		friend cppcoro::detail::io_operation_cancellable<file_read_operation_cancellable>;
@@ -0,0 +1,47 @@
+///////////////////////////////////////////////////////////////////////////////
+// Copyright (c) Lewis Baker
+// Licenced under MIT license. See LICENSE.txt for details.
+///////////////////////////////////////////////////////////////////////////////
+#ifndef CPPCORO_FILE_SIZE_OPERATION_HPP_INCLUDED
+#define CPPCORO_FILE_SIZE_OPERATION_HPP_INCLUDED
+
+#include <cppcoro/config.hpp>
+
+#if CPPCORO_OS_LINUX
+
+#include <cppcoro/detail/linux_io_operation.hpp>
+#include <cppcoro/io_service.hpp>
+
+#include <cstdint>
+#include <sys/stat.h>
+
+namespace cppcoro
+{
+	/// Gets the size of a file with IORING_OP_STATX.
+	class file_size_operation
+		: public cppcoro::detail::io_operation<file_size_operation>
+	{
+	public:
+
+		file_size_operation(io_service& ioService, detail::handle_t fileHandle) noexcept
+			: cppcoro::detail::io_operation<file_size_operation>(ioService.io_queue())
+			, m_fileHandle(fileHandle)
+		{}
+
+	private:
+
+		friend cppcoro::detail::io_operation<file_size_operation>;
+
+		bool try_start() noexcept;
+
+		std::uint64_t get_result();
+
+		detail::handle_t m_fileHandle;
+		struct statx m_statx;
+
+	};
+}  // namespace cppcoro
+
+#endif  // CPPCORO_OS_LINUX
+
+#endif
@@ -0,0 +1,68 @@
+///////////////////////////////////////////////////////////////////////////////
+// Copyright (c) Lewis Baker
+// Licenced under MIT license. See LICENSE.txt for details.
+///////////////////////////////////////////////////////////////////////////////
+#ifndef CPPCORO_FILE_SYNC_OPERATION_HPP_INCLUDED
+#define CPPCORO_FILE_SYNC_OPERATION_HPP_INCLUDED
+
+#include <cppcoro/config.hpp>
+#include <cppcoro/file_durability.hpp>
+
+#if CPPCORO_OS_LINUX
+
+#include <cppcoro/detail/linux_io_operation.hpp>
+#include <cppcoro/io_service.hpp>
+
+#include <cstdint>
+
+namespace cppcoro
+{
+	/// Flushes a writable_file, writes back part of it or changes the space
+	/// allocated to it.
+	class file_sync_operation
+		: public cppcoro::detail::io_operation<file_sync_operation>
+	{
+	public:
+
+		enum class kind
+		{
+			flush,
+			sync_range,
+			allocate,
+		};
+
+		file_sync_operation(
+			io_service& ioService,
+			detail::handle_t fileHandle,
+			kind k,
+			file_durability durability,
+			std::uint64_t offset,
+			std::uint64_t byteCount) noexcept
+			: cppcoro::detail::io_operation<file_sync_operation>(ioService.io_queue())
+			, m_fileHandle(fileHandle)
+			, m_kind(k)
+			, m_durability(durability)
+			, m_offset(offset)
+			, m_byteCount(byteCount)
+		{}
+
+	private:
+
+		friend cppcoro::detail::io_operation<file_sync_operation>;
+
+		bool try_start() noexcept;
+
+		void get_result() { io_operation_base::get_result(); }
+
+		detail::handle_t m_fileHandle;
+		kind m_kind;
+		file_durability m_durability;
+		std::uint64_t m_offset;
+		std::uint64_t m_byteCount;
+
+	};
+}  // namespace cppcoro
+
+#endif  // CPPCORO_OS_LINUX
+
+#endif
@@ -21,6 +21,8 @@
 
 #include <cppcoro/detail/linux_io_operation.hpp>
 #include <cppcoro/io_service.hpp>
+#include <span>
+#include <sys/uio.h>
 
 #endif
 
@@ -37,6 +39,30 @@ namespace cppcoro
 			, m_byteCount(byteCount)
 		{}
 
+#if CPPCORO_OS_LINUX
+		/// \param bufferIndex
+		/// Index of the registered buffer containing \a buffer, see
+		/// registered_buffer_pool, or -1 if it isn't registered.
+		file_write_operation_impl(
+			detail::handle_t fileHandle, const void* buffer, std::size_t byteCount, int bufferIndex) noexcept
+			: m_fileHandle(fileHandle)
+			, m_buffer(buffer)
+			, m_byteCount(byteCount)
+			, m_bufferIndex(bufferIndex)
+		{}
+
+		/// Write the concatenation of \a buffers with a single WRITEV. The
+		/// iovec array must outlive the operation.
+		file_write_operation_impl(
+			detail::handle_t fileHandle, std::span<const iovec> buffers) noexcept
+			: m_fileHandle(fileHandle)
+			, m_buffer(nullptr)
+			, m_byteCount(0)
+			, m_vecs(buffers.data())
+			, m_vecCount(buffers.size())
+		{}
+#endif
+
 		bool try_start(cppcoro::detail::io_operation_base& operation) noexcept;
 		void cancel(cppcoro::detail::io_operation_base& operation) noexcept;
 
@@ -44,6 +70,14 @@ namespace cppcoro
 		detail::handle_t m_fileHandle;
 		const void* m_buffer;
 		std::size_t m_byteCount;
+#if CPPCORO_OS_LINUX
+		int m_bufferIndex = -1;
+		const iovec* m_vecs = nullptr;
+		std::size_t m_vecCount = 0;
+		// Passed to READV/WRITEV on kernels without IORING_OP_READ/WRITE,
+		// which may read it until the operation completes.
+		iovec m_vec{};
+#endif
 
 	};
 
@@ -68,6 +102,28 @@ namespace cppcoro
 			, m_impl(fileHandle, buffer, byteCount)
 		{}
 
+#if CPPCORO_OS_LINUX
+		file_write_operation(
+			io_service& ioService,
+			detail::handle_t fileHandle,
+			std::uint64_t fileOffset,
+			const void* buffer,
+			std::size_t byteCount,
+			int bufferIndex) noexcept
+			: cppcoro::detail::io_operation<file_write_operation>(ioService.io_queue(), fileOffset)
+			, m_impl(fileHandle, buffer, byteCount, bufferIndex)
+		{}
+
+		file_write_operation(
+			io_service& ioService,
+			detail::handle_t fileHandle,
+			std::uint64_t fileOffset,
+			std::span<const iovec> buffers) noexcept
+			: cppcoro::detail::io_operation<file_write_operation>(ioService.io_queue(), fileOffset)
+			, m_impl(fileHandle, buffers)
+		{}
+#endif
+
 	private:
 
 		friend cppcoro::detail::io_operation<file_write_operation>;
@@ -101,6 +157,32 @@ namespace cppcoro
 			, m_impl(fileHandle, buffer, byteCount)
 		{}
 
+#if CPPCORO_OS_LINUX
+		file_write_operation_cancellable(
+			io_service& ioService,
+			detail::handle_t fileHandle,
+			std::uint64_t fileOffset,
+			const void* buffer,
+			std::size_t byteCount,
+			int bufferIndex,
+			cancellation_token&& ct) noexcept
+			: cppcoro::detail::io_operation_cancellable<file_write_operation_cancellable>(
+				  ioService.io_queue(), fileOffset, std::move(ct))
+			, m_impl(fileHandle, buffer, byteCount, bufferIndex)
+		{}
+
+		file_write_operation_cancellable(
+			io_service& ioService,
+			detail::handle_t fileHandle,
+			std::uint64_t fileOffset,
+			std::span<const iovec> buffers,
+			cancellation_token&& ct) noexcept
+			: cppcoro::detail::io_operation_cancellable<file_write_operation_cancellable>(
+				  ioService.io_queue(), fileOffset, std::move(ct))
+			, m_impl(fileHandle, buffers)
+		{}
+#endif
+
 	private:
 
 		friend cppcoro::detail::io_operation_cancellable<file_write_operation_cancellable>;
@@ -14,13 +14,18 @@
 #endif
 #if CPPCORO_OS_LINUX
 #include <cppcoro/detail/linux.hpp>
+#if CPPCORO_USE_IO_RING
 #include <cppcoro/detail/linux_uring_queue.hpp>
+#else
+#include <cppcoro/detail/linux_epoll_queue.hpp>
+#endif
 #endif
 
 #include <optional>
 #include <chrono>
 #include <cstdint>
 #include <atomic>
+#include <memory>
 #include <utility>
 #include <mutex>
 #include <cppcoro/coroutine.hpp>
@@ -157,6 +162,10 @@ namespace cppcoro
 
 		class timer_queue;
 
+#if CPPCORO_OS_LINUX
+		class timer_wheel;
+#endif
+
 		friend class schedule_operation;
 		friend class timed_schedule_operation;
 
@@ -169,6 +178,15 @@ namespace cppcoro
 
 		bool try_process_one_event(bool waitForEvent);
 
+#if CPPCORO_OS_LINUX
+		/// Reap a batch of completions with one queue lock acquisition and
+		/// dispatch them all.
+		///
+		/// \return
+		/// The number of events dispatched, or zero if the event loop should exit.
+		std::uint64_t try_process_event_batch(bool waitForEvent);
+#endif
+
 		void post_wake_up_event() noexcept;
 
 #if CPPCORO_OS_WINNT
@@ -194,6 +212,9 @@ namespace cppcoro
 #if CPPCORO_OS_LINUX
 		detail::lnx::io_queue m_uq;
 		detail::lnx::io_message m_nopMessage{};
+
+		// Timers of schedule_after() share a single kernel timeout.
+		std::unique_ptr<timer_wheel> m_timerWheel;
 #endif
 
 		// Head of a linked-list of schedule operations that are
@@ -260,6 +281,8 @@ namespace cppcoro
 
 #if CPPCORO_OS_WINNT
 		friend class io_service::timer_thread_state;
+#elif CPPCORO_OS_LINUX
+		friend class io_service::timer_wheel;
 #endif
 
 		io_service::schedule_operation m_scheduleOperation;
@@ -273,7 +296,11 @@ namespace cppcoro
 		std::atomic<std::uint32_t> m_refCount;
 
 #if CPPCORO_OS_LINUX
-        detail::lnx::io_message m_message{};
+		// Link to this timer in its slot of the timer wheel, null while the
+		// timer isn't in a slot. m_next links the slot's list.
+		timed_schedule_operation** m_prevNext = nullptr;
+		std::uint64_t m_dueTick = 0;
+		std::uint16_t m_wheelSlot = 0;
 #endif
 	};
 
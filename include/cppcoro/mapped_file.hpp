@@ -0,0 +1,109 @@
+///////////////////////////////////////////////////////////////////////////////
+// Copyright (c) Lewis Baker
+// Licenced under MIT license. See LICENSE.txt for details.
+///////////////////////////////////////////////////////////////////////////////
+#ifndef CPPCORO_MAPPED_FILE_HPP_INCLUDED
+#define CPPCORO_MAPPED_FILE_HPP_INCLUDED
+
+#include <cppcoro/config.hpp>
+
+#if CPPCORO_OS_LINUX
+
+#include <cppcoro/mapped_file_advise_operation.hpp>
+
+#include <cstddef>
+#include <cstdint>
+#include <span>
+
+namespace cppcoro
+{
+	class io_service;
+
+	/// A read-only view of a whole file mapped into memory, see
+	/// read_only_file::map().
+	///
+	/// Reading the view doesn't take a system call once its pages are
+	/// resident, but touching a page that isn't blocks the calling thread
+	/// on a page fault while it is read from storage. Ranges about to be
+	/// read can be brought in beforehand with prefetch() or populate(),
+	/// which do the work off the event loop.
+	///
+	/// The view stays valid after the file is closed. Changes made to the
+	/// file through other handles are visible through the view, and reading
+	/// past the end of a file truncated after it was mapped raises SIGBUS.
+	class mapped_file
+	{
+	public:
+
+		/// Construct an empty view, which can't be prefetched or populated
+		/// until a view is moved into it.
+		mapped_file() noexcept;
+
+		mapped_file(mapped_file&& other) noexcept;
+		mapped_file& operator=(mapped_file&& other) noexcept;
+
+		mapped_file(const mapped_file&) = delete;
+		mapped_file& operator=(const mapped_file&) = delete;
+
+		/// Unmaps the file.
+		~mapped_file();
+
+		const std::byte* data() const noexcept { return static_cast<const std::byte*>(m_address); }
+
+		/// Size of the file when it was mapped, in bytes.
+		std::size_t size() const noexcept { return m_size; }
+
+		std::span<const std::byte> bytes() const noexcept { return { data(), m_size }; }
+
+		/// Start reading the pages of \a byteCount bytes from \a offset into
+		/// memory (MADV_WILLNEED).
+		///
+		/// Completes once readahead has been started, not once the pages
+		/// are resident. The range is clamped to the end of the view.
+		[[nodiscard]]
+		mapped_file_advise_operation prefetch(
+			std::uint64_t offset, std::uint64_t byteCount) const noexcept;
+
+		/// Read the pages of \a byteCount bytes from \a offset into memory
+		/// and map them (MADV_POPULATE_READ, Linux 5.14).
+		///
+		/// Completes once the pages are resident, after which reading them
+		/// doesn't fault unless they get reclaimed. The range is clamped as
+		/// for prefetch().
+		///
+		/// \throw std::system_error
+		/// With EINVAL on kernels older than 5.14, or with EFAULT if the file
+		/// was truncated below the range after it was mapped.
+		[[nodiscard]]
+		mapped_file_advise_operation populate(
+			std::uint64_t offset, std::uint64_t byteCount) const noexcept;
+
+		/// Query whether all the pages of \a byteCount bytes from \a offset
+		/// are resident, with mincore(2). The range is clamped to the end of
+		/// the view.
+		///
+		/// A page can be reclaimed right after this returns true.
+		///
+		/// \throw std::system_error
+		/// If mincore() fails.
+		bool is_resident(std::uint64_t offset, std::uint64_t byteCount) const;
+
+	private:
+
+		friend class read_only_file;
+
+		mapped_file(io_service& ioService, void* address, std::size_t size) noexcept;
+
+		mapped_file_advise_operation advise(
+			std::uint64_t offset, std::uint64_t byteCount, int advice) const noexcept;
+
+		io_service* m_ioService;
+		void* m_address;
+		std::size_t m_size;
+
+	};
+}  // namespace cppcoro
+
+#endif  // CPPCORO_OS_LINUX
+
+#endif
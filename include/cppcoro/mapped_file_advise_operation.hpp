@@ -0,0 +1,68 @@
+///////////////////////////////////////////////////////////////////////////////
+// Copyright (c) Lewis Baker
+// Licenced under MIT license. See LICENSE.txt for details.
+///////////////////////////////////////////////////////////////////////////////
+#ifndef CPPCORO_MAPPED_FILE_ADVISE_OPERATION_HPP_INCLUDED
+#define CPPCORO_MAPPED_FILE_ADVISE_OPERATION_HPP_INCLUDED
+
+#include <cppcoro/config.hpp>
+
+#if CPPCORO_OS_LINUX
+
+#include <cppcoro/detail/linux_io_operation.hpp>
+#include <cppcoro/io_service.hpp>
+
+#include <cstdint>
+
+namespace cppcoro
+{
+	/// Gives advice about a range of a mapped_file with IORING_OP_MADVISE,
+	/// see mapped_file::prefetch() and mapped_file::populate().
+	///
+	/// IORING_OP_MADVISE takes a 32 bit length, longer ranges are advised a
+	/// chunk at a time, completing once the last chunk has or one fails.
+	class mapped_file_advise_operation
+		: public cppcoro::detail::io_operation<mapped_file_advise_operation>
+	{
+	public:
+
+		/// \a address must be page aligned.
+		mapped_file_advise_operation(
+			io_service& ioService,
+			void* address,
+			std::uint64_t length,
+			int advice) noexcept
+			: cppcoro::detail::io_operation<mapped_file_advise_operation>(ioService.io_queue())
+			, m_address(static_cast<char*>(address))
+			, m_length(length)
+			, m_advice(advice)
+		{}
+
+		bool await_suspend(cppcoro::coroutine_handle<> awaitingCoroutine) noexcept;
+
+	private:
+
+		friend cppcoro::detail::io_operation<mapped_file_advise_operation>;
+
+		/// Longest chunk advised at once, aligned to any page size.
+		static constexpr std::uint64_t max_chunk_length = std::uint64_t{ 1 } << 31;
+
+		/// Advise the remaining chunks until one completes asynchronously,
+		/// returning whether one did.
+		bool advise_remaining() noexcept;
+
+		static void on_chunk_completed(void* context) noexcept;
+
+		void get_result() { io_operation_base::get_result(); }
+
+		cppcoro::coroutine_handle<> m_awaitingCoroutine;
+		char* m_address;
+		std::uint64_t m_length;
+		int m_advice;
+
+	};
+}  // namespace cppcoro
+
+#endif  // CPPCORO_OS_LINUX
+
+#endif
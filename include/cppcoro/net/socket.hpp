@@ -18,6 +18,14 @@
 
 #include <cppcoro/cancellation_token.hpp>
 
+#if CPPCORO_OS_LINUX
+# include <cppcoro/async_generator.hpp>
+# include <cppcoro/net/socket_recv_pooled_operation.hpp>
+# include <cppcoro/net/socket_send_file_operation.hpp>
+# include <cppcoro/registered_buffer_pool.hpp>
+# include <cppcoro/task.hpp>
+#endif
+
 #if CPPCORO_OS_WINNT
 # include <cppcoro/detail/win32.hpp>
 #endif
@@ -25,6 +33,7 @@
 namespace cppcoro
 {
 	class io_service;
+	class read_only_file;
 
 	namespace net
 	{
@@ -192,6 +201,27 @@ namespace cppcoro
 				socket& acceptingSocket,
 				cancellation_token ct) noexcept;
 
+#if CPPCORO_OS_LINUX
+			/// Accept connections as they arrive, yielding a connected socket
+			/// for each.
+			///
+			/// On io_uring a single multishot accept request serves the whole
+			/// stream, re-armed whenever the kernel ends it. On older kernels,
+			/// and with epoll, connections are accepted one at a time.
+			///
+			/// The listening socket must outlive the generator. Destroying the
+			/// generator stops accepting, connections accepted but not yet
+			/// yielded are closed.
+			///
+			/// \throws std::system_error
+			/// From the generator's iterator if accepting fails.
+			async_generator<socket> accept_stream();
+
+			/// As above, completing with cppcoro::operation_cancelled once
+			/// \a ct is cancelled.
+			async_generator<socket> accept_stream(cancellation_token ct);
+#endif
+
 			[[nodiscard]]
 			socket_disconnect_operation disconnect() noexcept;
 			[[nodiscard]]
@@ -207,6 +237,80 @@ namespace cppcoro
 				std::size_t size,
 				cancellation_token ct) noexcept;
 
+#if CPPCORO_OS_LINUX
+			/// Send from the start of a slab leased from a registered_buffer_pool.
+			///
+			/// If the pool is registered the data is sent with IORING_OP_SEND_ZC
+			/// from the fixed buffer. The operation only completes once the
+			/// kernel no longer references the slab, so the lease can be reused
+			/// straight away.
+			[[nodiscard]]
+			socket_send_operation send(
+				const registered_buffer& buffer,
+				std::size_t size) noexcept;
+			[[nodiscard]]
+			socket_send_operation_cancellable send(
+				const registered_buffer& buffer,
+				std::size_t size,
+				cancellation_token ct) noexcept;
+
+			/// Send the concatenation of \a buffers, eg. a frame's header,
+			/// payload and trailer, with a single SENDMSG.
+			///
+			/// The iovec array, not only the data, must stay valid until the
+			/// operation completes.
+			[[nodiscard]]
+			socket_send_operation send(std::span<const iovec> buffers) noexcept;
+			[[nodiscard]]
+			socket_send_operation_cancellable send(
+				std::span<const iovec> buffers,
+				cancellation_token ct) noexcept;
+
+			/// Send without copying the data into the socket's buffers, using
+			/// IORING_OP_SEND_ZC.
+			///
+			/// The operation completes once the kernel no longer references
+			/// \a buffer, which may be well after the data was sent, so the
+			/// buffer can be reused straight away. Sends smaller than
+			/// socket_send_operation_impl::zero_copy_threshold, and all sends
+			/// on kernels without SEND_ZC or with epoll, copy as send() does.
+			[[nodiscard]]
+			socket_send_operation send_zero_copy(
+				const void* buffer,
+				std::size_t size) noexcept;
+			[[nodiscard]]
+			socket_send_operation_cancellable send_zero_copy(
+				const void* buffer,
+				std::size_t size,
+				cancellation_token ct) noexcept;
+
+			/// Send \a size bytes of \a file from \a offset without copying
+			/// them through user space.
+			///
+			/// On io_uring the data is moved with IORING_OP_SPLICE from the
+			/// file into a pipe created for the call, and from the pipe into
+			/// the socket, a pipe's worth at a time. With epoll, or on kernels
+			/// without SPLICE, it's sent with sendfile() whenever the socket is
+			/// writable.
+			///
+			/// As with sendfile(2), sending to a socket whose peer has closed
+			/// the connection raises SIGPIPE unless it is ignored.
+			///
+			/// \return
+			/// The number of bytes sent, less than \a size only if the end of
+			/// the file was reached.
+			///
+			/// \throw operation_cancelled
+			/// If \a ct was cancelled, after an unknown part of the data was
+			/// sent.
+			[[nodiscard]]
+			task<std::size_t> send_file(
+				read_only_file& file,
+				std::uint64_t offset,
+				std::size_t size,
+				cancellation_token ct = {});
+#endif
+
 			[[nodiscard]]
 			socket_recv_operation recv(
 				void* buffer,
@@ -217,6 +321,34 @@ namespace cppcoro
 				std::size_t size,
 				cancellation_token ct) noexcept;
 
+#if CPPCORO_OS_LINUX
+			/// Receive into \a buffers, filled in order, with a single RECVMSG.
+			///
+			/// The iovec array, not only the buffers, must stay valid until
+			/// the operation completes.
+			[[nodiscard]]
+			socket_recv_operation recv(std::span<const iovec> buffers) noexcept;
+			[[nodiscard]]
+			socket_recv_operation_cancellable recv(
+				std::span<const iovec> buffers,
+				cancellation_token ct) noexcept;
+
+			/// Receive into a buffer picked from the io_service's pool once data
+			/// arrives, so that idle connections don't hold a buffer each.
+			///
+			/// On io_uring the pool is a provided buffer ring the kernel selects
+			/// from. The pool is sized with io_queue().set_provided_buffers().
+			///
+			/// \return
+			/// A lease on the filled buffer, empty or of size 0 once the peer
+			/// has closed the connection. Fails with ENOBUFS if every buffer is
+			/// leased when data arrives.
+			[[nodiscard]]
+			socket_recv_pooled_operation recv_pooled() noexcept;
+			[[nodiscard]]
+			socket_recv_pooled_operation_cancellable recv_pooled(cancellation_token ct) noexcept;
+#endif
+
 			[[nodiscard]]
 			socket_recv_from_operation recv_from(
 				void* buffer,
@@ -248,6 +380,9 @@ namespace cppcoro
 			friend class socket_connect_operation_impl;
             friend class socket_recv_from_operation_impl;
             friend class socket_recv_operation_impl;
+#if CPPCORO_OS_LINUX
+            friend class socket_recv_pooled_operation_impl;
+#endif
             friend class socket_send_to_operation_impl;
 
 #if CPPCORO_OS_WINNT
@@ -41,6 +41,11 @@ namespace cppcoro
 
 			socket& m_socket;
 			ip_endpoint m_remoteEndPoint;
+#if CPPCORO_OS_LINUX
+			// Read by the kernel when the SQE is submitted, which may be
+			// after try_start() has returned.
+			sockaddr_storage m_remoteSockaddrStorage;
+#endif
 		};
 
 		class socket_connect_operation
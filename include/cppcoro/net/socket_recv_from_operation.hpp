@@ -50,7 +50,7 @@ namespace cppcoro::net
 		// Storage suitable for either SOCKADDR_IN or SOCKADDR_IN6
 		alignas(sockaddrStorageAlignment) std::uint8_t m_sourceSockaddrStorage[28];
 		int m_sourceSockaddrLength;
-#if CPPCORO_USE_IO_RING
+#if CPPCORO_OS_LINUX
 		iovec m_vec;
 		msghdr m_msgHdr;
 #endif
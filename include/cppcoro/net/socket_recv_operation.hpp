@@ -15,6 +15,8 @@
 # include <cppcoro/detail/win32_overlapped_operation.hpp>
 #elif CPPCORO_OS_LINUX
 # include <cppcoro/detail/linux_io_operation.hpp>
+# include <span>
+# include <sys/socket.h>
 #endif
 
 namespace cppcoro::net
@@ -33,6 +35,24 @@ namespace cppcoro::net
 			, m_buffer(buffer, byteCount)
 		{}
 
+#if CPPCORO_OS_LINUX
+		/// Receive into \a buffers, filled in order, with a single RECVMSG.
+		/// The iovec array must outlive the operation.
+		socket_recv_operation_impl(
+			socket& s,
+			std::span<const iovec> buffers) noexcept
+			: m_socket(s)
+			, m_buffer(nullptr, 0)
+			, m_vecs(buffers.data())
+			, m_vecCount(buffers.size())
+		{
+			for (const auto& vec : buffers)
+			{
+				m_buffer.size += vec.iov_len;
+			}
+		}
+#endif
+
 		bool try_start(cppcoro::detail::io_operation_base& operation) noexcept;
 		void cancel(cppcoro::detail::io_operation_base& operation) noexcept;
 
@@ -44,6 +64,14 @@ namespace cppcoro::net
 
 		socket& m_socket;
 		cppcoro::detail::sock_buf m_buffer;
+#if CPPCORO_OS_LINUX
+		const iovec* m_vecs = nullptr;
+		std::size_t m_vecCount = 0;
+		// Used for vectored receives, and with IORING_OP_RECVMSG on kernels
+		// without IORING_OP_RECV.
+		iovec m_vec;
+		msghdr m_msgHdr;
+#endif
 
 	};
 
@@ -66,6 +94,16 @@ namespace cppcoro::net
 			, m_impl(s, buffer, byteCount)
 		{}
 
+#if CPPCORO_OS_LINUX
+		socket_recv_operation(
+			detail::lnx::io_queue& ioQueue,
+			socket& s,
+			std::span<const iovec> buffers) noexcept
+			: cppcoro::detail::io_operation<socket_recv_operation>{ ioQueue }
+			, m_impl(s, buffers)
+		{}
+#endif
+
 	private:
 
 		friend cppcoro::detail::io_operation<socket_recv_operation>;
@@ -100,12 +138,28 @@ namespace cppcoro::net
 			, m_impl(s, buffer, byteCount)
 		{}
 
+#if CPPCORO_OS_LINUX
+		socket_recv_operation_cancellable(
+			detail::lnx::io_queue& ioQueue,
+			socket& s,
+			std::span<const iovec> buffers,
+			cancellation_token&& ct) noexcept
+			: cppcoro::detail::io_operation_cancellable<socket_recv_operation_cancellable>{
+				ioQueue, std::move(ct)
+			}
+			, m_impl(s, buffers)
+		{}
+#endif
+
 	private:
 
 		friend cppcoro::detail::io_operation_cancellable<socket_recv_operation_cancellable>;
 
 		bool try_start() noexcept { return m_impl.try_start(*this); }
 		void cancel() noexcept { m_impl.cancel(*this); }
+#if CPPCORO_OS_LINUX
+		std::size_t get_result() { return m_impl.get_result(*this); }
+#endif
 
 		socket_recv_operation_impl m_impl;
 
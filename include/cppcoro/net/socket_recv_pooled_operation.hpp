@@ -0,0 +1,168 @@
+///////////////////////////////////////////////////////////////////////////////
+// Copyright (c) Lewis Baker
+// Licenced under MIT license. See LICENSE.txt for details.
+///////////////////////////////////////////////////////////////////////////////
+#ifndef CPPCORO_NET_SOCKET_RECV_POOLED_OPERATION_HPP_INCLUDED
+#define CPPCORO_NET_SOCKET_RECV_POOLED_OPERATION_HPP_INCLUDED
+
+#include <cppcoro/config.hpp>
+#include <cppcoro/cancellation_token.hpp>
+
+#include <cstddef>
+#include <utility>
+
+#include <cppcoro/detail/linux_io_operation.hpp>
+
+namespace cppcoro::net
+{
+	class socket;
+	class socket_recv_pooled_operation_impl;
+
+	/// Lease on the buffer filled by socket::recv_pooled().
+	///
+	/// The buffer goes back to the io_service's pool when the lease is
+	/// destroyed or reset().
+	class pooled_buffer
+	{
+	public:
+
+		/// Construct an empty lease.
+		pooled_buffer() noexcept
+			: m_queue(nullptr)
+			, m_id(-1)
+			, m_size(0)
+		{}
+
+		pooled_buffer(pooled_buffer&& other) noexcept
+			: m_queue(other.m_queue)
+			, m_id(std::exchange(other.m_id, -1))
+			, m_size(std::exchange(other.m_size, 0))
+		{}
+
+		~pooled_buffer() { reset(); }
+
+		pooled_buffer& operator=(pooled_buffer&& other) noexcept
+		{
+			if (this != &other)
+			{
+				reset();
+				m_queue = other.m_queue;
+				m_id = std::exchange(other.m_id, -1);
+				m_size = std::exchange(other.m_size, 0);
+			}
+			return *this;
+		}
+
+		pooled_buffer(const pooled_buffer&) = delete;
+		pooled_buffer& operator=(const pooled_buffer&) = delete;
+
+		explicit operator bool() const noexcept { return m_id >= 0; }
+
+		/// The received data, nullptr for an empty lease.
+		const std::byte* data() const noexcept;
+
+		/// Number of bytes received, 0 once the peer has closed the
+		/// connection.
+		std::size_t size() const noexcept { return m_size; }
+
+		/// Return the buffer to the pool, leaving the lease empty.
+		void reset() noexcept;
+
+	private:
+
+		friend class socket_recv_pooled_operation_impl;
+
+		pooled_buffer(detail::lnx::io_queue& queue, int id, std::size_t size) noexcept
+			: m_queue(&queue)
+			, m_id(id)
+			, m_size(size)
+		{}
+
+		detail::lnx::io_queue* m_queue;
+		int m_id;
+		std::size_t m_size;
+
+	};
+
+	class socket_recv_pooled_operation_impl
+	{
+	public:
+
+		explicit socket_recv_pooled_operation_impl(socket& s) noexcept
+			: m_socket(s)
+		{}
+
+		bool try_start(cppcoro::detail::io_operation_base& operation) noexcept;
+		void cancel(cppcoro::detail::io_operation_base& operation) noexcept;
+		pooled_buffer get_result(cppcoro::detail::io_operation_base& operation);
+
+		/// Return a buffer the operation received into but that wasn't
+		/// handed out, eg. because the operation was cancelled.
+		void discard(cppcoro::detail::io_operation_base& operation) noexcept;
+
+	private:
+
+		socket& m_socket;
+#if CPPCORO_USE_IO_RING
+		// Polled for readiness as there is no buffer ring, get_result()
+		// receives into a buffer taken in user space.
+		bool m_polled = false;
+#endif
+
+	};
+
+	class socket_recv_pooled_operation
+		: public cppcoro::detail::io_operation<socket_recv_pooled_operation>
+	{
+	public:
+
+		socket_recv_pooled_operation(detail::lnx::io_queue& ioQueue, socket& s) noexcept
+			: cppcoro::detail::io_operation<socket_recv_pooled_operation>{ ioQueue }
+			, m_impl(s)
+		{}
+
+		~socket_recv_pooled_operation() { m_impl.discard(*this); }
+
+	private:
+
+		friend cppcoro::detail::io_operation<socket_recv_pooled_operation>;
+
+		bool try_start() noexcept { return m_impl.try_start(*this); }
+		pooled_buffer get_result() { return m_impl.get_result(*this); }
+
+		socket_recv_pooled_operation_impl m_impl;
+
+	};
+
+	class socket_recv_pooled_operation_cancellable
+		: public cppcoro::detail::io_operation_cancellable<socket_recv_pooled_operation_cancellable>
+	{
+	public:
+
+		socket_recv_pooled_operation_cancellable(
+			detail::lnx::io_queue& ioQueue,
+			socket& s,
+			cancellation_token&& ct) noexcept
+			: cppcoro::detail::io_operation_cancellable<socket_recv_pooled_operation_cancellable>{
+				ioQueue, std::move(ct)
+			}
+			, m_impl(s)
+		{}
+
+		~socket_recv_pooled_operation_cancellable() { m_impl.discard(*this); }
+
+	private:
+
+		friend cppcoro::detail::io_operation_cancellable<socket_recv_pooled_operation_cancellable>;
+
+		bool try_start() noexcept { return m_impl.try_start(*this); }
+		void cancel() noexcept { m_impl.cancel(*this); }
+		pooled_buffer get_result() { return m_impl.get_result(*this); }
+
+		socket_recv_pooled_operation_impl m_impl;
+
+	};
+
+}  // namespace cppcoro::net
+
+#endif
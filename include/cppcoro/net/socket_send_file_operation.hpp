@@ -0,0 +1,128 @@
+///////////////////////////////////////////////////////////////////////////////
+// Copyright (c) Lewis Baker
+// Licenced under MIT license. See LICENSE.txt for details.
+///////////////////////////////////////////////////////////////////////////////
+#ifndef CPPCORO_NET_SOCKET_SEND_FILE_OPERATION_HPP_INCLUDED
+#define CPPCORO_NET_SOCKET_SEND_FILE_OPERATION_HPP_INCLUDED
+
+#include <cppcoro/config.hpp>
+#include <cppcoro/cancellation_token.hpp>
+
+#if CPPCORO_OS_LINUX
+
+#include <cppcoro/detail/linux_io_operation.hpp>
+
+#include <cstdint>
+
+namespace cppcoro::net
+{
+	/// One kernel-side transfer of socket::send_file(): a splice between
+	/// the file, a pipe and the socket, or a sendfile() from the file to the
+	/// socket.
+	class socket_send_file_operation_impl
+	{
+	public:
+
+		enum class kind
+		{
+			/// IORING_OP_SPLICE from fdIn at offsetIn, or from a pipe if
+			/// offsetIn is -1, into the pipe or socket fdOut.
+			splice,
+
+			/// sendfile() from the file fdIn at offsetIn to the socket fdOut.
+			///
+			/// On io_uring, where sockets block, the operation waits for the
+			/// socket to be writable and get_result() only sends what fits in
+			/// its send buffer.
+			sendfile,
+		};
+
+		socket_send_file_operation_impl(
+			kind k,
+			int fdIn,
+			std::int64_t offsetIn,
+			int fdOut,
+			std::size_t byteCount) noexcept
+			: m_kind(k)
+			, m_fdIn(fdIn)
+			, m_offsetIn(offsetIn)
+			, m_fdOut(fdOut)
+			, m_byteCount(byteCount)
+		{}
+
+		bool try_start(cppcoro::detail::io_operation_base& operation) noexcept;
+		void cancel(cppcoro::detail::io_operation_base& operation) noexcept;
+		std::size_t get_result(cppcoro::detail::io_operation_base& operation);
+
+	private:
+
+		kind m_kind;
+		int m_fdIn;
+		std::int64_t m_offsetIn;
+		int m_fdOut;
+		std::size_t m_byteCount;
+
+	};
+
+	class socket_send_file_operation
+		: public cppcoro::detail::io_operation<socket_send_file_operation>
+	{
+	public:
+
+		socket_send_file_operation(
+			detail::lnx::io_queue& ioQueue,
+			socket_send_file_operation_impl::kind k,
+			int fdIn,
+			std::int64_t offsetIn,
+			int fdOut,
+			std::size_t byteCount) noexcept
+			: cppcoro::detail::io_operation<socket_send_file_operation>{ ioQueue }
+			, m_impl(k, fdIn, offsetIn, fdOut, byteCount)
+		{}
+
+	private:
+
+		friend cppcoro::detail::io_operation<socket_send_file_operation>;
+
+		bool try_start() noexcept { return m_impl.try_start(*this); }
+		std::size_t get_result() { return m_impl.get_result(*this); }
+
+		socket_send_file_operation_impl m_impl;
+
+	};
+
+	class socket_send_file_operation_cancellable
+		: public cppcoro::detail::io_operation_cancellable<socket_send_file_operation_cancellable>
+	{
+	public:
+
+		socket_send_file_operation_cancellable(
+			detail::lnx::io_queue& ioQueue,
+			socket_send_file_operation_impl::kind k,
+			int fdIn,
+			std::int64_t offsetIn,
+			int fdOut,
+			std::size_t byteCount,
+			cancellation_token&& ct) noexcept
+			: cppcoro::detail::io_operation_cancellable<socket_send_file_operation_cancellable>{
+				ioQueue, std::move(ct)
+			}
+			, m_impl(k, fdIn, offsetIn, fdOut, byteCount)
+		{}
+
+	private:
+
+		friend cppcoro::detail::io_operation_cancellable<socket_send_file_operation_cancellable>;
+
+		bool try_start() noexcept { return m_impl.try_start(*this); }
+		void cancel() noexcept { m_impl.cancel(*this); }
+		std::size_t get_result() { return m_impl.get_result(*this); }
+
+		socket_send_file_operation_impl m_impl;
+
+	};
+}  // namespace cppcoro::net
+
+#endif  // CPPCORO_OS_LINUX
+
+#endif
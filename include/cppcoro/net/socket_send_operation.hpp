@@ -15,6 +15,8 @@
 # include <cppcoro/detail/win32_overlapped_operation.hpp>
 #elif CPPCORO_OS_LINUX
 # include <cppcoro/detail/linux_io_operation.hpp>
+# include <span>
+# include <sys/socket.h>
 #endif
 
 namespace cppcoro::net
@@ -33,13 +35,62 @@ namespace cppcoro::net
 			, m_buffer(const_cast<void*>(buffer), byteCount)
 		{}
 
+#if CPPCORO_OS_LINUX
+		/// Sends below this size are copied even when zero copy is asked for,
+		/// pinning the pages and waiting for the notification costs more
+		/// than the copy.
+		static constexpr std::size_t zero_copy_threshold = 16 * 1024;
+
+		/// Send with IORING_OP_SEND_ZC, completing once the kernel is done
+		/// with \a buffer.
+		///
+		/// \param bufferIndex
+		/// Index of the registered buffer containing \a buffer, see
+		/// registered_buffer_pool, or -1. Sends from registered buffers skip
+		/// zero_copy_threshold as their pages are already pinned.
+		socket_send_operation_impl(
+			socket& s,
+			const void* buffer,
+			std::size_t byteCount,
+			int bufferIndex) noexcept
+			: m_socket(s)
+			, m_buffer(const_cast<void*>(buffer), byteCount)
+			, m_bufferIndex(bufferIndex)
+			, m_zeroCopy(true)
+		{}
+
+		/// Send the concatenation of \a buffers with a single SENDMSG. The
+		/// iovec array must outlive the operation.
+		socket_send_operation_impl(
+			socket& s,
+			std::span<const iovec> buffers) noexcept
+			: m_socket(s)
+			, m_buffer(nullptr, 0)
+			, m_vecs(buffers.data())
+			, m_vecCount(buffers.size())
+		{}
+#endif
+
 		bool try_start(cppcoro::detail::io_operation_base& operation) noexcept;
 		void cancel(cppcoro::detail::io_operation_base& operation) noexcept;
+#if CPPCORO_OS_LINUX
+		std::size_t get_result(cppcoro::detail::io_operation_base& operation);
+#endif
 
 	private:
 
 		socket& m_socket;
 		cppcoro::detail::sock_buf m_buffer;
+#if CPPCORO_OS_LINUX
+		int m_bufferIndex = -1;
+		bool m_zeroCopy = false;
+		const iovec* m_vecs = nullptr;
+		std::size_t m_vecCount = 0;
+		// Used for vectored sends, and with IORING_OP_SENDMSG on kernels
+		// without IORING_OP_SEND.
+		iovec m_vec;
+		msghdr m_msgHdr;
+#endif
 
 	};
 
@@ -63,11 +114,34 @@ namespace cppcoro::net
 			, m_impl(s, buffer, byteCount)
 		{}
 
+#if CPPCORO_OS_LINUX
+		socket_send_operation(
+			detail::lnx::io_queue& ioQueue,
+			socket& s,
+			const void* buffer,
+			std::size_t byteCount,
+			int bufferIndex) noexcept
+			: cppcoro::detail::io_operation<socket_send_operation>{ ioQueue }
+			, m_impl(s, buffer, byteCount, bufferIndex)
+		{}
+
+		socket_send_operation(
+			detail::lnx::io_queue& ioQueue,
+			socket& s,
+			std::span<const iovec> buffers) noexcept
+			: cppcoro::detail::io_operation<socket_send_operation>{ ioQueue }
+			, m_impl(s, buffers)
+		{}
+#endif
+
 	private:
 
 		friend cppcoro::detail::io_operation<socket_send_operation>;
 
 		bool try_start() noexcept { return m_impl.try_start(*this); }
+#if CPPCORO_OS_LINUX
+		std::size_t get_result() { return m_impl.get_result(*this); }
+#endif
 
 		socket_send_operation_impl m_impl;
 
@@ -95,12 +169,41 @@ namespace cppcoro::net
 			, m_impl(s, buffer, byteCount)
 		{}
 
+#if CPPCORO_OS_LINUX
+		socket_send_operation_cancellable(
+			detail::lnx::io_queue& ioQueue,
+			socket& s,
+			const void* buffer,
+			std::size_t byteCount,
+			int bufferIndex,
+			cancellation_token&& ct) noexcept
+			: cppcoro::detail::io_operation_cancellable<socket_send_operation_cancellable>{
+				ioQueue, std::move(ct)
+			}
+			, m_impl(s, buffer, byteCount, bufferIndex)
+		{}
+
+		socket_send_operation_cancellable(
+			detail::lnx::io_queue& ioQueue,
+			socket& s,
+			std::span<const iovec> buffers,
+			cancellation_token&& ct) noexcept
+			: cppcoro::detail::io_operation_cancellable<socket_send_operation_cancellable>{
+				ioQueue, std::move(ct)
+			}
+			, m_impl(s, buffers)
+		{}
+#endif
+
 	private:
 
 		friend cppcoro::detail::io_operation_cancellable<socket_send_operation_cancellable>;
 
 		bool try_start() noexcept { return m_impl.try_start(*this); }
 		void cancel() noexcept { return m_impl.cancel(*this); }
+#if CPPCORO_OS_LINUX
+		std::size_t get_result() { return m_impl.get_result(*this); }
+#endif
 
 		socket_send_operation_impl m_impl;
 
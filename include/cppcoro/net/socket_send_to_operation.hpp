@@ -39,13 +39,16 @@ namespace cppcoro::net
 
 		bool try_start(cppcoro::detail::io_operation_base& operation) noexcept;
 		void cancel(cppcoro::detail::io_operation_base& operation) noexcept;
+#if CPPCORO_OS_LINUX
+		std::size_t get_result(cppcoro::detail::io_operation_base& operation);
+#endif
 
 	private:
 
 		socket& m_socket;
 		ip_endpoint m_destination;
 		cppcoro::detail::sock_buf m_buffer;
-#if CPPCORO_USE_IO_RING
+#if CPPCORO_OS_LINUX
         sockaddr_storage m_destinationStorage;
         iovec m_vec;
         msghdr m_msgHdr;
@@ -77,6 +80,9 @@ namespace cppcoro::net
 		friend cppcoro::detail::io_operation<socket_send_to_operation>;
 
 		bool try_start() noexcept { return m_impl.try_start(*this); }
+#if CPPCORO_OS_LINUX
+		std::size_t get_result() { return m_impl.get_result(*this); }
+#endif
 
 		socket_send_to_operation_impl m_impl;
 
@@ -112,6 +118,9 @@ namespace cppcoro::net
 
 		bool try_start() noexcept { return m_impl.try_start(*this); }
 		void cancel() noexcept { return m_impl.cancel(*this); }
+#if CPPCORO_OS_LINUX
+		std::size_t get_result() { return m_impl.get_result(*this); }
+#endif
 
 		socket_send_to_operation_impl m_impl;
 
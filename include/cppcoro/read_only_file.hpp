@@ -11,6 +11,10 @@
 
 #include <cppcoro/filesystem.hpp>
 
+#if CPPCORO_OS_LINUX
+# include <cppcoro/mapped_file.hpp>
+#endif
+
 namespace cppcoro
 {
 	class read_only_file : public readable_file
@@ -47,6 +51,28 @@ namespace cppcoro
 			file_share_mode shareMode = file_share_mode::read,
 			file_buffering_mode bufferingMode = file_buffering_mode::default_);
 
+#if CPPCORO_OS_LINUX
+		/// Like open() but opens the file with IORING_OP_OPENAT, without
+		/// blocking the calling thread.
+		[[nodiscard]]
+		static task<read_only_file> open_async(
+			io_service& ioService,
+			cppcoro::filesystem::path path,
+			file_share_mode shareMode = file_share_mode::read,
+			file_buffering_mode bufferingMode = file_buffering_mode::default_);
+
+		/// Map the whole file into memory, read-only and shared with other
+		/// mappings of the file.
+		///
+		/// \return
+		/// A view of the file, which stays valid after the file is closed.
+		///
+		/// \throw std::system_error
+		/// If the file could not be mapped.
+		[[nodiscard]]
+		mapped_file map() const;
+#endif
+
 	protected:
 
 		read_only_file(detail::safe_handle&& fileHandle) noexcept;
@@ -54,6 +54,18 @@ namespace cppcoro
 			file_share_mode shareMode = file_share_mode::none,
 			file_buffering_mode bufferingMode = file_buffering_mode::default_);
 
+#if CPPCORO_OS_LINUX
+		/// Like open() but opens the file with IORING_OP_OPENAT, without
+		/// blocking the calling thread.
+		[[nodiscard]]
+		static task<read_write_file> open_async(
+			io_service& ioService,
+			cppcoro::filesystem::path path,
+			file_open_mode openMode = file_open_mode::create_or_open,
+			file_share_mode shareMode = file_share_mode::none,
+			file_buffering_mode bufferingMode = file_buffering_mode::default_);
+#endif
+
 	protected:
 		read_write_file(detail::safe_handle&& fileHandle) noexcept;
 	};
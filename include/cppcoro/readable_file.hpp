@@ -9,6 +9,10 @@
 #include <cppcoro/file_read_operation.hpp>
 #include <cppcoro/cancellation_token.hpp>
 
+#if CPPCORO_OS_LINUX
+# include <cppcoro/registered_buffer_pool.hpp>
+#endif
+
 namespace cppcoro
 {
 	class readable_file : virtual public file
@@ -55,6 +59,39 @@ namespace cppcoro
 			std::size_t byteCount,
 			cancellation_token ct) const noexcept;
 
+#if CPPCORO_OS_LINUX
+		/// Read into the start of a slab leased from a registered_buffer_pool,
+		/// using IORING_OP_READ_FIXED if the pool is registered.
+		///
+		/// \param byteCount
+		/// The number of bytes to read, at most \a buffer.size().
+		[[nodiscard]]
+		file_read_operation read(
+			std::uint64_t offset,
+			const registered_buffer& buffer,
+			std::size_t byteCount) const noexcept;
+		[[nodiscard]]
+		file_read_operation_cancellable read(
+			std::uint64_t offset,
+			const registered_buffer& buffer,
+			std::size_t byteCount,
+			cancellation_token ct) const noexcept;
+
+		/// Read into \a buffers, filled in order, with a single operation.
+		///
+		/// The iovec array, not only the buffers, must stay valid until the
+		/// operation completes.
+		[[nodiscard]]
+		file_read_operation read(
+			std::uint64_t offset,
+			std::span<const iovec> buffers) const noexcept;
+		[[nodiscard]]
+		file_read_operation_cancellable read(
+			std::uint64_t offset,
+			std::span<const iovec> buffers,
+			cancellation_token ct) const noexcept;
+#endif
+
 	protected:
 
 		using file::file;
@@ -0,0 +1,187 @@
+///////////////////////////////////////////////////////////////////////////////
+// Copyright (c) Lewis Baker
+// Licenced under MIT license. See LICENSE.txt for details.
+///////////////////////////////////////////////////////////////////////////////
+#ifndef CPPCORO_REGISTERED_BUFFER_POOL_HPP_INCLUDED
+#define CPPCORO_REGISTERED_BUFFER_POOL_HPP_INCLUDED
+
+#include <cppcoro/config.hpp>
+
+#include <cstddef>
+#include <cstdint>
+#include <mutex>
+#include <vector>
+
+namespace cppcoro
+{
+	class io_service;
+	class registered_buffer_pool;
+
+	/// A slab leased from a registered_buffer_pool.
+	///
+	/// The slab is returned to the pool when the lease is destroyed or
+	/// reset(). Operations started on the slab must have completed by then.
+	class registered_buffer
+	{
+	public:
+
+		/// Construct an empty lease.
+		registered_buffer() noexcept
+			: m_pool(nullptr)
+			, m_slab(0)
+		{}
+
+		registered_buffer(registered_buffer&& other) noexcept
+			: m_pool(other.m_pool)
+			, m_slab(other.m_slab)
+		{
+			other.m_pool = nullptr;
+		}
+
+		~registered_buffer() { reset(); }
+
+		registered_buffer& operator=(registered_buffer&& other) noexcept
+		{
+			if (this != &other)
+			{
+				reset();
+				m_pool = other.m_pool;
+				m_slab = other.m_slab;
+				other.m_pool = nullptr;
+			}
+			return *this;
+		}
+
+		registered_buffer(const registered_buffer&) = delete;
+		registered_buffer& operator=(const registered_buffer&) = delete;
+
+		explicit operator bool() const noexcept { return m_pool != nullptr; }
+
+		/// Start of the slab, nullptr for an empty lease.
+		void* data() const noexcept;
+
+		/// Size of the slab in bytes, 0 for an empty lease.
+		std::size_t size() const noexcept;
+
+		/// Index of the slab in the io_service's registered buffer table,
+		/// or -1 if the slab isn't registered with the kernel.
+		int buffer_index() const noexcept;
+
+		/// Return the slab to its pool, leaving the lease empty.
+		void reset() noexcept;
+
+	private:
+
+		friend class registered_buffer_pool;
+
+		registered_buffer(registered_buffer_pool* pool, std::uint32_t slab) noexcept
+			: m_pool(pool)
+			, m_slab(slab)
+		{}
+
+		registered_buffer_pool* m_pool;
+		std::uint32_t m_slab;
+
+	};
+
+	/// A pool of equally sized buffers registered with an io_service.
+	///
+	/// Reads and writes of files on leased buffers go out as
+	/// IORING_OP_READ_FIXED / IORING_OP_WRITE_FIXED and socket sends as
+	/// IORING_OP_SEND_ZC with a fixed buffer, saving the kernel pinning the
+	/// user pages on every operation.
+	///
+	/// Only one pool can be registered per io_service at a time. If the
+	/// buffers can't be registered, eg. because another pool already is, it
+	/// exceeds RLIMIT_MEMLOCK or the io_service doesn't use io_uring, the
+	/// pool still hands out buffers but operations on them are plain reads
+	/// and writes.
+	///
+	/// Slabs are allocated contiguously from page aligned memory, so with a
+	/// slab size that is a multiple of the page size each slab is page
+	/// aligned.
+	class registered_buffer_pool
+	{
+	public:
+
+		/// Allocate \a slabCount slabs of \a slabSize bytes and register them
+		/// with \a ioService.
+		///
+		/// Registration may have to wait for outstanding operations on
+		/// kernels before 5.13, so create the pool before starting any
+		/// long-running operation.
+		///
+		/// \throw std::system_error
+		/// If the memory could not be allocated.
+		registered_buffer_pool(
+			io_service& ioService,
+			std::size_t slabSize,
+			std::uint32_t slabCount);
+
+		/// Unregister and free the buffers.
+		///
+		/// All leases must have been returned.
+		~registered_buffer_pool();
+
+		registered_buffer_pool(const registered_buffer_pool&) = delete;
+		registered_buffer_pool& operator=(const registered_buffer_pool&) = delete;
+
+		/// Lease a slab from the pool.
+		///
+		/// \return
+		/// The lease, or an empty lease if all slabs are in use.
+		registered_buffer try_lease() noexcept;
+
+		std::size_t slab_size() const noexcept { return m_slabSize; }
+
+		std::uint32_t slab_count() const noexcept { return m_slabCount; }
+
+		/// Number of slabs currently not leased.
+		std::uint32_t available() const noexcept;
+
+		/// Whether the slabs are registered with the kernel.
+		bool is_registered() const noexcept { return m_registered; }
+
+	private:
+
+		friend class registered_buffer;
+
+		void release(std::uint32_t slab) noexcept;
+
+		io_service& m_ioService;
+		const std::size_t m_slabSize;
+		const std::uint32_t m_slabCount;
+		std::byte* m_memory;
+		bool m_registered;
+
+		mutable std::mutex m_mutex;
+		std::vector<std::uint32_t> m_freeSlabs;
+
+	};
+
+	inline void* registered_buffer::data() const noexcept
+	{
+		return m_pool != nullptr ? m_pool->m_memory + m_slab * m_pool->m_slabSize : nullptr;
+	}
+
+	inline std::size_t registered_buffer::size() const noexcept
+	{
+		return m_pool != nullptr ? m_pool->m_slabSize : 0;
+	}
+
+	inline int registered_buffer::buffer_index() const noexcept
+	{
+		return m_pool != nullptr && m_pool->m_registered ? static_cast<int>(m_slab) : -1;
+	}
+
+	inline void registered_buffer::reset() noexcept
+	{
+		if (m_pool != nullptr)
+		{
+			m_pool->release(m_slab);
+			m_pool = nullptr;
+		}
+	}
+}
+
+#endif
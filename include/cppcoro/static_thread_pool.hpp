@@ -6,6 +6,7 @@
 #define CPPCORO_STATIC_THREAD_POOL_HPP_INCLUDED
 
 #include <atomic>
+#include <chrono>
 #include <cstdint>
 #include <memory>
 #include <thread>
@@ -19,6 +20,46 @@ namespace cppcoro
 	{
 	public:
 
+		/// How a thread that runs out of work waits for more.
+		enum class idle_policy
+		{
+			/// Park straight away. Idle threads use no CPU but each new
+			/// piece of work pays the latency of waking a thread up.
+			park,
+
+			/// Spin for a fixed time looking for work, then park.
+			spin,
+
+			/// Spin for up to twice the recent average time between a
+			/// thread running out of work and finding more, then park.
+			/// Threads that are idle for longer than the spin time allows
+			/// park straight away.
+			adaptive,
+		};
+
+		static constexpr std::chrono::nanoseconds default_spin_duration = std::chrono::microseconds{ 50 };
+
+		/// Counters of what idle threads did, summed over the threads.
+		struct idle_stats
+		{
+			/// Times a thread found work while spinning.
+			std::uint64_t spin_successes = 0;
+
+			/// Time spent spinning.
+			std::chrono::nanoseconds spin_time{ 0 };
+
+			/// Times a thread parked.
+			std::uint64_t parks = 0;
+
+			/// Times a parked thread was woken up by another thread.
+			std::uint64_t wake_ups = 0;
+
+			/// Time from a thread being asked to wake up to it running,
+			/// summed over wake_ups and the largest of them.
+			std::chrono::nanoseconds total_wake_latency{ 0 };
+			std::chrono::nanoseconds max_wake_latency{ 0 };
+		};
+
 		/// Initialise to a number of threads equal to the number of cores
 		/// on the current machine.
 		static_thread_pool();
@@ -29,14 +70,38 @@ namespace cppcoro
 		/// The number of threads in the pool that will be used to execute work.
 		explicit static_thread_pool(std::uint32_t threadCount);
 
+		/// Construct a thread pool with the specified number of threads, each
+		/// pinned to a CPU of a cpuset.
+		///
+		/// Thread i is pinned to cpus[i % cpus.size()], none are pinned if
+		/// \a cpus is empty. Pinning is only supported on Linux.
+		///
+		/// Threads are grouped by the NUMA node of their CPU, as read from
+		/// /sys/devices/system/node, and steal work from the other threads of
+		/// their node before those of other nodes. Threads that aren't
+		/// pinned all belong to node 0.
+		///
+		/// \throw std::system_error
+		/// If a thread can't be pinned to its CPU.
+		static_thread_pool(std::uint32_t threadCount, std::vector<std::uint32_t> cpus);
+
 		~static_thread_pool();
 
+		/// The CPUs of NUMA node \a node, empty if there is no such node or
+		/// the topology isn't known.
+		static std::vector<std::uint32_t> numa_node_cpus(std::uint32_t node);
+
 		class schedule_operation
 		{
 		public:
 
 			schedule_operation(static_thread_pool* tp) noexcept : m_threadPool(tp) {}
 
+			schedule_operation(static_thread_pool* tp, std::uint32_t nodeIndex) noexcept
+				: m_threadPool(tp)
+				, m_nodeIndex(nodeIndex)
+			{}
+
 			bool await_ready() noexcept { return false; }
 			void await_suspend(cppcoro::coroutine_handle<> awaitingCoroutine) noexcept;
 			void await_resume() noexcept {}
@@ -49,17 +114,109 @@ namespace cppcoro
 			cppcoro::coroutine_handle<> m_awaitingCoroutine;
 			schedule_operation* m_next;
 
+			// Index in m_nodes of the node to run on, or any_node.
+			std::uint32_t m_nodeIndex = any_node;
+
+		};
+
+		/// Schedules a fixed number of coroutines onto the thread pool together.
+		///
+		/// Each of the coroutines co_awaits the operation once. Once the last
+		/// of them has suspended they are all queued in a single pass and up
+		/// to one sleeping thread per coroutine is woken up.
+		class bulk_schedule_operation
+		{
+		public:
+
+			bulk_schedule_operation(static_thread_pool* tp, std::uint32_t count);
+
+			bulk_schedule_operation(const bulk_schedule_operation&) = delete;
+			bulk_schedule_operation& operator=(const bulk_schedule_operation&) = delete;
+
+			std::uint32_t size() const noexcept { return static_cast<std::uint32_t>(m_operations.size()); }
+
+			class awaiter
+			{
+			public:
+
+				explicit awaiter(bulk_schedule_operation& operation) noexcept
+					: m_operation(operation)
+				{}
+
+				bool await_ready() noexcept { return false; }
+				void await_suspend(cppcoro::coroutine_handle<> awaitingCoroutine) noexcept;
+				void await_resume() noexcept {}
+
+			private:
+
+				bulk_schedule_operation& m_operation;
+
+			};
+
+			/// Must be awaited exactly size() times.
+			awaiter operator co_await() noexcept { return awaiter{ *this }; }
+
+		private:
+
+			static_thread_pool* m_threadPool;
+			std::vector<schedule_operation> m_operations;
+			std::atomic<std::uint32_t> m_claimedCount;
+			std::atomic<std::uint32_t> m_suspendedCount;
+
 		};
 
 		std::uint32_t thread_count() const noexcept { return m_threadCount; }
 
+		/// Set how threads that run out of work wait for more, from the
+		/// next time they do.
+		///
+		/// \param spinDuration
+		/// How long to spin for with idle_policy::spin, the longest with
+		/// idle_policy::adaptive. Ignored with idle_policy::park.
+		///
+		/// Threads spin for default_spin_duration by default.
+		void set_idle_policy(
+			idle_policy policy,
+			std::chrono::nanoseconds spinDuration = default_spin_duration) noexcept;
+
+		/// What idle threads have done since the pool was created.
+		idle_stats stats() const noexcept;
+
 		[[nodiscard]]
 		schedule_operation schedule() noexcept { return schedule_operation{ this }; }
 
+		/// Returns an operation that resumes the awaiting coroutine on a
+		/// thread of NUMA node \a node, see static_thread_pool(threadCount, cpus).
+		///
+		/// Behaves like schedule() if no thread of the pool is on that node.
+		[[nodiscard]]
+		schedule_operation schedule_on_node(std::uint32_t node) noexcept;
+
+		/// The NUMA node of the calling thread as grouped by the pool, see
+		/// schedule_on_node(), or -1 if the caller isn't one of the pool's
+		/// threads or its node isn't known.
+		///
+		/// Threads that aren't pinned to a CPU count as node 0 when none of
+		/// the pool's threads are.
+		std::uint32_t current_node() const noexcept;
+
+		/// Returns an operation that \a count coroutines each co_await to be
+		/// resumed on the thread pool, queued together.
+		///
+		/// Cheaper than each of them awaiting schedule() when fanning out
+		/// many coroutines at once, see when_all_on().
+		[[nodiscard]]
+		bulk_schedule_operation schedule_bulk(std::uint32_t count)
+		{
+			return bulk_schedule_operation{ this, count };
+		}
+
 	private:
 
 		friend class schedule_operation;
 
+		static constexpr std::uint32_t any_node = static_cast<std::uint32_t>(-1);
+
 		void run_worker_thread(std::uint32_t threadIndex) noexcept;
 
 		void shutdown();
@@ -68,6 +225,15 @@ namespace cppcoro
 
 		void remote_enqueue(schedule_operation* operation) noexcept;
 
+		/// Queue \a count operations with their coroutines set, then wake up
+		/// as many sleeping threads as there are operations.
+		void schedule_bulk_impl(schedule_operation* operations, std::uint32_t count) noexcept;
+
+		/// Push the operations linked through m_next from \a newest down to
+		/// \a oldest onto the global queue at once. They are dequeued oldest
+		/// first.
+		void remote_enqueue(schedule_operation* newest, schedule_operation* oldest) noexcept;
+
 		bool has_any_queued_work_for(std::uint32_t threadIndex) noexcept;
 
 		bool approx_has_any_queued_work_for(std::uint32_t threadIndex) const noexcept;
@@ -77,7 +243,16 @@ namespace cppcoro
 		void notify_intent_to_sleep(std::uint32_t threadIndex) noexcept;
 		void try_clear_intent_to_sleep(std::uint32_t threadIndex) noexcept;
 
-		schedule_operation* try_global_dequeue() noexcept;
+		class injection_queue;
+
+		/// Take every operation from \a queue, returning the oldest and
+		/// moving the others to this thread's local queue.
+		schedule_operation* try_dequeue(injection_queue& queue) noexcept;
+
+		/// Take the oldest operation scheduled on node \a nodeIndex. Unlike
+		/// try_dequeue(), leaves the others where only threads of the node
+		/// take them from.
+		schedule_operation* try_node_dequeue(std::uint32_t nodeIndex) noexcept;
 
 		/// Try to steal a task from another thread.
 		///
@@ -89,7 +264,12 @@ namespace cppcoro
 
 		void wake_one_thread() noexcept;
 
+		/// Wake up to \a count sleeping threads, preferably threads of node
+		/// \a nodeIndex.
+		void wake_threads(std::uint32_t count, std::uint32_t nodeIndex = any_node) noexcept;
+
 		class thread_state;
+		class node_state;
 
 		static thread_local thread_state* s_currentState;
 		static thread_local static_thread_pool* s_currentThreadPool;
@@ -97,15 +277,19 @@ namespace cppcoro
 		const std::uint32_t m_threadCount;
 		const std::unique_ptr<thread_state[]> m_threadStates;
 
+		// NUMA nodes the threads are on, each with a queue of work
+		// scheduled with schedule_on_node().
+		std::uint32_t m_nodeCount;
+		std::unique_ptr<node_state[]> m_nodes;
+
 		std::vector<std::thread> m_threads;
 
 		std::atomic<bool> m_stopRequested;
 
-		std::mutex m_globalQueueMutex;
-		std::atomic<schedule_operation*> m_globalQueueHead;
+		std::atomic<idle_policy> m_idlePolicy;
+		std::atomic<std::chrono::nanoseconds::rep> m_spinDuration;
 
-		//alignas(std::hardware_destructive_interference_size)
-		std::atomic<schedule_operation*> m_globalQueueTail;
+		const std::unique_ptr<injection_queue> m_globalQueue;
 
 		//alignas(std::hardware_destructive_interference_size)
 		std::atomic<std::uint32_t> m_sleepingThreadCount;
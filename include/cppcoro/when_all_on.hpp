@@ -0,0 +1,60 @@
+///////////////////////////////////////////////////////////////////////////////
+// Copyright (c) Lewis Baker
+// Licenced under MIT license. See LICENSE.txt for details.
+///////////////////////////////////////////////////////////////////////////////
+#ifndef CPPCORO_WHEN_ALL_ON_HPP_INCLUDED
+#define CPPCORO_WHEN_ALL_ON_HPP_INCLUDED
+
+#include <cppcoro/task.hpp>
+#include <cppcoro/when_all.hpp>
+#include <cppcoro/awaitable_traits.hpp>
+
+#include <cppcoro/detail/remove_rvalue_reference.hpp>
+
+#include <cstdint>
+#include <utility>
+#include <vector>
+
+namespace cppcoro
+{
+	namespace detail
+	{
+		template<typename BULK_OPERATION, typename AWAITABLE>
+		auto make_bulk_scheduled_task(BULK_OPERATION& bulkOperation, AWAITABLE awaitable)
+			-> task<remove_rvalue_reference_t<typename awaitable_traits<AWAITABLE>::await_result_t>>
+		{
+			co_await bulkOperation;
+			co_return co_await std::move(awaitable);
+		}
+	}
+
+	/// Like when_all(), but runs each of \a awaitables on \a scheduler.
+	///
+	/// The awaitables are scheduled together with one schedule_bulk()
+	/// operation rather than each awaiting schedule(), which is cheaper when
+	/// fanning out many of them at once.
+	template<
+		typename SCHEDULER,
+		typename AWAITABLE,
+		typename RESULT = detail::remove_rvalue_reference_t<
+			typename awaitable_traits<AWAITABLE>::await_result_t>>
+	[[nodiscard]]
+	auto when_all_on(SCHEDULER& scheduler, std::vector<AWAITABLE> awaitables)
+		-> task<typename awaitable_traits<
+			decltype(when_all(std::declval<std::vector<task<RESULT>>>()))>::await_result_t>
+	{
+		auto bulkOperation = scheduler.schedule_bulk(
+			static_cast<std::uint32_t>(awaitables.size()));
+
+		std::vector<task<RESULT>> tasks;
+		tasks.reserve(awaitables.size());
+		for (auto& awaitable : awaitables)
+		{
+			tasks.push_back(detail::make_bulk_scheduled_task(bulkOperation, std::move(awaitable)));
+		}
+
+		co_return co_await when_all(std::move(tasks));
+	}
+}
+
+#endif
@@ -9,6 +9,12 @@
 #include <cppcoro/file_write_operation.hpp>
 #include <cppcoro/cancellation_token.hpp>
 
+#if CPPCORO_OS_LINUX
+# include <cppcoro/file_chain_operation.hpp>
+# include <cppcoro/file_sync_operation.hpp>
+# include <cppcoro/registered_buffer_pool.hpp>
+#endif
+
 namespace cppcoro
 {
 	class writable_file : virtual public file
@@ -61,6 +67,93 @@ namespace cppcoro
 			std::size_t byteCount,
 			cancellation_token ct) noexcept;
 
+#if CPPCORO_OS_LINUX
+		/// Write from the start of a slab leased from a registered_buffer_pool,
+		/// using IORING_OP_WRITE_FIXED if the pool is registered.
+		///
+		/// \param byteCount
+		/// The number of bytes to write, at most \a buffer.size().
+		[[nodiscard]]
+		file_write_operation write(
+			std::uint64_t offset,
+			const registered_buffer& buffer,
+			std::size_t byteCount) noexcept;
+		[[nodiscard]]
+		file_write_operation_cancellable write(
+			std::uint64_t offset,
+			const registered_buffer& buffer,
+			std::size_t byteCount,
+			cancellation_token ct) noexcept;
+
+		/// Write the concatenation of \a buffers with a single operation.
+		///
+		/// The iovec array, not only the data, must stay valid until the
+		/// operation completes.
+		[[nodiscard]]
+		file_write_operation write(
+			std::uint64_t offset,
+			std::span<const iovec> buffers) noexcept;
+		[[nodiscard]]
+		file_write_operation_cancellable write(
+			std::uint64_t offset,
+			std::span<const iovec> buffers,
+			cancellation_token ct) noexcept;
+
+		/// Make the data written so far durable, like fsync() or fdatasync()
+		/// but without blocking the calling thread.
+		[[nodiscard]]
+		file_sync_operation flush(
+			file_durability durability = file_durability::data_and_metadata) noexcept;
+
+		/// Write back the dirty pages in the \a byteCount bytes from
+		/// \a offset, and wait for the write-back, see sync_file_range(2).
+		///
+		/// Neither metadata nor the device's write cache are flushed, so
+		/// this doesn't make the data durable. It spreads the cost of a
+		/// later flush() over the writes that precede it.
+		///
+		/// \param byteCount
+		/// 0, or a range of 4 GiB or more, extends to the end of the file.
+		[[nodiscard]]
+		file_sync_operation sync_range(
+			std::uint64_t offset,
+			std::uint64_t byteCount) noexcept;
+
+		/// Allocate storage for the \a byteCount bytes from \a offset,
+		/// growing the file if needed, see fallocate(2).
+		///
+		/// Writes to a preallocated range don't fail for lack of space and
+		/// keep the file contiguous.
+		[[nodiscard]]
+		file_sync_operation allocate(
+			std::uint64_t offset,
+			std::uint64_t byteCount) noexcept;
+
+		/// Run \a steps one after the other with a single wake-up of the
+		/// awaiting coroutine, eg. write a record, flush it and then write
+		/// its commit marker.
+		///
+		/// A step is only started once the previous one has completed. The
+		/// first failure, or short write, cancels the remaining steps unless
+		/// marked with file_chain_step::continue_on_failure(), and is
+		/// reported once the chain is done. A chain cut short by a short
+		/// write fails with EIO.
+		///
+		/// The steps must stay valid until the operation completes.
+		///
+		/// \return
+		/// An object that represents the chain. Once co_await'ed, yields
+		/// the result of the last step, the number of bytes written for a
+		/// write.
+		[[nodiscard]]
+		file_chain_operation write_chain(
+			std::span<const file_chain_step> steps) noexcept;
+		[[nodiscard]]
+		file_chain_operation_cancellable write_chain(
+			std::span<const file_chain_step> steps,
+			cancellation_token ct) noexcept;
+#endif
+
 	protected:
 
 		using file::file;
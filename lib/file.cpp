@@ -6,6 +6,7 @@
 #include <cppcoro/file.hpp>
 #include <cppcoro/io_service.hpp>
 
+#include <algorithm>
 #include <system_error>
 #include <cassert>
 
@@ -21,8 +22,138 @@
 #include <sys/stat.h>
 #endif
 
+#if CPPCORO_OS_LINUX
+namespace
+{
+	namespace local
+	{
+		int open_flags(
+			cppcoro::file_open_mode openMode,
+			cppcoro::file_share_mode shareMode,
+			cppcoro::file_buffering_mode bufferingMode)
+		{
+			using namespace cppcoro;
+
+			const auto hasMode = [bufferingMode](file_buffering_mode mode) {
+				return (bufferingMode & mode) == mode;
+			};
+
+			int flags = 0;
+
+			switch (openMode)
+			{
+			case file_open_mode::create_or_open:
+				flags = O_CREAT;
+				break;
+			case file_open_mode::create_always:
+				flags = O_CREAT | O_TRUNC;
+				break;
+			case file_open_mode::create_new:
+				flags = O_CREAT | O_EXCL;
+				break;
+			case file_open_mode::open_existing:
+				break;
+			case file_open_mode::truncate_existing:
+				flags = O_TRUNC;
+				break;
+			}
+
+			switch (shareMode)
+			{
+			case file_share_mode::read:
+				flags |= O_RDONLY;
+				break;
+			case file_share_mode::write:
+				flags |= O_WRONLY;
+				break;
+			case file_share_mode::read_write:
+			case file_share_mode::none:
+				flags |= O_RDWR;
+				break;
+			default:
+				throw std::system_error {0, std::system_category(), "file::open unsupported share_mode"};
+			}
+
+			if (hasMode(file_buffering_mode::unbuffered))
+			{
+				flags |= O_DIRECT;
+			}
+			if (hasMode(file_buffering_mode::write_through))
+			{
+				flags |= O_DSYNC;
+			}
+			if (hasMode(file_buffering_mode::temporary))
+			{
+				// The path names the directory to create an unnamed file in, which
+				// is removed once closed.
+				flags = (flags & ~(O_CREAT | O_TRUNC)) | O_TMPFILE;
+			}
+
+			return flags;
+		}
+
+		/// Checks and hints applied to a newly opened file.
+		void configure(
+			const cppcoro::detail::safe_handle& fileHandle,
+			[[maybe_unused]] cppcoro::io_service& ioService,
+			cppcoro::file_buffering_mode bufferingMode)
+		{
+			using namespace cppcoro;
+
+			const auto hasMode = [bufferingMode](file_buffering_mode mode) {
+				return (bufferingMode & mode) == mode;
+			};
+
+			if (hasMode(file_buffering_mode::unbuffered))
+			{
+#ifdef STATX_DIOALIGN
+				// open() ignores O_DIRECT on some file systems, failing every read
+				// and write later on. Kernels since 6.1 tell whether it is honoured.
+				struct statx stx;
+				if (::statx(fileHandle.fd(), "", AT_EMPTY_PATH, STATX_DIOALIGN, &stx) == 0
+					&& (stx.stx_mask & STATX_DIOALIGN) != 0
+					&& stx.stx_dio_offset_align == 0)
+				{
+					throw std::system_error {
+						EINVAL,
+						std::generic_category(),
+						"error opening file: file system doesn't support unbuffered I/O"
+					};
+				}
+#endif
+			}
+
+			int advice = POSIX_FADV_NORMAL;
+			if (hasMode(file_buffering_mode::sequential))
+			{
+				advice = POSIX_FADV_SEQUENTIAL;
+			}
+			else if (hasMode(file_buffering_mode::random_access))
+			{
+				advice = POSIX_FADV_RANDOM;
+			}
+			if (advice != POSIX_FADV_NORMAL)
+			{
+				// Only a hint, ignore failures eg. on pipes.
+				(void)::posix_fadvise(fileHandle.fd(), 0, 0, advice);
+			}
+#if CPPCORO_USE_IO_RING
+			ioService.io_queue().register_file(fileHandle.fd());
+#endif
+		}
+	}
+}
+#endif
+
 cppcoro::file::~file()
-{}
+{
+#if CPPCORO_USE_IO_RING
+	if (m_ioService != nullptr && m_fileHandle.fd() >= 0)
+	{
+		m_ioService->io_queue().unregister_file(m_fileHandle.fd());
+	}
+#endif
+}
 
 std::uint64_t cppcoro::file::size() const
 {
@@ -83,6 +214,79 @@ std::uint64_t cppcoro::file::size() const
 #endif
 }
 
+#if CPPCORO_OS_LINUX
+std::size_t cppcoro::file::unbuffered_alignment() const
+{
+#ifdef STATX_DIOALIGN
+	struct statx stx;
+	if (::statx(m_fileHandle.fd(), "", AT_EMPTY_PATH, STATX_DIOALIGN, &stx) == 0
+		&& (stx.stx_mask & STATX_DIOALIGN) != 0
+		&& stx.stx_dio_offset_align != 0)
+	{
+		return std::max(stx.stx_dio_offset_align, stx.stx_dio_mem_align);
+	}
+#endif
+
+	struct stat st;
+	if (::fstat(m_fileHandle.fd(), &st) < 0)
+	{
+		throw std::system_error
+		{
+			static_cast<int>(errno),
+			std::system_category(),
+			"error getting unbuffered alignment: fstat"
+		};
+	}
+	if (S_ISBLK(st.st_mode))
+	{
+		int logicalBlockSize = 0;
+		if (::ioctl(m_fileHandle.fd(), BLKSSZGET, &logicalBlockSize) == 0 && logicalBlockSize > 0)
+		{
+			return static_cast<std::size_t>(logicalBlockSize);
+		}
+	}
+
+	// The preferred I/O size is a multiple of the logical block size.
+	return static_cast<std::size_t>(st.st_blksize);
+}
+
+cppcoro::file_size_operation cppcoro::file::size_async() const noexcept
+{
+	return file_size_operation{ *m_ioService, m_fileHandle.fd() };
+}
+
+cppcoro::file_close_operation cppcoro::file::close_async() noexcept
+{
+#if CPPCORO_USE_IO_RING
+	if (m_fileHandle.fd() >= 0)
+	{
+		m_ioService->io_queue().unregister_file(m_fileHandle.fd());
+	}
+#endif
+	return file_close_operation{ *m_ioService, std::move(m_fileHandle) };
+}
+
+cppcoro::task<cppcoro::detail::safe_handle> cppcoro::file::open_async(
+	detail::dword_t fileAccess,
+	io_service& ioService,
+	const filesystem::path& path,
+	file_open_mode openMode,
+	file_share_mode shareMode,
+	file_buffering_mode bufferingMode)
+{
+	detail::safe_handle fileHandle = co_await file_open_operation{
+		ioService,
+		path.c_str(),
+		local::open_flags(openMode, shareMode, bufferingMode),
+		static_cast<mode_t>(fileAccess)
+	};
+
+	local::configure(fileHandle, ioService, bufferingMode);
+
+	co_return std::move(fileHandle);
+}
+#endif
+
 cppcoro::file::file(detail::safe_handle&& fileHandle) noexcept
 	: m_fileHandle(std::move(fileHandle))
 {
@@ -209,43 +413,8 @@ cppcoro::detail::safe_handle cppcoro::file::open(
 		};
 	}
 #elif CPPCORO_OS_LINUX
-    (void) bufferingMode; // unused yet
-
-	int flags = 0;
-
-    switch (openMode) {
-        case file_open_mode::create_or_open:
-            flags = O_CREAT;
-            break;
-        case file_open_mode::create_always:
-            flags = O_CREAT | O_TRUNC;
-            break;
-        case file_open_mode::create_new:
-            flags = O_CREAT | O_EXCL;
-            break;
-        case file_open_mode::open_existing:
-            break;
-        case file_open_mode::truncate_existing:
-            flags = O_TRUNC;
-            break;
-	}
-
-    switch (shareMode) {
-		case file_share_mode::read:
-			flags |= O_RDONLY;
-			break;
-        case file_share_mode::write:
-            flags |= O_WRONLY;
-            break;
-        case file_share_mode::read_write:
-        case file_share_mode::none:
-            flags |= O_RDWR;
-            break;
-		default:
-            throw std::system_error {0, std::system_category(), "file::open unsupported share_mode"};
-	}
-
-    detail::safe_handle fileHandle(::open(path.c_str(), flags, fileAccess));
+	detail::safe_handle fileHandle(
+		::open(path.c_str(), local::open_flags(openMode, shareMode, bufferingMode), fileAccess));
 	if (fileHandle.fd() < 0)
 	{
 		throw std::system_error {
@@ -253,6 +422,8 @@ cppcoro::detail::safe_handle cppcoro::file::open(
             std::generic_category()
 		};
 	}
+
+	local::configure(fileHandle, ioService, bufferingMode);
 #endif
 
 	return std::move(fileHandle);
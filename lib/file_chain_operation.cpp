@@ -0,0 +1,46 @@
+///////////////////////////////////////////////////////////////////////////////
+// Copyright (c) Lewis Baker
+// Licenced under MIT license. See LICENSE.txt for details.
+///////////////////////////////////////////////////////////////////////////////
+
+#include <cppcoro/file_chain_operation.hpp>
+
+bool cppcoro::file_chain_operation_impl::try_start(
+	cppcoro::detail::io_operation_base& operation) noexcept
+{
+	if (m_steps.empty())
+	{
+		operation.m_message.result = 0;
+		return false;
+	}
+
+	auto transaction = operation.m_ioQueue.linked_transaction(
+		operation.m_message, static_cast<unsigned>(m_steps.size()));
+	for (std::size_t i = 0; i < m_steps.size(); ++i)
+	{
+		const auto& step = m_steps[i];
+		if (i != 0)
+		{
+			(void)transaction.link(m_steps[i - 1].m_continueOnFailure);
+		}
+
+		switch (step.m_kind)
+		{
+		case file_chain_step::kind::write:
+			(void)transaction.writev(
+				m_fileHandle, const_cast<iovec*>(&step.m_vec), 1, step.m_offset);
+			break;
+		case file_chain_step::kind::flush:
+			(void)transaction.fsync(m_fileHandle, step.m_durability == file_durability::data);
+			break;
+		}
+	}
+	return transaction.commit();
+}
+
+void cppcoro::file_chain_operation_impl::cancel(
+	cppcoro::detail::io_operation_base& operation) noexcept
+{
+	// Cancelling the step in flight cancels the ones linked after it.
+	operation.m_ioQueue.transaction(operation.m_message).cancel().commit();
+}
@@ -0,0 +1,13 @@
+///////////////////////////////////////////////////////////////////////////////
+// Copyright (c) Lewis Baker
+// Licenced under MIT license. See LICENSE.txt for details.
+///////////////////////////////////////////////////////////////////////////////
+
+#include <cppcoro/file_close_operation.hpp>
+
+bool cppcoro::file_close_operation::try_start() noexcept
+{
+	return m_ioQueue.transaction(m_message)
+		.close(m_fileHandle.release())
+		.commit();
+}
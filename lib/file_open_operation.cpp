@@ -0,0 +1,15 @@
+///////////////////////////////////////////////////////////////////////////////
+// Copyright (c) Lewis Baker
+// Licenced under MIT license. See LICENSE.txt for details.
+///////////////////////////////////////////////////////////////////////////////
+
+#include <cppcoro/file_open_operation.hpp>
+
+#include <fcntl.h>
+
+bool cppcoro::file_open_operation::try_start() noexcept
+{
+	return m_ioQueue.transaction(m_message)
+		.openat(AT_FDCWD, m_path, m_flags, m_mode)
+		.commit();
+}
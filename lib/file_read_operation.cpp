@@ -55,11 +55,17 @@ void cppcoro::file_read_operation_impl::cancel(
 bool cppcoro::file_read_operation_impl::try_start(
     cppcoro::detail::io_operation_base& operation) noexcept
 {
+    if (m_vecs != nullptr)
+    {
+        return operation.m_ioQueue.transaction(operation.m_message)
+            .readv(m_fileHandle, const_cast<iovec*>(m_vecs), m_vecCount, operation.m_offset)
+            .commit();
+    }
     const size_t numberOfBytesToRead =
         m_byteCount <= std::numeric_limits<size_t>::max() ?
               m_byteCount : std::numeric_limits<size_t>::max();
     return operation.m_ioQueue.transaction(operation.m_message)
-        .read(m_fileHandle, m_buffer, numberOfBytesToRead, operation.m_offset)
+        .read_fixed(m_fileHandle, m_buffer, numberOfBytesToRead, operation.m_offset, m_bufferIndex, m_vec)
         .commit();
 }
 
@@ -0,0 +1,51 @@
+///////////////////////////////////////////////////////////////////////////////
+// Copyright (c) Lewis Baker
+// Licenced under MIT license. See LICENSE.txt for details.
+///////////////////////////////////////////////////////////////////////////////
+
+#include <cppcoro/file_size_operation.hpp>
+
+#include <system_error>
+
+#include <fcntl.h>
+#include <linux/fs.h>
+#include <sys/ioctl.h>
+
+bool cppcoro::file_size_operation::try_start() noexcept
+{
+	return m_ioQueue.transaction(m_message)
+		.statx(m_fileHandle, "", AT_EMPTY_PATH, STATX_TYPE | STATX_SIZE, &m_statx)
+		.commit();
+}
+
+std::uint64_t cppcoro::file_size_operation::get_result()
+{
+	io_operation_base::get_result();
+
+	if (S_ISREG(m_statx.stx_mode))
+	{
+		return m_statx.stx_size;
+	}
+	else if (S_ISBLK(m_statx.stx_mode))
+	{
+		// statx() doesn't report the size of block devices.
+		unsigned long long bytes;
+		if (::ioctl(m_fileHandle, BLKGETSIZE64, &bytes) != 0)
+		{
+			throw std::system_error
+			{
+				static_cast<int>(errno),
+				std::system_category(),
+				"error getting file size: ioctl"
+			};
+		}
+		return bytes;
+	}
+
+	throw std::system_error
+	{
+		EINVAL,
+		std::system_category(),
+		"error getting file size"
+	};
+}
@@ -0,0 +1,36 @@
+///////////////////////////////////////////////////////////////////////////////
+// Copyright (c) Lewis Baker
+// Licenced under MIT license. See LICENSE.txt for details.
+///////////////////////////////////////////////////////////////////////////////
+
+#include <cppcoro/file_sync_operation.hpp>
+
+#include <limits>
+
+#include <fcntl.h>
+
+bool cppcoro::file_sync_operation::try_start() noexcept
+{
+	auto transaction = m_ioQueue.transaction(m_message);
+	switch (m_kind)
+	{
+	case kind::flush:
+		(void)transaction.fsync(m_fileHandle, m_durability == file_durability::data);
+		break;
+	case kind::sync_range:
+		// IORING_OP_SYNC_FILE_RANGE takes a 32 bit length, longer ranges
+		// are written back up to the end of the file.
+		(void)transaction.sync_file_range(
+			m_fileHandle,
+			m_offset,
+			m_byteCount <= std::numeric_limits<std::uint32_t>::max()
+				? static_cast<std::uint32_t>(m_byteCount)
+				: 0,
+			SYNC_FILE_RANGE_WAIT_BEFORE | SYNC_FILE_RANGE_WRITE | SYNC_FILE_RANGE_WAIT_AFTER);
+		break;
+	case kind::allocate:
+		(void)transaction.fallocate(m_fileHandle, 0, m_offset, m_byteCount);
+		break;
+	}
+	return transaction.commit();
+}
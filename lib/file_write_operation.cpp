@@ -55,11 +55,17 @@ void cppcoro::file_write_operation_impl::cancel(
 bool cppcoro::file_write_operation_impl::try_start(
 	cppcoro::detail::io_operation_base& operation) noexcept
 {
+	if (m_vecs != nullptr)
+	{
+		return operation.m_ioQueue.transaction(operation.m_message)
+			.writev(m_fileHandle, const_cast<iovec*>(m_vecs), m_vecCount, operation.m_offset)
+			.commit();
+	}
 	const size_t numberOfBytesToWrite = m_byteCount <= std::numeric_limits<size_t>::max()
 		? m_byteCount
 		: std::numeric_limits<size_t>::max();
 	return operation.m_ioQueue.transaction(operation.m_message)
-		.write(m_fileHandle, m_buffer, numberOfBytesToWrite, operation.m_offset)
+		.write_fixed(m_fileHandle, m_buffer, numberOfBytesToWrite, operation.m_offset, m_bufferIndex, m_vec)
 		.commit();
 }
 
@@ -29,6 +29,8 @@
 #if CPPCORO_OS_LINUX
 #include <cppcoro/operation_cancelled.hpp>
 #include <cppcoro/detail/linux_io_operation.hpp>
+#include <bit>
+#include <limits>
 typedef int DWORD;
 #define INFINITE (DWORD)-1 //needed for timeout values in io_service::timer_thread_state::run()
 typedef long long int LONGLONG;
@@ -303,6 +305,363 @@ void cppcoro::io_service::timer_queue::remove_cancelled_timers(
 	}
 }
 
+#if CPPCORO_OS_LINUX
+namespace
+{
+	// The io_service whose event loop the current thread is running, if any.
+	thread_local cppcoro::io_service* t_eventLoopService = nullptr;
+}
+
+/// Hierarchical timing wheel holding the timers of an io_service, driven
+/// by a single kernel timeout.
+///
+/// Time is counted in ticks of a millisecond since the wheel was created.
+/// A timer due at tick t is kept at the level of the highest 6 bit group in
+/// which t differs from the tick the wheel was last advanced to, in the
+/// slot given by that group of t. Inserting and removing a timer are thus
+/// constant time, and the next slot to expire is found with a bit scan of
+/// each level's occupancy mask. When the wheel reaches the start of a slot
+/// above level 0 the slot's timers are spread over the lower levels.
+///
+/// The kernel timeout is armed for the next slot to expire and only
+/// removed early when a timer due before it is inserted. Timers that
+/// expire are resumed by the timeout's completion. Cancelled timers are
+/// resumed by the event loop, woken up if cancellation was requested from
+/// another thread.
+class cppcoro::io_service::timer_wheel
+{
+public:
+
+	using clock = std::chrono::high_resolution_clock;
+
+	explicit timer_wheel(io_service& service) noexcept;
+
+	timer_wheel(const timer_wheel&) = delete;
+	timer_wheel& operator=(const timer_wheel&) = delete;
+
+	/// Queue \a timer until its resume time, or until it's cancelled.
+	/// Returns false, without queueing it, if the timer is already due.
+	bool insert(timed_schedule_operation* timer) noexcept;
+
+	/// Take \a timer out of the wheel if it's still there, to be resumed by
+	/// the event loop.
+	void cancel(timed_schedule_operation* timer) noexcept;
+
+	/// Resume the timers cancelled since the last call. Called by the
+	/// event loop.
+	void resume_cancelled_timers() noexcept
+	{
+		if (m_hasCancelledTimers.load(std::memory_order_acquire))
+		{
+			timed_schedule_operation* timers;
+			{
+				std::lock_guard lock{ m_mutex };
+				timers = std::exchange(m_cancelledTimers, nullptr);
+				m_hasCancelledTimers.store(false, std::memory_order_relaxed);
+			}
+			resume(timers);
+		}
+	}
+
+private:
+
+	static constexpr unsigned bits_per_level = 6;
+	static constexpr unsigned slots_per_level = 1u << bits_per_level;
+
+	// Enough levels to tell apart any two 64 bit ticks.
+	static constexpr unsigned level_count = (64 + bits_per_level - 1) / bits_per_level;
+
+	static constexpr std::uint64_t no_tick = std::numeric_limits<std::uint64_t>::max();
+
+	struct level
+	{
+		std::uint64_t m_occupied = 0;
+		timed_schedule_operation* m_slots[slots_per_level] = {};
+	};
+
+	std::uint64_t current_tick() const noexcept;
+
+	/// First tick at or after \a time.
+	std::uint64_t due_tick(clock::time_point time) const noexcept;
+
+	/// Put \a timer, due after m_now, in its slot.
+	void place(timed_schedule_operation* timer) noexcept;
+
+	void unlink(timed_schedule_operation* timer) noexcept;
+
+	/// Tick at which the next slot expires, or no_tick if the wheel is
+	/// empty.
+	std::uint64_t next_expiry(unsigned& levelIndex, unsigned& slot) const noexcept;
+
+	/// Advance the wheel to \a tick, moving due timers to \a dueTimers.
+	void advance(std::uint64_t tick, timed_schedule_operation*& dueTimers) noexcept;
+
+	/// Make sure the kernel timeout fires no later than the next expiry.
+	void update_timeout() noexcept;
+
+	static void on_timeout(void* context) noexcept;
+
+	/// Resume each timer of \a timers whose await_suspend() has returned.
+	static void resume(timed_schedule_operation* timers) noexcept;
+
+	io_service& m_service;
+	const clock::time_point m_startTime;
+
+	std::mutex m_mutex;
+	std::uint64_t m_now = 0;
+	std::size_t m_timerCount = 0;
+	level m_levels[level_count];
+
+	timed_schedule_operation* m_cancelledTimers = nullptr;
+	std::atomic<bool> m_hasCancelledTimers{ false };
+
+	detail::lnx::io_message m_message{};
+	// Must outlive the commit as submission of the SQE may be deferred.
+	__kernel_timespec m_timeout{};
+	std::uint64_t m_armedTick = no_tick;
+	bool m_removeRequested = false;
+
+};
+
+cppcoro::io_service::timer_wheel::timer_wheel(io_service& service) noexcept
+	: m_service(service)
+	, m_startTime(clock::now())
+{
+	m_message.set_callback(&timer_wheel::on_timeout, this);
+}
+
+bool cppcoro::io_service::timer_wheel::insert(timed_schedule_operation* timer) noexcept
+{
+	std::lock_guard lock{ m_mutex };
+
+	const std::uint64_t dueTick = due_tick(timer->m_resumeTime);
+	if (m_timerCount == 0)
+	{
+		// Nothing depends on the old position, start from the present to
+		// keep new timers on the lower levels.
+		m_now = std::max(m_now, current_tick());
+	}
+
+	if (dueTick <= m_now)
+	{
+		return false;
+	}
+
+	timer->m_dueTick = dueTick;
+	place(timer);
+	++m_timerCount;
+
+	if (dueTick < m_armedTick)
+	{
+		update_timeout();
+	}
+
+	return true;
+}
+
+void cppcoro::io_service::timer_wheel::cancel(timed_schedule_operation* timer) noexcept
+{
+	{
+		std::lock_guard lock{ m_mutex };
+		if (timer->m_prevNext == nullptr)
+		{
+			// Already expired.
+			return;
+		}
+
+		unlink(timer);
+		--m_timerCount;
+		timer->m_next = m_cancelledTimers;
+		m_cancelledTimers = timer;
+		m_hasCancelledTimers.store(true, std::memory_order_release);
+	}
+
+	// The event loop resumes cancelled timers after each batch of events,
+	// only wake it up if this isn't one of its threads.
+	if (t_eventLoopService != &m_service)
+	{
+		m_service.post_wake_up_event();
+	}
+}
+
+std::uint64_t cppcoro::io_service::timer_wheel::current_tick() const noexcept
+{
+	const auto elapsed = std::chrono::floor<std::chrono::milliseconds>(clock::now() - m_startTime);
+	return elapsed.count() > 0 ? static_cast<std::uint64_t>(elapsed.count()) : 0;
+}
+
+std::uint64_t cppcoro::io_service::timer_wheel::due_tick(clock::time_point time) const noexcept
+{
+	const auto elapsed = std::chrono::ceil<std::chrono::milliseconds>(time - m_startTime);
+	return elapsed.count() > 0 ? static_cast<std::uint64_t>(elapsed.count()) : 0;
+}
+
+void cppcoro::io_service::timer_wheel::place(timed_schedule_operation* timer) noexcept
+{
+	assert(timer->m_dueTick > m_now);
+
+	const unsigned highestBit = 63 - static_cast<unsigned>(std::countl_zero(timer->m_dueTick ^ m_now));
+	const unsigned levelIndex = highestBit / bits_per_level;
+	const unsigned slot = static_cast<unsigned>(
+		(timer->m_dueTick >> (levelIndex * bits_per_level)) & (slots_per_level - 1));
+
+	auto& lvl = m_levels[levelIndex];
+	auto*& head = lvl.m_slots[slot];
+	timer->m_next = head;
+	if (head != nullptr)
+	{
+		head->m_prevNext = &timer->m_next;
+	}
+	head = timer;
+	timer->m_prevNext = &head;
+	timer->m_wheelSlot = static_cast<std::uint16_t>(levelIndex * slots_per_level + slot);
+	lvl.m_occupied |= std::uint64_t(1) << slot;
+}
+
+void cppcoro::io_service::timer_wheel::unlink(timed_schedule_operation* timer) noexcept
+{
+	*timer->m_prevNext = timer->m_next;
+	if (timer->m_next != nullptr)
+	{
+		timer->m_next->m_prevNext = timer->m_prevNext;
+	}
+	timer->m_prevNext = nullptr;
+
+	auto& lvl = m_levels[timer->m_wheelSlot / slots_per_level];
+	const unsigned slot = timer->m_wheelSlot % slots_per_level;
+	if (lvl.m_slots[slot] == nullptr)
+	{
+		lvl.m_occupied &= ~(std::uint64_t(1) << slot);
+	}
+}
+
+std::uint64_t cppcoro::io_service::timer_wheel::next_expiry(
+	unsigned& levelIndex, unsigned& slot) const noexcept
+{
+	// Timers on a level are all due after those on the levels below, and
+	// every occupied slot of a level is ahead of m_now.
+	for (levelIndex = 0; levelIndex < level_count; ++levelIndex)
+	{
+		const auto occupied = m_levels[levelIndex].m_occupied;
+		if (occupied != 0)
+		{
+			slot = static_cast<unsigned>(std::countr_zero(occupied));
+			const unsigned shift = levelIndex * bits_per_level;
+			const unsigned blockShift = shift + bits_per_level;
+			const std::uint64_t block = blockShift < 64 ? (m_now >> blockShift) << blockShift : 0;
+			return block | (std::uint64_t(slot) << shift);
+		}
+	}
+	return no_tick;
+}
+
+void cppcoro::io_service::timer_wheel::advance(
+	std::uint64_t tick, timed_schedule_operation*& dueTimers) noexcept
+{
+	unsigned levelIndex;
+	unsigned slot;
+	std::uint64_t expiry;
+	while ((expiry = next_expiry(levelIndex, slot)) <= tick)
+	{
+		m_now = expiry;
+
+		auto& lvl = m_levels[levelIndex];
+		auto* timer = std::exchange(lvl.m_slots[slot], nullptr);
+		lvl.m_occupied &= ~(std::uint64_t(1) << slot);
+
+		while (timer != nullptr)
+		{
+			auto* next = timer->m_next;
+			timer->m_prevNext = nullptr;
+			if (timer->m_dueTick <= m_now)
+			{
+				--m_timerCount;
+				timer->m_next = dueTimers;
+				dueTimers = timer;
+			}
+			else
+			{
+				// Moves to a lower level.
+				place(timer);
+			}
+			timer = next;
+		}
+	}
+
+	// No slot starts before tick, so moving there keeps every timer in
+	// its slot.
+	m_now = std::max(m_now, tick);
+}
+
+void cppcoro::io_service::timer_wheel::update_timeout() noexcept
+{
+	if (m_removeRequested)
+	{
+		// The timeout is about to complete, and rearmed then.
+		return;
+	}
+
+	unsigned levelIndex;
+	unsigned slot;
+	const std::uint64_t expiry = next_expiry(levelIndex, slot);
+	if (expiry == no_tick || expiry >= m_armedTick)
+	{
+		return;
+	}
+
+	// The timeout is armed on the shared ring, it would otherwise only
+	// complete while the thread that armed it runs the event loop.
+#if CPPCORO_USE_IO_RING
+	auto transaction = m_service.m_uq.shared_transaction(m_message);
+#else
+	auto transaction = m_service.m_uq.transaction(m_message);
+#endif
+	if (m_armedTick != no_tick)
+	{
+		// Completes the timeout early, which rearms it.
+		m_removeRequested = true;
+		(void)transaction.timeout_remove().commit();
+		return;
+	}
+
+	const auto delay = m_startTime + std::chrono::milliseconds{ expiry } - clock::now();
+	m_timeout = detail::duration_to_event_timespec(std::max(delay, clock::duration::zero()));
+	m_armedTick = expiry;
+	(void)transaction.timeout(&m_timeout).commit();
+}
+
+void cppcoro::io_service::timer_wheel::on_timeout(void* context) noexcept
+{
+	auto& wheel = *static_cast<timer_wheel*>(context);
+
+	timed_schedule_operation* dueTimers = nullptr;
+	{
+		std::lock_guard lock{ wheel.m_mutex };
+		wheel.m_armedTick = no_tick;
+		wheel.m_removeRequested = false;
+		wheel.advance(wheel.current_tick(), dueTimers);
+		wheel.update_timeout();
+	}
+
+	resume(dueTimers);
+}
+
+void cppcoro::io_service::timer_wheel::resume(timed_schedule_operation* timers) noexcept
+{
+	while (timers != nullptr)
+	{
+		auto* timer = timers;
+		timers = timer->m_next;
+
+		// See timed_schedule_operation::await_suspend().
+		if (timer->m_refCount.fetch_sub(1, std::memory_order_acq_rel) == 1)
+		{
+			timer->m_scheduleOperation.m_awaiter.resume();
+		}
+	}
+}
+#endif
+
 #if CPPCORO_OS_WINNT
 class cppcoro::io_service::timer_thread_state
 {
@@ -363,6 +722,9 @@ cppcoro::io_service::io_service(
 	, m_timerState(nullptr)
 #endif
 {
+#if CPPCORO_OS_LINUX
+	m_timerWheel = std::make_unique<timer_wheel>(*this);
+#endif
 }
 
 cppcoro::io_service::~io_service()
@@ -397,10 +759,17 @@ std::uint64_t cppcoro::io_service::process_events()
 		auto exitLoop = on_scope_exit([&] { exit_event_loop(); });
 
 		constexpr bool waitForEvent = true;
+#if CPPCORO_OS_LINUX
+		while (const auto batchCount = try_process_event_batch(waitForEvent))
+		{
+			eventCount += batchCount;
+		}
+#else
 		while (try_process_one_event(waitForEvent))
 		{
 			++eventCount;
 		}
+#endif
 	}
 
 	return eventCount;
@@ -414,10 +783,17 @@ std::uint64_t cppcoro::io_service::process_pending_events()
 		auto exitLoop = on_scope_exit([&] { exit_event_loop(); });
 
 		constexpr bool waitForEvent = false;
+#if CPPCORO_OS_LINUX
+		while (const auto batchCount = try_process_event_batch(waitForEvent))
+		{
+			eventCount += batchCount;
+		}
+#else
 		while (try_process_one_event(waitForEvent))
 		{
 			++eventCount;
 		}
+#endif
 	}
 
 	return eventCount;
@@ -619,11 +995,21 @@ bool cppcoro::io_service::try_enter_event_loop() noexcept
 		currentState + active_thread_count_increment,
 		std::memory_order_relaxed));
 
+#if CPPCORO_OS_LINUX
+	t_eventLoopService = this;
+#endif
+
 	return true;
 }
 
 void cppcoro::io_service::exit_event_loop() noexcept
 {
+#if CPPCORO_OS_LINUX
+	// Don't leave operations started by the last dispatched event sitting
+	// in the submission queue once this thread stops polling.
+	m_uq.flush();
+	t_eventLoopService = nullptr;
+#endif
 	m_threadState.fetch_sub(active_thread_count_increment, std::memory_order_relaxed);
 }
 
@@ -735,9 +1121,13 @@ bool cppcoro::io_service::try_process_one_event(bool waitForEvent)
 			return false;
 		}
 
-		if (message != nullptr && message->resume != nullptr) {
-		    message->resume();
-        }
+		{
+			detail::lnx::io_queue::dispatch_scope dispatching{ m_uq };
+			if (message != nullptr && message->has_continuation()) {
+				message->resume();
+			}
+			m_timerWheel->resume_cancelled_timers();
+		}
 
         if (is_stop_requested())
         {
@@ -748,6 +1138,71 @@ bool cppcoro::io_service::try_process_one_event(bool waitForEvent)
 #endif
 }
 
+#if CPPCORO_OS_LINUX
+std::uint64_t cppcoro::io_service::try_process_event_batch(bool waitForEvent)
+{
+	if (is_stop_requested())
+	{
+		return 0;
+	}
+
+	try_reschedule_overflow_operations();
+
+	detail::lnx::io_message* messages[detail::lnx::io_queue::max_dequeue_batch];
+	std::size_t count;
+
+	try
+	{
+		count = m_uq.dequeue(messages, std::size(messages), waitForEvent);
+	}
+	catch (std::system_error& err)
+	{
+		if (err.code() == std::errc::interrupted &&
+			(m_threadState.load(std::memory_order_relaxed) & stop_requested_flag) == 0)
+		{
+			return 0;
+		}
+		else
+		{
+			throw err;
+		}
+	}
+
+	// Every reaped completion has to be dispatched here, even if stop() is
+	// called part way through the batch, as no other thread will see them.
+	std::uint32_t wakeUpCount = 0;
+	{
+		detail::lnx::io_queue::dispatch_scope dispatching{ m_uq };
+		for (std::size_t i = 0; i < count; ++i)
+		{
+			auto* message = messages[i];
+			if (message == &m_nopMessage)
+			{
+				++wakeUpCount;
+			}
+			else if (message != nullptr && message->has_continuation())
+			{
+				message->resume();
+			}
+		}
+		m_timerWheel->resume_cancelled_timers();
+	}
+
+	if (is_stop_requested())
+	{
+		// This thread may have reaped wake-up events that were posted for
+		// other threads blocked in the event loop, pass them on.
+		for (; wakeUpCount > 1; --wakeUpCount)
+		{
+			post_wake_up_event();
+		}
+		return 0;
+	}
+
+	return count;
+}
+#endif
+
 void cppcoro::io_service::post_wake_up_event() noexcept
 {
 #if CPPCORO_OS_WINNT
@@ -758,8 +1213,7 @@ void cppcoro::io_service::post_wake_up_event() noexcept
 	// in the queue next time they check anyway and thus wake-up.
 	(void)::PostQueuedCompletionStatus(m_iocpHandle.handle(), 0, 0, nullptr);
 #else
-	static detail::lnx::io_message nop;
-	m_uq.transaction(nop).nop().commit();
+	m_uq.wake_up(m_nopMessage);
 #endif
 }
 
@@ -997,11 +1451,6 @@ cppcoro::io_service::timed_schedule_operation::timed_schedule_operation(
 	, m_cancellationToken(std::move(cancellationToken))
 	, m_refCount(2)
 {
-#if CPPCORO_OS_LINUX
-    m_cancellationRegistration.emplace(std::move(m_cancellationToken), [&service, this] {
-        service.io_queue().transaction(m_message).timeout_remove().commit();
-    });
-#endif
 }
 
 cppcoro::io_service::timed_schedule_operation::timed_schedule_operation(
@@ -1078,10 +1527,22 @@ void cppcoro::io_service::timed_schedule_operation::await_suspend(
 		timerState->wake_up_timer_thread();
 	}
 #elif CPPCORO_OS_LINUX
-    auto timeout = detail::duration_to_event_timespec(m_resumeTime - std::chrono::high_resolution_clock::now());
-    m_message = m_scheduleOperation.m_awaiter;
-    service.io_queue().transaction(m_message)
-        .timeout(&timeout).commit();
+	auto* timerWheel = service.m_timerWheel.get();
+	if (timerWheel->insert(this))
+	{
+		if (m_cancellationToken.can_be_cancelled())
+		{
+			m_cancellationRegistration.emplace(m_cancellationToken, [timerWheel, this]
+			{
+				timerWheel->cancel(this);
+			});
+		}
+	}
+	else
+	{
+		// Already due, resume it like an expired timer.
+		m_refCount.fetch_sub(1, std::memory_order_relaxed);
+	}
 #endif
 
 	// Use 'acquire' semantics here to synchronise with the 'release'
@@ -1100,15 +1561,4 @@ void cppcoro::io_service::timed_schedule_operation::await_resume()
 {
 	m_cancellationRegistration.reset();
 	m_cancellationToken.throw_if_cancellation_requested();
-#if CPPCORO_OS_LINUX
-    if (m_message.result == -ETIME) {
-    } else if (m_message.result == -ECANCELED) {
-        throw operation_cancelled{};
-    } else if (m_message.result < 0) {
-        throw std::system_error {
-            -m_message.result,
-            std::generic_category()
-        };
-	}
-#endif
 }
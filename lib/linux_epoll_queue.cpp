@@ -0,0 +1,1051 @@
+///////////////////////////////////////////////////////////////////////////////
+// Copyright (c) Lewis Baker
+// Licenced under MIT license. See LICENSE.txt for details.
+///////////////////////////////////////////////////////////////////////////////
+
+#include <cppcoro/detail/linux_epoll_queue.hpp>
+
+#include <algorithm>
+#include <array>
+#include <cassert>
+#include <cerrno>
+#include <new>
+#include <system_error>
+
+#include <fcntl.h>
+#include <sys/epoll.h>
+#include <sys/mman.h>
+#include <sys/sendfile.h>
+#include <sys/stat.h>
+#include <sys/eventfd.h>
+#include <sys/timerfd.h>
+#include <unistd.h>
+
+namespace
+{
+	namespace local
+	{
+		using cppcoro::detail::lnx::io_message;
+
+		struct timer_later
+		{
+			template<typename TIMER>
+			bool operator()(const TIMER& a, const TIMER& b) const noexcept
+			{
+				return a.deadline > b.deadline;
+			}
+		};
+
+		/// \return
+		/// The result of a system call as stored in io_message::result.
+		template<typename T>
+		int to_result(T ret) noexcept
+		{
+			return ret < 0 ? -errno : static_cast<int>(ret);
+		}
+
+		bool would_block(int result) noexcept
+		{
+			return result == -EAGAIN || result == -EWOULDBLOCK;
+		}
+
+		void register_fd(int epollFd, int fd)
+		{
+			epoll_event ev{};
+			ev.events = EPOLLIN;
+			ev.data.fd = fd;
+			if (epoll_ctl(epollFd, EPOLL_CTL_ADD, fd, &ev) < 0)
+			{
+				throw std::system_error{
+					errno,
+					std::system_category(),
+					"Error creating io_service: epoll_ctl"
+				};
+			}
+		}
+	}  // namespace local
+}  // namespace
+
+namespace cppcoro::detail::lnx
+{
+	epoll_queue::epoll_queue(size_t queue_length)
+		: m_maxEvents(std::clamp<std::size_t>(queue_length, 1, max_dequeue_batch))
+		, m_epollFd(epoll_create1(EPOLL_CLOEXEC))
+		, m_wakeUpFd(eventfd(0, EFD_NONBLOCK | EFD_CLOEXEC))
+		, m_timerFd(timerfd_create(CLOCK_MONOTONIC, TFD_NONBLOCK | TFD_CLOEXEC))
+		, m_timerDeadline(std::chrono::steady_clock::time_point::max())
+	{
+		if (m_epollFd.fd() < 0 || m_wakeUpFd.fd() < 0 || m_timerFd.fd() < 0)
+		{
+			throw std::system_error{
+				errno,
+				std::system_category(),
+				"Error creating io_service: epoll"
+			};
+		}
+
+		local::register_fd(m_epollFd.fd(), m_wakeUpFd.fd());
+		local::register_fd(m_epollFd.fd(), m_timerFd.fd());
+	}
+
+	epoll_queue::~epoll_queue() noexcept = default;
+
+	void epoll_queue::set_provided_buffers(std::uint16_t count, std::uint32_t size) noexcept
+	{
+		assert(count != 0);
+		assert(m_providedMemory == nullptr);
+		m_providedCount = count;
+		m_providedSize = size;
+	}
+
+	int epoll_queue::take_provided_buffer() noexcept
+	{
+		std::lock_guard lock{ m_providedMux };
+		if (m_providedMemory == nullptr)
+		{
+			const std::size_t bytes = std::size_t{ m_providedCount } * m_providedSize;
+			m_providedStorage.reset(new (std::nothrow) std::byte[bytes]);
+			if (!m_providedStorage)
+			{
+				return -1;
+			}
+			m_providedMemory = m_providedStorage.get();
+			m_freeProvided.reserve(m_providedCount);
+			for (int id = m_providedCount; id-- > 0;)
+			{
+				m_freeProvided.push_back(id);
+			}
+		}
+		if (m_freeProvided.empty())
+		{
+			return -1;
+		}
+		const int id = m_freeProvided.back();
+		m_freeProvided.pop_back();
+		return id;
+	}
+
+	void epoll_queue::recycle_provided_buffer(int id) noexcept
+	{
+		std::lock_guard lock{ m_providedMux };
+		m_freeProvided.push_back(id);
+	}
+
+	io_transaction epoll_queue::transaction(io_message& message) noexcept
+	{
+		return io_transaction{ *this, message };
+	}
+
+	io_transaction epoll_queue::linked_transaction(io_message& message, unsigned) noexcept
+	{
+		return io_transaction{ *this, message };
+	}
+
+	bool epoll_queue::dequeue(io_message*& msg, bool wait)
+	{
+		return dequeue(&msg, 1, wait) != 0;
+	}
+
+	std::size_t epoll_queue::dequeue(io_message** messages, std::size_t maxCount, bool wait)
+	{
+		maxCount = std::min(maxCount, max_dequeue_batch);
+
+		std::array<epoll_event, max_dequeue_batch> events;
+
+		std::unique_lock lock{ m_mux };
+		bool polled = false;
+		while (true)
+		{
+			if (!m_timers.empty() && m_timers.front().deadline <= std::chrono::steady_clock::now())
+			{
+				process_timers();
+			}
+
+			std::size_t count = 0;
+			while (count < maxCount && m_readyHead < m_ready.size())
+			{
+				messages[count++] = m_ready[m_readyHead++];
+			}
+			if (m_readyHead == m_ready.size())
+			{
+				m_ready.clear();
+				m_readyHead = 0;
+			}
+			else if (m_waitingThreads != 0)
+			{
+				// Leave the remaining completions to a blocked thread.
+				notify();
+			}
+
+			if (count != 0 || (!wait && polled))
+			{
+				return count;
+			}
+
+			++m_waitingThreads;
+			lock.unlock();
+			const int eventCount = epoll_wait(
+				m_epollFd.fd(), events.data(), static_cast<int>(m_maxEvents), wait ? -1 : 0);
+			const int error = errno;
+			lock.lock();
+			--m_waitingThreads;
+
+			if (eventCount < 0)
+			{
+				if (error == EINTR)
+				{
+					continue;
+				}
+				throw std::system_error{
+					error,
+					std::system_category(),
+					"Error in epoll_queue::dequeue: epoll_wait"
+				};
+			}
+			polled = true;
+
+			for (int i = 0; i < eventCount; ++i)
+			{
+				const int fd = events[i].data.fd;
+				if (fd == m_wakeUpFd.fd())
+				{
+					eventfd_t value;
+					(void)eventfd_read(fd, &value);
+				}
+				else if (fd == m_timerFd.fd())
+				{
+					std::uint64_t expirations;
+					(void)::read(fd, &expirations, sizeof(expirations));
+					process_timers();
+				}
+				else
+				{
+					process_ready(fd, events[i].events);
+				}
+			}
+		}
+	}
+
+	void epoll_queue::wake_up(io_message& message) noexcept
+	{
+		std::lock_guard lock{ m_mux };
+		complete(message, 0);
+	}
+
+	bool epoll_queue::is_write(op_kind kind) noexcept
+	{
+		switch (kind)
+		{
+		case op_kind::write:
+		case op_kind::writev:
+		case op_kind::send:
+		case op_kind::sendmsg:
+		case op_kind::connect:
+		case op_kind::sendfile:
+			return true;
+		default:
+			return false;
+		}
+	}
+
+	bool epoll_queue::try_perform(pending_op& op) noexcept
+	{
+		int result = -EINVAL;
+		switch (op.kind)
+		{
+		case op_kind::read:
+			result = local::to_result(::pread(op.fd, op.buffer, op.size, op.offset));
+			break;
+		case op_kind::write:
+			result = local::to_result(::pwrite(op.fd, op.buffer, op.size, op.offset));
+			break;
+		case op_kind::readv:
+			result = local::to_result(::preadv(
+				op.fd, static_cast<iovec*>(op.buffer), static_cast<int>(op.size), op.offset));
+			break;
+		case op_kind::writev:
+			result = local::to_result(::pwritev(
+				op.fd, static_cast<iovec*>(op.buffer), static_cast<int>(op.size), op.offset));
+			break;
+		case op_kind::recv:
+			result = local::to_result(::recv(op.fd, op.buffer, op.size, op.flags | MSG_DONTWAIT));
+			break;
+		case op_kind::recv_provided:
+		{
+			const int id = take_provided_buffer();
+			if (id < 0)
+			{
+				result = -ENOBUFS;
+				break;
+			}
+			result = local::to_result(
+				::recv(op.fd, provided_buffer(id), m_providedSize, op.flags | MSG_DONTWAIT));
+			if (result < 0)
+			{
+				recycle_provided_buffer(id);
+			}
+			else
+			{
+				op.message->bufferId = id;
+			}
+			break;
+		}
+		case op_kind::send:
+			result = local::to_result(
+				::send(op.fd, op.buffer, op.size, op.flags | MSG_DONTWAIT | MSG_NOSIGNAL));
+			break;
+		case op_kind::recvmsg:
+			result = local::to_result(
+				::recvmsg(op.fd, static_cast<msghdr*>(op.buffer), op.flags | MSG_DONTWAIT));
+			break;
+		case op_kind::sendmsg:
+			result = local::to_result(::sendmsg(
+				op.fd, static_cast<msghdr*>(op.buffer), op.flags | MSG_DONTWAIT | MSG_NOSIGNAL));
+			break;
+		case op_kind::accept:
+			result = local::to_result(::accept4(
+				op.fd,
+				static_cast<sockaddr*>(const_cast<void*>(op.address)),
+				op.addressLengthPtr,
+				op.flags | SOCK_NONBLOCK | SOCK_CLOEXEC));
+			break;
+		case op_kind::openat:
+			result = local::to_result(::openat(
+				op.fd, static_cast<const char*>(op.address), op.flags, static_cast<mode_t>(op.size)));
+			break;
+		case op_kind::statx:
+			result = local::to_result(::statx(
+				op.fd,
+				static_cast<const char*>(op.address),
+				op.flags,
+				static_cast<unsigned>(op.offset),
+				static_cast<struct statx*>(op.buffer)));
+			break;
+		case op_kind::fsync:
+			result = local::to_result(op.flags != 0 ? ::fdatasync(op.fd) : ::fsync(op.fd));
+			break;
+		case op_kind::sync_file_range:
+			result = local::to_result(::sync_file_range(
+				op.fd,
+				static_cast<off64_t>(op.offset),
+				static_cast<off64_t>(op.size),
+				static_cast<unsigned>(op.flags)));
+			break;
+		case op_kind::fallocate:
+			result = local::to_result(::fallocate(
+				op.fd, op.flags, static_cast<off_t>(op.offset), static_cast<off_t>(op.size)));
+			break;
+		case op_kind::madvise:
+			result = local::to_result(::madvise(op.buffer, op.size, op.flags));
+			break;
+		case op_kind::sendfile:
+		{
+			auto offset = static_cast<off_t>(op.offset);
+			result = local::to_result(::sendfile(op.fd, op.flags, &offset, op.size));
+			break;
+		}
+		case op_kind::connect:
+			if (!op.connectStarted)
+			{
+				result = local::to_result(::connect(
+					op.fd, static_cast<const sockaddr*>(op.address), op.addressLength));
+				if (result == -EINPROGRESS)
+				{
+					// Connection completes once the socket becomes writable.
+					op.connectStarted = true;
+					return false;
+				}
+			}
+			else
+			{
+				int error = 0;
+				socklen_t errorLength = sizeof(error);
+				if (::getsockopt(op.fd, SOL_SOCKET, SO_ERROR, &error, &errorLength) < 0)
+				{
+					error = errno;
+				}
+				result = -error;
+			}
+			break;
+		default:
+			break;
+		}
+
+		if (local::would_block(result))
+		{
+			return false;
+		}
+
+		op.message->result = result;
+		return true;
+	}
+
+	bool epoll_queue::start(const pending_op& op) noexcept
+	{
+		std::lock_guard lock{ m_mux };
+
+		pending_op* node;
+		try
+		{
+			node = allocate_op();
+		}
+		catch (const std::bad_alloc&)
+		{
+			op.message->result = -ENOMEM;
+			return false;
+		}
+
+		*node = op;
+		node->next = nullptr;
+
+		fd_state* state;
+		try
+		{
+			state = &m_fds[op.fd];
+		}
+		catch (const std::bad_alloc&)
+		{
+			release_op(node);
+			op.message->result = -ENOMEM;
+			return false;
+		}
+
+		pending_op** tail = is_write(op.kind) ? &state->writers : &state->readers;
+		while (*tail != nullptr)
+		{
+			tail = &(*tail)->next;
+		}
+		*tail = node;
+
+		if (!update_interest(op.fd, *state))
+		{
+			// Couldn't watch the fd, eg. a regular file. Fail the operation
+			// with the epoll_ctl() error left by update_interest().
+			const int result = op.message->result;
+			*tail = nullptr;
+			release_op(node);
+			op.message->result = result;
+			return false;
+		}
+
+		return true;
+	}
+
+	void epoll_queue::start_timeout(io_message& message, const __kernel_timespec& ts, bool absolute) noexcept
+	{
+		using namespace std::chrono;
+
+		const auto duration = duration_cast<steady_clock::duration>(
+			seconds{ ts.tv_sec } + nanoseconds{ ts.tv_nsec });
+		const auto deadline = absolute
+			? steady_clock::time_point{ duration }
+			: steady_clock::now() + duration;
+
+		std::lock_guard lock{ m_mux };
+		try
+		{
+			m_timers.push_back(timer{ deadline, &message });
+		}
+		catch (const std::bad_alloc&)
+		{
+			complete(message, -ENOMEM);
+			return;
+		}
+		std::push_heap(m_timers.begin(), m_timers.end(), local::timer_later{});
+		rearm_timer();
+	}
+
+	void epoll_queue::remove_timeout(io_message& message) noexcept
+	{
+		std::lock_guard lock{ m_mux };
+		auto it = std::find_if(m_timers.begin(), m_timers.end(), [&](const timer& t) {
+			return t.message == &message;
+		});
+		if (it == m_timers.end())
+		{
+			// Already expired.
+			return;
+		}
+
+		m_timers.erase(it);
+		std::make_heap(m_timers.begin(), m_timers.end(), local::timer_later{});
+		complete(message, -ECANCELED);
+		rearm_timer();
+	}
+
+	void epoll_queue::cancel_op(io_message& message) noexcept
+	{
+		std::lock_guard lock{ m_mux };
+		for (auto& [fd, state] : m_fds)
+		{
+			for (pending_op** list : { &state.readers, &state.writers })
+			{
+				for (pending_op** link = list; *link != nullptr; link = &(*link)->next)
+				{
+					pending_op* op = *link;
+					if (op->message == &message)
+					{
+						*link = op->next;
+						release_op(op);
+						complete(message, -ECANCELED);
+						update_interest(fd, state);
+						return;
+					}
+				}
+			}
+		}
+	}
+
+	void epoll_queue::close_fd(int fd) noexcept
+	{
+		std::lock_guard lock{ m_mux };
+		auto it = m_fds.find(fd);
+		if (it == m_fds.end())
+		{
+			return;
+		}
+
+		for (pending_op* list : { it->second.readers, it->second.writers })
+		{
+			while (list != nullptr)
+			{
+				pending_op* next = list->next;
+				complete(*list->message, -ECANCELED);
+				release_op(list);
+				list = next;
+			}
+		}
+		if (it->second.registered)
+		{
+			(void)epoll_ctl(m_epollFd.fd(), EPOLL_CTL_DEL, fd, nullptr);
+		}
+		m_fds.erase(it);
+	}
+
+	epoll_queue::pending_op* epoll_queue::allocate_op()
+	{
+		if (m_freeOps == nullptr)
+		{
+			m_opStorage.emplace_back(std::make_unique<pending_op>());
+			return m_opStorage.back().get();
+		}
+
+		pending_op* op = m_freeOps;
+		m_freeOps = op->next;
+		return op;
+	}
+
+	void epoll_queue::release_op(pending_op* op) noexcept
+	{
+		op->next = m_freeOps;
+		m_freeOps = op;
+	}
+
+	bool epoll_queue::update_interest(int fd, fd_state& state) noexcept
+	{
+		std::uint32_t events = 0;
+		if (state.readers != nullptr)
+		{
+			events |= EPOLLIN | EPOLLRDHUP;
+		}
+		if (state.writers != nullptr)
+		{
+			events |= EPOLLOUT;
+		}
+		if (events == 0)
+		{
+			// The one-shot registration is already disarmed, or will
+			// report an event that finds nothing left to retry.
+			return true;
+		}
+
+		epoll_event ev{};
+		ev.events = events | EPOLLONESHOT;
+		ev.data.fd = fd;
+
+		int op = state.registered ? EPOLL_CTL_MOD : EPOLL_CTL_ADD;
+		int ret = epoll_ctl(m_epollFd.fd(), op, fd, &ev);
+		if (ret < 0 && op == EPOLL_CTL_MOD && errno == ENOENT)
+		{
+			// The fd was closed without a close() transaction and the
+			// number has since been reused.
+			ret = epoll_ctl(m_epollFd.fd(), EPOLL_CTL_ADD, fd, &ev);
+		}
+		else if (ret < 0 && op == EPOLL_CTL_ADD && errno == EEXIST)
+		{
+			ret = epoll_ctl(m_epollFd.fd(), EPOLL_CTL_MOD, fd, &ev);
+		}
+
+		if (ret < 0)
+		{
+			const int result = -errno;
+			for (pending_op* list : { state.readers, state.writers })
+			{
+				for (; list != nullptr; list = list->next)
+				{
+					list->message->result = result;
+				}
+			}
+			return false;
+		}
+
+		state.registered = true;
+		return true;
+	}
+
+	void epoll_queue::process_ready(int fd, std::uint32_t events) noexcept
+	{
+		auto it = m_fds.find(fd);
+		if (it == m_fds.end())
+		{
+			return;
+		}
+
+		fd_state& state = it->second;
+
+		const auto retry = [&](pending_op*& head) {
+			while (head != nullptr)
+			{
+				pending_op* op = head;
+				if (!try_perform(*op))
+				{
+					break;
+				}
+				head = op->next;
+				io_message& message = *op->message;
+				release_op(op);
+				m_ready.push_back(&message);
+			}
+		};
+
+		const std::uint32_t errorEvents = EPOLLERR | EPOLLHUP;
+		if (events & (EPOLLIN | EPOLLRDHUP | errorEvents))
+		{
+			retry(state.readers);
+		}
+		if (events & (EPOLLOUT | errorEvents))
+		{
+			retry(state.writers);
+		}
+
+		if (!update_interest(fd, state))
+		{
+			for (pending_op** list : { &state.readers, &state.writers })
+			{
+				while (*list != nullptr)
+				{
+					pending_op* op = *list;
+					*list = op->next;
+					m_ready.push_back(op->message);
+					release_op(op);
+				}
+			}
+		}
+
+		// Completions pushed above may be more than this thread will take.
+		if (m_waitingThreads != 0)
+		{
+			notify();
+		}
+	}
+
+	void epoll_queue::process_timers() noexcept
+	{
+		const auto now = std::chrono::steady_clock::now();
+		while (!m_timers.empty() && m_timers.front().deadline <= now)
+		{
+			std::pop_heap(m_timers.begin(), m_timers.end(), local::timer_later{});
+			io_message& message = *m_timers.back().message;
+			m_timers.pop_back();
+			complete(message, -ETIME);
+		}
+		rearm_timer();
+	}
+
+	void epoll_queue::rearm_timer() noexcept
+	{
+		using namespace std::chrono;
+
+		const auto deadline = m_timers.empty()
+			? steady_clock::time_point::max()
+			: m_timers.front().deadline;
+		if (deadline == m_timerDeadline)
+		{
+			return;
+		}
+		m_timerDeadline = deadline;
+
+		itimerspec spec{};
+		if (!m_timers.empty())
+		{
+			const auto sinceEpoch = deadline.time_since_epoch();
+			const auto secs = duration_cast<seconds>(sinceEpoch);
+			spec.it_value.tv_sec = secs.count();
+			spec.it_value.tv_nsec = duration_cast<nanoseconds>(sinceEpoch - secs).count();
+			if (spec.it_value.tv_sec == 0 && spec.it_value.tv_nsec == 0)
+			{
+				// A zero it_value would disarm the timer.
+				spec.it_value.tv_nsec = 1;
+			}
+		}
+		(void)timerfd_settime(m_timerFd.fd(), TFD_TIMER_ABSTIME, &spec, nullptr);
+	}
+
+	void epoll_queue::complete(io_message& message, int result) noexcept
+	{
+		message.result = result;
+		try
+		{
+			m_ready.push_back(&message);
+		}
+		catch (const std::bad_alloc&)
+		{
+			std::terminate();
+		}
+		if (m_waitingThreads != 0)
+		{
+			notify();
+		}
+	}
+
+	void epoll_queue::notify() noexcept
+	{
+		(void)eventfd_write(m_wakeUpFd.fd(), 1);
+	}
+
+	io_transaction::io_transaction(epoll_queue& queue, io_message& message) noexcept
+		: m_queue(queue)
+		, m_message(message)
+	{
+		m_op.message = &message;
+	}
+
+	bool io_transaction::commit() noexcept
+	{
+		using op_kind = epoll_queue::op_kind;
+
+		if (m_linked)
+		{
+			const int result = m_linkBroken ? m_linkError : perform_linked();
+			m_message.result = m_linkError < 0 ? m_linkError : result;
+			return false;
+		}
+
+		switch (m_op.kind)
+		{
+		case op_kind::nop:
+			m_queue.wake_up(m_message);
+			return true;
+		case op_kind::timeout:
+			m_queue.start_timeout(m_message, m_timeout, m_absoluteTimeout);
+			return true;
+		case op_kind::timeout_remove:
+			// m_message is the timeout being removed, not this request.
+			m_queue.remove_timeout(m_message);
+			return false;
+		case op_kind::cancel:
+			// m_message is the operation being cancelled, not this request.
+			m_queue.cancel_op(m_message);
+			return false;
+		case op_kind::close:
+			m_queue.close_fd(m_op.fd);
+			m_message.result = local::to_result(::close(m_op.fd));
+			return false;
+		default:
+			break;
+		}
+
+		if (m_queue.try_perform(m_op))
+		{
+			return false;
+		}
+
+		return m_queue.start(m_op);
+	}
+
+	io_transaction& io_transaction::read(int fd, void* buffer, size_t size, size_t offset) noexcept
+	{
+		m_op.kind = epoll_queue::op_kind::read;
+		m_op.fd = fd;
+		m_op.buffer = buffer;
+		m_op.size = size;
+		m_op.offset = offset;
+		return *this;
+	}
+
+	io_transaction& io_transaction::write(int fd, const void* buffer, size_t size, size_t offset) noexcept
+	{
+		m_op.kind = epoll_queue::op_kind::write;
+		m_op.fd = fd;
+		m_op.buffer = const_cast<void*>(buffer);
+		m_op.size = size;
+		m_op.offset = offset;
+		return *this;
+	}
+
+	io_transaction& io_transaction::read_fixed(
+		int fd, void* buffer, size_t size, size_t offset, int, iovec&) noexcept
+	{
+		return read(fd, buffer, size, offset);
+	}
+
+	io_transaction& io_transaction::write_fixed(
+		int fd, const void* buffer, size_t size, size_t offset, int, iovec&) noexcept
+	{
+		return write(fd, buffer, size, offset);
+	}
+
+	io_transaction& io_transaction::readv(int fd, iovec* vec, size_t count, size_t offset) noexcept
+	{
+		m_op.kind = epoll_queue::op_kind::readv;
+		m_op.fd = fd;
+		m_op.buffer = vec;
+		m_op.size = count;
+		m_op.offset = offset;
+		return *this;
+	}
+
+	io_transaction& io_transaction::writev(int fd, iovec* vec, size_t count, size_t offset) noexcept
+	{
+		m_op.kind = epoll_queue::op_kind::writev;
+		m_op.fd = fd;
+		m_op.buffer = vec;
+		m_op.size = count;
+		m_op.offset = offset;
+		return *this;
+	}
+
+	io_transaction& io_transaction::recv(int fd, void* buffer, size_t size, int flags) noexcept
+	{
+		m_op.kind = epoll_queue::op_kind::recv;
+		m_op.fd = fd;
+		m_op.buffer = buffer;
+		m_op.size = size;
+		m_op.flags = flags;
+		return *this;
+	}
+
+	io_transaction& io_transaction::send(int fd, const void* buffer, size_t size, int flags) noexcept
+	{
+		m_op.kind = epoll_queue::op_kind::send;
+		m_op.fd = fd;
+		m_op.buffer = const_cast<void*>(buffer);
+		m_op.size = size;
+		m_op.flags = flags;
+		return *this;
+	}
+
+	io_transaction& io_transaction::send_zc(int fd, const void* buffer, size_t size, int flags, int) noexcept
+	{
+		return send(fd, buffer, size, flags);
+	}
+
+	io_transaction& io_transaction::recv_provided(int fd, int flags) noexcept
+	{
+		m_op.kind = epoll_queue::op_kind::recv_provided;
+		m_op.fd = fd;
+		m_op.flags = flags;
+		return *this;
+	}
+
+	io_transaction& io_transaction::recvmsg(int fd, msghdr* msg, int flags) noexcept
+	{
+		m_op.kind = epoll_queue::op_kind::recvmsg;
+		m_op.fd = fd;
+		m_op.buffer = msg;
+		m_op.flags = flags;
+		return *this;
+	}
+
+	io_transaction& io_transaction::sendmsg(int fd, msghdr* msg, int flags) noexcept
+	{
+		m_op.kind = epoll_queue::op_kind::sendmsg;
+		m_op.fd = fd;
+		m_op.buffer = msg;
+		m_op.flags = flags;
+		return *this;
+	}
+
+	io_transaction& io_transaction::connect(int fd, const void* to, size_t to_size) noexcept
+	{
+		m_op.kind = epoll_queue::op_kind::connect;
+		m_op.fd = fd;
+		m_op.address = to;
+		m_op.addressLength = static_cast<socklen_t>(to_size);
+		return *this;
+	}
+
+	io_transaction& io_transaction::close(int fd) noexcept
+	{
+		m_op.kind = epoll_queue::op_kind::close;
+		m_op.fd = fd;
+		return *this;
+	}
+
+	io_transaction& io_transaction::openat(int dirfd, const char* path, int flags, mode_t mode) noexcept
+	{
+		m_op.kind = epoll_queue::op_kind::openat;
+		m_op.fd = dirfd;
+		m_op.address = path;
+		m_op.flags = flags;
+		m_op.size = mode;
+		return *this;
+	}
+
+	io_transaction& io_transaction::statx(
+		int dirfd, const char* path, int flags, unsigned mask, struct statx* buffer) noexcept
+	{
+		m_op.kind = epoll_queue::op_kind::statx;
+		m_op.fd = dirfd;
+		m_op.address = path;
+		m_op.flags = flags;
+		m_op.offset = mask;
+		m_op.buffer = buffer;
+		return *this;
+	}
+
+	io_transaction& io_transaction::accept(int fd, const void* to, socklen_t* to_size, int flags) noexcept
+	{
+		m_op.kind = epoll_queue::op_kind::accept;
+		m_op.fd = fd;
+		m_op.address = to;
+		m_op.addressLengthPtr = to_size;
+		m_op.flags = flags;
+		return *this;
+	}
+
+	io_transaction& io_transaction::timeout(__kernel_timespec* ts, bool absolute) noexcept
+	{
+		m_op.kind = epoll_queue::op_kind::timeout;
+		m_timeout = *ts;
+		m_absoluteTimeout = absolute;
+		return *this;
+	}
+
+	io_transaction& io_transaction::timeout_remove(int) noexcept
+	{
+		m_op.kind = epoll_queue::op_kind::timeout_remove;
+		return *this;
+	}
+
+	io_transaction& io_transaction::fsync(int fd, bool dataOnly) noexcept
+	{
+		m_op.kind = epoll_queue::op_kind::fsync;
+		m_op.fd = fd;
+		m_op.flags = dataOnly ? 1 : 0;
+		return *this;
+	}
+
+	io_transaction& io_transaction::sync_file_range(
+		int fd, std::uint64_t offset, std::uint32_t size, unsigned flags) noexcept
+	{
+		m_op.kind = epoll_queue::op_kind::sync_file_range;
+		m_op.fd = fd;
+		m_op.offset = offset;
+		m_op.size = size;
+		m_op.flags = static_cast<int>(flags);
+		return *this;
+	}
+
+	io_transaction& io_transaction::fallocate(int fd, int mode, std::uint64_t offset, std::uint64_t size) noexcept
+	{
+		m_op.kind = epoll_queue::op_kind::fallocate;
+		m_op.fd = fd;
+		m_op.offset = offset;
+		m_op.size = static_cast<std::size_t>(size);
+		m_op.flags = mode;
+		return *this;
+	}
+
+	io_transaction& io_transaction::madvise(void* address, std::uint32_t length, int advice) noexcept
+	{
+		m_op.kind = epoll_queue::op_kind::madvise;
+		m_op.buffer = address;
+		m_op.size = length;
+		m_op.flags = advice;
+		return *this;
+	}
+
+	io_transaction& io_transaction::sendfile(int outFd, int inFd, std::uint64_t offset, std::size_t size) noexcept
+	{
+		m_op.kind = epoll_queue::op_kind::sendfile;
+		m_op.fd = outFd;
+		// The fd to wait on is outFd, the input is a file and never blocks.
+		m_op.flags = inFd;
+		m_op.offset = offset;
+		m_op.size = size;
+		return *this;
+	}
+
+	io_transaction& io_transaction::nop() noexcept
+	{
+		m_op.kind = epoll_queue::op_kind::nop;
+		return *this;
+	}
+
+	io_transaction& io_transaction::cancel(int) noexcept
+	{
+		m_op.kind = epoll_queue::op_kind::cancel;
+		return *this;
+	}
+
+	io_transaction& io_transaction::link(bool hard) noexcept
+	{
+		using op_kind = epoll_queue::op_kind;
+
+		m_linked = true;
+		if (!m_linkBroken)
+		{
+			const int result = perform_linked();
+
+			// As with io_uring, a short read or write cancels the rest of
+			// a soft linked chain.
+			std::size_t expected = 0;
+			switch (m_op.kind)
+			{
+			case op_kind::read:
+			case op_kind::write:
+				expected = m_op.size;
+				break;
+			case op_kind::readv:
+			case op_kind::writev:
+				for (std::size_t i = 0; i < m_op.size; ++i)
+				{
+					expected += static_cast<const iovec*>(m_op.buffer)[i].iov_len;
+				}
+				break;
+			default:
+				break;
+			}
+
+			if (result < 0)
+			{
+				m_linkError = m_linkError < 0 ? m_linkError : result;
+				m_linkBroken = !hard;
+			}
+			else if (!hard && static_cast<std::size_t>(result) < expected)
+			{
+				m_linkError = m_linkError < 0 ? m_linkError : -EIO;
+				m_linkBroken = true;
+			}
+		}
+
+		m_op = epoll_queue::pending_op{};
+		m_op.message = &m_message;
+		return *this;
+	}
+
+	int io_transaction::perform_linked() noexcept
+	{
+		if (m_op.kind == epoll_queue::op_kind::close)
+		{
+			m_queue.close_fd(m_op.fd);
+			return local::to_result(::close(m_op.fd));
+		}
+		if (!m_queue.try_perform(m_op))
+		{
+			return -EAGAIN;
+		}
+		return std::exchange(m_message.result, -1);
+	}
+}  // namespace cppcoro::detail::lnx
@@ -1,14 +1,211 @@
 #include <cppcoro/detail/linux_uring_queue.hpp>
 
+#include <algorithm>
+#include <cassert>
+#include <new>
+#include <thread>
+
+#include <fcntl.h>
+#include <poll.h>
+#include <sys/mman.h>
+#include <sys/resource.h>
+#include <unistd.h>
+
 namespace cppcoro::detail::lnx {
 
+    namespace {
+        namespace local {
+            std::atomic<std::uint64_t> nextQueueId{1};
+
+            // Cancel a request that doesn't exist: 5.5 reports -ENOENT, 5.4
+            // rejects IORING_OP_ASYNC_CANCEL itself with -EINVAL.
+            bool async_cancel_supported(io_uring &ring) noexcept {
+                auto *sqe = io_uring_get_sqe(&ring);
+                if (sqe == nullptr) {
+                    return false;
+                }
+                io_uring_prep_cancel(sqe, &ring, 0);
+                io_uring_sqe_set_data(sqe, nullptr);
+                io_uring_cqe *cqe = nullptr;
+                if (io_uring_submit_and_wait(&ring, 1) < 1 || io_uring_wait_cqe(&ring, &cqe) != 0) {
+                    return false;
+                }
+                const bool supported = cqe->res != -EINVAL;
+                io_uring_cqe_seen(&ring, cqe);
+                return supported;
+            }
+
+            uring_capabilities probe_capabilities(io_uring &ring) noexcept {
+                auto *probe = io_uring_get_probe_ring(&ring);
+                if (probe == nullptr) {
+                    // IORING_REGISTER_PROBE arrived in 5.6 along with most of
+                    // these opcodes. Assume only what 5.4 provides, plus the
+                    // opcodes 5.5 added alongside ASYNC_CANCEL if it has that.
+                    uring_capabilities capabilities{
+                        false, false, false, false, false, false, false, false, false, false, false, false, false, false, false};
+                    const bool kernel55 = async_cancel_supported(ring);
+                    capabilities.accept = kernel55;
+                    capabilities.connect = kernel55;
+                    capabilities.timeout_remove = kernel55;
+                    capabilities.async_cancel = kernel55;
+                    return capabilities;
+                }
+                const auto supported = [&](int op) {
+                    return io_uring_opcode_supported(probe, op) != 0;
+                };
+                uring_capabilities capabilities;
+                capabilities.read_write = supported(IORING_OP_READ) && supported(IORING_OP_WRITE);
+                capabilities.send = supported(IORING_OP_SEND);
+                capabilities.recv = supported(IORING_OP_RECV);
+                capabilities.accept = supported(IORING_OP_ACCEPT);
+                capabilities.connect = supported(IORING_OP_CONNECT);
+                capabilities.close = supported(IORING_OP_CLOSE);
+                capabilities.timeout_remove = supported(IORING_OP_TIMEOUT_REMOVE);
+                capabilities.async_cancel = supported(IORING_OP_ASYNC_CANCEL);
+                capabilities.send_zc = supported(IORING_OP_SEND_ZC);
+                capabilities.fallocate = supported(IORING_OP_FALLOCATE);
+                capabilities.openat = supported(IORING_OP_OPENAT);
+                capabilities.statx = supported(IORING_OP_STATX);
+                capabilities.madvise = supported(IORING_OP_MADVISE);
+                capabilities.splice = supported(IORING_OP_SPLICE);
+                capabilities.buffer_ring = true;
+                io_uring_free_probe(probe);
+                return capabilities;
+            }
+
+            // io_uring_buf_ring_add() indexes bufs[], which the kernel header
+            // declares via __DECLARE_FLEX_ARRAY; in C++ its empty leading
+            // struct shifts bufs[] by 8 bytes. Index the ring as a plain
+            // io_uring_buf array instead, which is the layout the kernel reads.
+            void add_to_buf_ring(
+                io_uring_buf_ring *br, unsigned entries, void *addr, unsigned len, int bid, int offset) noexcept {
+                auto *bufs = reinterpret_cast<io_uring_buf *>(br);
+                auto &buf = bufs[(br->tail + offset) & io_uring_buf_ring_mask(entries)];
+                buf.addr = reinterpret_cast<std::uintptr_t>(addr);
+                buf.len = len;
+                buf.bid = static_cast<std::uint16_t>(bid);
+            }
+
+            // Account for a completion of a chain committed with
+            // io_transaction::link(), returning whether it's the last one.
+            bool complete_link(io_message &message, int result) noexcept {
+                if (message.result == -1 && result < 0) {
+                    // Only cancel() presets -ECANCELED, otherwise a link is
+                    // cancelled because the read or write before it was short.
+                    message.result = result == -ECANCELED ? -EIO : result;
+                }
+                return --message.pendingCompletions == 0;
+            }
+        }
+    }
+
+    /// A ring owned by a single event loop thread.
+    class uring_queue::thread_ring : public uring_queue::ring_state {
+    public:
+        std::thread::id owner;
+
+        /// Whether the ring was set up with IORING_SETUP_DEFER_TASKRUN, in
+        /// which case completions are only posted when the owner enters the
+        /// kernel.
+        bool deferTaskrun = false;
+
+        /// user_data of the poll on the shared ring's file descriptor.
+        io_message doorbell;
+
+        /// user_data of MSG_RING completions posted by other threads.
+        io_message remoteDoorbell;
+
+        // Cancellation requests from other threads, to be submitted by the
+        // owner.
+        std::atomic<bool> remotePending{false};
+        std::mutex remoteMux;
+        std::vector<cancel_request> remoteRequests;
+        std::vector<cancel_request> remoteRequestsScratch;
+
+        ~thread_ring() { io_uring_queue_exit(&ring); }
+    };
+
+    thread_local uring_queue *uring_queue::s_dispatchingQueue = nullptr;
+    thread_local uring_queue::thread_ring *uring_queue::s_dispatchingRing = nullptr;
+    thread_local uring_queue::thread_ring *uring_queue::s_threadRing = nullptr;
+    thread_local std::uint64_t uring_queue::s_threadRingQueueId = 0;
+
+    uring_queue::dispatch_scope::dispatch_scope(uring_queue &queue) noexcept
+        : m_previousQueue(std::exchange(s_dispatchingQueue, &queue))
+        , m_previousRing(std::exchange(s_dispatchingRing, queue.cached_thread_ring())) {
+    }
+
+    uring_queue::dispatch_scope::~dispatch_scope() {
+        s_dispatchingQueue = m_previousQueue;
+        s_dispatchingRing = m_previousRing;
+    }
+
     io_transaction::io_transaction(io_queue &queue, io_message &message) noexcept
-        : m_queue{queue}, m_message{message}, m_sqeLock{queue.m_sqeMux}, m_sqe{queue.get_sqe()} {
+        : io_transaction(queue, message, queue.submission_ring()) {
+    }
+
+    io_transaction::io_transaction(
+        io_queue &queue, io_message &message, uring_queue::ring_state &ring, unsigned length) noexcept
+        : m_queue{queue}, m_message{message}, m_ring{ring}, m_sqeLock{queue.m_sqeMux, std::defer_lock}, m_sqe{nullptr} {
+        if (&m_ring == &queue.m_sharedRing) {
+            m_sqeLock.lock();
+        } else {
+            // Stale cancellation requests must reach the kernel before any new
+            // operation that may reuse the same message address.
+            queue.process_remote_requests(static_cast<uring_queue::thread_ring &>(m_ring));
+        }
+        if (length > 1) {
+            // A chain split across two submissions would be cut short, make
+            // room for all of it now.
+            if (io_uring_sq_space_left(&m_ring.ring) < length
+                && m_ring.pendingSqes.load(std::memory_order_relaxed) != 0) {
+                queue.submit_pending(m_ring);
+            }
+            if (io_uring_sq_space_left(&m_ring.ring) < length) {
+                return;
+            }
+            m_linksLeft = length - 1;
+        }
+        m_sqe = queue.get_sqe(m_ring);
+    }
+
+    void io_transaction::prep_ignored() noexcept {
+        io_uring_prep_nop(m_sqe);
+        io_uring_sqe_set_data(m_sqe, nullptr);
+    }
+
+    void io_transaction::use_fixed_file() noexcept {
+        // The fd of these is a plain fd, or a directory fd.
+        const bool takesFixedFile = m_sqe->opcode != IORING_OP_CLOSE
+            && m_sqe->opcode != IORING_OP_OPENAT
+            && m_sqe->opcode != IORING_OP_STATX;
+        if (takesFixedFile
+            && &m_ring == &m_queue.m_sharedRing
+            && m_queue.is_registered_file(m_sqe->fd)) {
+            // The slot in the fixed file table is the fd itself.
+            m_sqe->flags |= IOSQE_FIXED_FILE;
+        }
     }
 
     [[nodiscard]] bool io_transaction::commit() noexcept {
         if (m_sqe != nullptr) {
-            if (int err = m_queue.submit(); err < 0) {
+            use_fixed_file();
+            if (m_linkCount != 0) {
+                // Set before any completion of the chain can be reaped.
+                m_message.pendingCompletions = m_linkCount + 1;
+            }
+            int err = m_queue.submit(m_ring, m_linkCount + 1);
+            if (m_forwardCancel) {
+                if (m_sqeLock.owns_lock()) {
+                    m_sqeLock.unlock();
+                }
+                m_queue.forward_cancel(m_cancelRequest, &m_ring);
+            }
+            if (m_completed) {
+                return false;
+            }
+            if (err < 0) {
+                m_message.pendingCompletions = 0;
                 m_message.result = err;
                 return false;
             }
@@ -20,17 +217,51 @@ namespace cppcoro::detail::lnx {
         }
     }
 
-    io_transaction &io_transaction::read(int fd, void *buffer, size_t size, size_t offset) noexcept {
+    io_transaction &io_transaction::read(int fd, void *buffer, size_t size, size_t offset, iovec &fallbackVec) noexcept {
+        if (m_sqe) {
+            if (m_queue.m_capabilities.read_write) {
+                io_uring_prep_read(m_sqe, fd, buffer, size, offset);
+            } else {
+                fallbackVec = {buffer, size};
+                io_uring_prep_readv(m_sqe, fd, &fallbackVec, 1, offset);
+            }
+            io_uring_sqe_set_data(m_sqe, &m_message);
+        }
+        return *this;
+    }
+
+    io_transaction &io_transaction::write(int fd, const void *buffer, size_t size, size_t offset, iovec &fallbackVec) noexcept {
+        if (m_sqe) {
+            if (m_queue.m_capabilities.read_write) {
+                io_uring_prep_write(m_sqe, fd, buffer, size, offset);
+            } else {
+                fallbackVec = {const_cast<void *>(buffer), size};
+                io_uring_prep_writev(m_sqe, fd, &fallbackVec, 1, offset);
+            }
+            io_uring_sqe_set_data(m_sqe, &m_message);
+        }
+        return *this;
+    }
+
+    io_transaction &io_transaction::read_fixed(
+        int fd, void *buffer, size_t size, size_t offset, int bufferIndex, iovec &fallbackVec) noexcept {
+        if (bufferIndex < 0 || &m_ring != &m_queue.m_sharedRing) {
+            return read(fd, buffer, size, offset, fallbackVec);
+        }
         if (m_sqe) {
-            io_uring_prep_read(m_sqe, fd, buffer, size, offset);
+            io_uring_prep_read_fixed(m_sqe, fd, buffer, size, offset, bufferIndex);
             io_uring_sqe_set_data(m_sqe, &m_message);
         }
         return *this;
     }
 
-    io_transaction &io_transaction::write(int fd, const void *buffer, size_t size, size_t offset) noexcept {
+    io_transaction &io_transaction::write_fixed(
+        int fd, const void *buffer, size_t size, size_t offset, int bufferIndex, iovec &fallbackVec) noexcept {
+        if (bufferIndex < 0 || &m_ring != &m_queue.m_sharedRing) {
+            return write(fd, buffer, size, offset, fallbackVec);
+        }
         if (m_sqe) {
-            io_uring_prep_write(m_sqe, fd, buffer, size, offset);
+            io_uring_prep_write_fixed(m_sqe, fd, buffer, size, offset, bufferIndex);
             io_uring_sqe_set_data(m_sqe, &m_message);
         }
         return *this;
@@ -52,6 +283,31 @@ namespace cppcoro::detail::lnx {
         return *this;
     }
 
+    io_transaction &io_transaction::send_zc(int fd, const void *buffer, size_t size, int flags, int bufferIndex) noexcept {
+        if (!m_queue.m_capabilities.send_zc) {
+            return send(fd, buffer, size, flags);
+        }
+        if (m_sqe) {
+            if (bufferIndex >= 0 && &m_ring == &m_queue.m_sharedRing) {
+                io_uring_prep_send_zc_fixed(m_sqe, fd, buffer, size, flags, 0, bufferIndex);
+            } else {
+                io_uring_prep_send_zc(m_sqe, fd, buffer, size, flags, 0);
+            }
+            io_uring_sqe_set_data(m_sqe, &m_message);
+        }
+        return *this;
+    }
+
+    io_transaction &io_transaction::recv_provided(int fd, int flags) noexcept {
+        if (m_sqe) {
+            io_uring_prep_recv(m_sqe, fd, nullptr, m_queue.m_providedSize, flags);
+            m_sqe->flags |= IOSQE_BUFFER_SELECT;
+            m_sqe->buf_group = uring_queue::provided_buffer_group;
+            io_uring_sqe_set_data(m_sqe, &m_message);
+        }
+        return *this;
+    }
+
     io_transaction &io_transaction::readv(int fd, iovec *vec, size_t count, size_t offset) noexcept {
         if (m_sqe) {
             io_uring_prep_readv(m_sqe, fd, vec, count, offset);
@@ -94,8 +350,44 @@ namespace cppcoro::detail::lnx {
 
     io_transaction &io_transaction::close(int fd) noexcept {
         if (m_sqe) {
-            io_uring_prep_close(m_sqe, fd);
-            io_uring_sqe_set_data(m_sqe, &m_message);
+            if (m_queue.m_capabilities.close) {
+                io_uring_prep_close(m_sqe, fd);
+                io_uring_sqe_set_data(m_sqe, &m_message);
+            } else {
+                m_message.result = ::close(fd) < 0 ? -errno : 0;
+                m_completed = true;
+                prep_ignored();
+            }
+        }
+        return *this;
+    }
+
+    io_transaction &io_transaction::openat(int dirfd, const char *path, int flags, mode_t mode) noexcept {
+        if (m_sqe) {
+            if (m_queue.m_capabilities.openat) {
+                io_uring_prep_openat(m_sqe, dirfd, path, flags, mode);
+                io_uring_sqe_set_data(m_sqe, &m_message);
+            } else {
+                const int fd = ::openat(dirfd, path, flags, mode);
+                m_message.result = fd < 0 ? -errno : fd;
+                m_completed = true;
+                prep_ignored();
+            }
+        }
+        return *this;
+    }
+
+    io_transaction &io_transaction::statx(
+        int dirfd, const char *path, int flags, unsigned mask, struct statx *buffer) noexcept {
+        if (m_sqe) {
+            if (m_queue.m_capabilities.statx) {
+                io_uring_prep_statx(m_sqe, dirfd, path, flags, mask, buffer);
+                io_uring_sqe_set_data(m_sqe, &m_message);
+            } else {
+                m_message.result = ::statx(dirfd, path, flags, mask, buffer) < 0 ? -errno : 0;
+                m_completed = true;
+                prep_ignored();
+            }
         }
         return *this;
     }
@@ -108,6 +400,23 @@ namespace cppcoro::detail::lnx {
         return *this;
     }
 
+    io_transaction &io_transaction::accept_multishot(int fd, int flags) noexcept {
+        assert(m_message.is_multishot());
+        if (m_sqe) {
+            io_uring_prep_multishot_accept(m_sqe, fd, nullptr, nullptr, flags);
+            io_uring_sqe_set_data(m_sqe, &m_message);
+        }
+        return *this;
+    }
+
+    io_transaction &io_transaction::poll(int fd, unsigned events) noexcept {
+        if (m_sqe) {
+            io_uring_prep_poll_add(m_sqe, fd, events);
+            io_uring_sqe_set_data(m_sqe, &m_message);
+        }
+        return *this;
+    }
+
     io_transaction &io_transaction::timeout(__kernel_timespec *ts, bool absolute) noexcept {
         if (m_sqe) {
             io_uring_prep_timeout(m_sqe, ts, 0, absolute ? IORING_TIMEOUT_ABS : 0);
@@ -117,8 +426,21 @@ namespace cppcoro::detail::lnx {
     }
 
     io_transaction &io_transaction::timeout_remove(int flags) noexcept {
-        if (m_sqe) {
+        if (m_sqe && !m_queue.m_capabilities.timeout_remove) {
+            if (m_queue.m_capabilities.async_cancel) {
+                // ASYNC_CANCEL finds timeouts too.
+                return cancel();
+            }
+            // Leave the timeout to expire.
+            prep_ignored();
+        } else if (m_sqe) {
             io_uring_prep_timeout_remove(m_sqe, reinterpret_cast<uint64_t>(&m_message), flags);
+            // The completion of the removal itself carries no message, the
+            // removed timeout completes with -ECANCELED on its own.
+            io_uring_sqe_set_data(m_sqe, nullptr);
+            // The timeout may have been armed on another thread's ring.
+            m_forwardCancel = m_queue.m_ringPerThread.load(std::memory_order_relaxed);
+            m_cancelRequest = {IORING_OP_TIMEOUT_REMOVE, &m_message, flags};
         }
         return *this;
     }
@@ -131,61 +453,681 @@ namespace cppcoro::detail::lnx {
         return *this;
     }
 
+    io_transaction &io_transaction::fsync(int fd, bool dataOnly) noexcept {
+        if (m_sqe) {
+            io_uring_prep_fsync(m_sqe, fd, dataOnly ? IORING_FSYNC_DATASYNC : 0);
+            io_uring_sqe_set_data(m_sqe, &m_message);
+        }
+        return *this;
+    }
+
+    io_transaction &io_transaction::sync_file_range(
+        int fd, std::uint64_t offset, std::uint32_t size, unsigned flags) noexcept {
+        if (m_sqe) {
+            io_uring_prep_sync_file_range(m_sqe, fd, size, offset, static_cast<int>(flags));
+            io_uring_sqe_set_data(m_sqe, &m_message);
+        }
+        return *this;
+    }
+
+    io_transaction &io_transaction::fallocate(int fd, int mode, std::uint64_t offset, std::uint64_t size) noexcept {
+        if (m_sqe) {
+            if (m_queue.m_capabilities.fallocate) {
+                io_uring_prep_fallocate(m_sqe, fd, mode, offset, size);
+                io_uring_sqe_set_data(m_sqe, &m_message);
+            } else {
+                m_message.result = ::fallocate(fd, mode, static_cast<off_t>(offset), static_cast<off_t>(size)) < 0
+                    ? -errno : 0;
+                m_completed = true;
+                prep_ignored();
+            }
+        }
+        return *this;
+    }
+
+    io_transaction &io_transaction::madvise(void *address, std::uint32_t length, int advice) noexcept {
+        if (m_sqe) {
+            if (m_queue.m_capabilities.madvise) {
+                io_uring_prep_madvise(m_sqe, address, length, advice);
+                io_uring_sqe_set_data(m_sqe, &m_message);
+            } else {
+                m_message.result = ::madvise(address, length, advice) < 0 ? -errno : 0;
+                m_completed = true;
+                prep_ignored();
+            }
+        }
+        return *this;
+    }
+
+    io_transaction &io_transaction::splice(
+        int fdIn, std::int64_t offsetIn, int fdOut, std::int64_t offsetOut, std::uint32_t size, unsigned flags) noexcept {
+        if (m_sqe) {
+            io_uring_prep_splice(m_sqe, fdIn, offsetIn, fdOut, offsetOut, size, flags);
+            io_uring_sqe_set_data(m_sqe, &m_message);
+        }
+        return *this;
+    }
+
+    io_transaction &io_transaction::link(bool hard) noexcept {
+        if (m_sqe) {
+            assert(m_linksLeft != 0 && "more operations than reserved by linked_transaction()");
+            assert(!m_completed && "operation can't be linked");
+            use_fixed_file();
+            m_sqe->flags |= hard ? IOSQE_IO_HARDLINK : IOSQE_IO_LINK;
+            --m_linksLeft;
+            ++m_linkCount;
+            // Can't fail, the SQEs were reserved.
+            m_sqe = m_queue.get_sqe(m_ring);
+        }
+        return *this;
+    }
+
     io_transaction &io_transaction::cancel(int flags) noexcept {
         if (m_sqe) {
-            io_uring_prep_cancel(m_sqe, &m_message, flags);
+            // Without ASYNC_CANCEL, cancellable operations wait in a poll
+            // (see uring_capabilities::async_cancel), which POLL_REMOVE finds.
+            const std::uint8_t opcode =
+                m_queue.m_capabilities.async_cancel ? IORING_OP_ASYNC_CANCEL : IORING_OP_POLL_REMOVE;
+            m_cancelRequest = {opcode, &m_message, flags};
+            uring_queue::prep_cancel_request(m_sqe, m_cancelRequest);
             m_message.result = -ECANCELED;
+            // The operation may have been started on another thread's ring.
+            m_forwardCancel = m_queue.m_ringPerThread.load(std::memory_order_relaxed);
         }
         return *this;
     }
 
-    uring_queue::uring_queue(size_t queue_length, uint32_t flags) {
-        auto err = io_uring_queue_init(queue_length, &ring_, flags);
+    uring_queue::uring_queue(size_t queue_length, uint32_t flags)
+        : m_id(local::nextQueueId.fetch_add(1, std::memory_order_relaxed))
+        , m_queueLength(queue_length) {
+        auto err = io_uring_queue_init(queue_length, &m_sharedRing.ring, flags);
         if (err < 0) {
             throw std::system_error{static_cast<int>(-err),
                                     std::system_category(),
                                     "Error initializing uring"};
         }
+        m_capabilities = local::probe_capabilities(m_sharedRing.ring);
     }
 
-    uring_queue::~uring_queue() noexcept { io_uring_queue_exit(&ring_); }
+    uring_queue::~uring_queue() noexcept {
+        // Thread rings poll the shared ring, tear them down first.
+        m_threadRings.clear();
+        free_provided_buffers();
+        io_uring_queue_exit(&m_sharedRing.ring);
+    }
 
     io_transaction uring_queue::transaction(io_message &message) noexcept {
         return io_transaction(*this, message);
     }
 
-    io_uring_sqe *uring_queue::get_sqe() noexcept {
-        return io_uring_get_sqe(&ring_);
+    io_transaction uring_queue::shared_transaction(io_message &message) noexcept {
+        return io_transaction(*this, message, m_sharedRing);
+    }
+
+    io_transaction uring_queue::linked_transaction(io_message &message, unsigned length) noexcept {
+        return io_transaction(*this, message, submission_ring(), length);
+    }
+
+    uring_queue::ring_state &uring_queue::submission_ring() noexcept {
+        if (s_dispatchingQueue == this && s_dispatchingRing != nullptr) {
+            return *s_dispatchingRing;
+        }
+        return m_sharedRing;
+    }
+
+    io_uring_sqe *uring_queue::get_sqe(ring_state &ring) noexcept {
+        auto *sqe = io_uring_get_sqe(&ring.ring);
+        if (sqe == nullptr && ring.pendingSqes.load(std::memory_order_relaxed) != 0) {
+            // The submission queue is full of deferred entries, hand them to
+            // the kernel to make room.
+            submit_pending(ring);
+            sqe = io_uring_get_sqe(&ring.ring);
+        }
+        return sqe;
+    }
+
+    int uring_queue::submit(ring_state &ring, std::size_t sqeCount) noexcept {
+        const auto pending = ring.pendingSqes.load(std::memory_order_relaxed) + sqeCount;
+        ring.pendingSqes.store(pending, std::memory_order_relaxed);
+        const auto highWaterMark = m_submitHighWaterMark.load(std::memory_order_relaxed);
+        if (highWaterMark != 0
+            && s_dispatchingQueue == this
+            && pending < highWaterMark) {
+            // Deferred until the dispatching thread next calls dequeue().
+            return 0;
+        }
+        return submit_pending(ring);
     }
 
-    int uring_queue::submit() noexcept {
-        int res = io_uring_submit(&ring_);
+    int uring_queue::submit_pending(ring_state &ring) noexcept {
+        int res = io_uring_submit(&ring.ring);
+        if (res > 0) {
+            // Only the thread submitting to the ring writes these.
+            const auto submitted = static_cast<std::uint64_t>(res);
+            ring.submitCalls.store(
+                ring.submitCalls.load(std::memory_order_relaxed) + 1, std::memory_order_relaxed);
+            ring.submittedSqes.store(
+                ring.submittedSqes.load(std::memory_order_relaxed) + submitted, std::memory_order_relaxed);
+            if (submitted > ring.maxSqesPerSubmit.load(std::memory_order_relaxed)) {
+                ring.maxSqesPerSubmit.store(submitted, std::memory_order_relaxed);
+            }
+        }
+        if (res >= 0) {
+            ring.pendingSqes.store(0, std::memory_order_relaxed);
+        }
         return res;
     }
 
-    bool uring_queue::dequeue(detail::lnx::io_message *&msg, bool wait) {
-        std::lock_guard guard(m_outMux);
-        io_uring_cqe *cqe;
-        int ret;
-        if (wait)
-            ret = io_uring_wait_cqe(&ring_, &cqe);
-        else
-            ret = io_uring_peek_cqe(&ring_, &cqe);
-        if (ret == -EAGAIN) {
+    void uring_queue::set_submit_high_water_mark(std::size_t highWaterMark) noexcept {
+        m_submitHighWaterMark.store(highWaterMark, std::memory_order_relaxed);
+        if (highWaterMark == 0) {
+            flush();
+        }
+    }
+
+    void uring_queue::restrict_capabilities(const uring_capabilities &capabilities) noexcept {
+        m_capabilities.read_write = m_capabilities.read_write && capabilities.read_write;
+        m_capabilities.send = m_capabilities.send && capabilities.send;
+        m_capabilities.recv = m_capabilities.recv && capabilities.recv;
+        m_capabilities.accept = m_capabilities.accept && capabilities.accept;
+        m_capabilities.connect = m_capabilities.connect && capabilities.connect;
+        m_capabilities.close = m_capabilities.close && capabilities.close;
+        m_capabilities.timeout_remove = m_capabilities.timeout_remove && capabilities.timeout_remove;
+        m_capabilities.async_cancel = m_capabilities.async_cancel && capabilities.async_cancel;
+        m_capabilities.send_zc = m_capabilities.send_zc && capabilities.send_zc;
+        m_capabilities.fallocate = m_capabilities.fallocate && capabilities.fallocate;
+        m_capabilities.openat = m_capabilities.openat && capabilities.openat;
+        m_capabilities.statx = m_capabilities.statx && capabilities.statx;
+        m_capabilities.madvise = m_capabilities.madvise && capabilities.madvise;
+        m_capabilities.splice = m_capabilities.splice && capabilities.splice;
+        m_capabilities.buffer_ring = m_capabilities.buffer_ring && capabilities.buffer_ring;
+    }
+
+    int uring_queue::register_buffers(const iovec *buffers, unsigned count) noexcept {
+        return io_uring_register_buffers(&m_sharedRing.ring, buffers, count);
+    }
+
+    void uring_queue::unregister_buffers() noexcept {
+        (void)io_uring_unregister_buffers(&m_sharedRing.ring);
+    }
+
+    bool uring_queue::init_file_table() noexcept {
+        std::lock_guard lock{m_fileTableMux};
+        if (m_fileTableSize.load(std::memory_order_relaxed) != 0) {
+            return true;
+        }
+        if (m_fileTableFailed) {
             return false;
-        } else if (ret < 0) {
-            throw std::system_error{-ret,
-                                    std::system_category(),
-                                    std::string{"io_uring_peek_cqe failed"}};
+        }
+        // A registered table can't grow without quiescing the ring on most
+        // kernels, so size it for every fd this process may open. Sparse
+        // slots are cheap until filled.
+        rlimit limit{};
+        unsigned size = 1024;
+        if (::getrlimit(RLIMIT_NOFILE, &limit) == 0 && limit.rlim_cur != RLIM_INFINITY) {
+            size = static_cast<unsigned>(std::min<rlim_t>(limit.rlim_cur, 1u << 20));
+        }
+        int err = -EINVAL;
+        for (; size >= 64; size /= 2) {
+            err = io_uring_register_files_sparse(&m_sharedRing.ring, size);
+            if (err != -ENOMEM && err != -EMFILE) {
+                break;
+            }
+        }
+        if (err < 0) {
+            m_fileTableFailed = true;
+            return false;
+        }
+        m_registeredFiles.reset(new (std::nothrow) std::atomic<bool>[size]());
+        if (!m_registeredFiles) {
+            (void)io_uring_unregister_files(&m_sharedRing.ring);
+            m_fileTableFailed = true;
+            return false;
+        }
+        m_fileTableSize.store(size, std::memory_order_release);
+        return true;
+    }
+
+    void uring_queue::register_file(int fd) noexcept {
+        if (fd < 0 || !init_file_table()
+            || static_cast<unsigned>(fd) >= m_fileTableSize.load(std::memory_order_acquire)) {
+            return;
+        }
+        if (io_uring_register_files_update(&m_sharedRing.ring, static_cast<unsigned>(fd), &fd, 1) == 1) {
+            m_registeredFiles[fd].store(true, std::memory_order_release);
+        }
+    }
+
+    void uring_queue::unregister_file(int fd) noexcept {
+        if (!is_registered_file(fd)) {
+            return;
+        }
+        m_registeredFiles[fd].store(false, std::memory_order_relaxed);
+        int empty = -1;
+        (void)io_uring_register_files_update(&m_sharedRing.ring, static_cast<unsigned>(fd), &empty, 1);
+    }
+
+    void uring_queue::set_provided_buffers(std::uint16_t count, std::uint32_t size) noexcept {
+        assert(count != 0 && (count & (count - 1)) == 0 && count <= 32768);
+        assert(!m_providedReady.load(std::memory_order_relaxed));
+        m_providedCount = count;
+        m_providedSize = size;
+    }
+
+    bool uring_queue::init_provided_buffers() noexcept {
+        if (!m_providedReady.load(std::memory_order_acquire)) {
+            std::lock_guard lock{m_providedMux};
+            if (!m_providedReady.load(std::memory_order_relaxed)) {
+                const std::size_t bytes = std::size_t{m_providedCount} * m_providedSize;
+                void *memory = ::mmap(nullptr, bytes, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+                if (memory != MAP_FAILED) {
+                    m_providedMemory = static_cast<std::byte *>(memory);
+                    // Receives into the ring can't be cancelled without
+                    // ASYNC_CANCEL, the user space free list is polled for.
+                    if (m_capabilities.buffer_ring && m_capabilities.async_cancel) {
+                        int err = 0;
+                        m_bufRing = io_uring_setup_buf_ring(
+                            &m_sharedRing.ring, m_providedCount, provided_buffer_group, 0, &err);
+                    }
+                    if (m_bufRing != nullptr) {
+                        for (int id = 0; id < m_providedCount; ++id) {
+                            local::add_to_buf_ring(m_bufRing, m_providedCount, provided_buffer(id), m_providedSize, id, id);
+                        }
+                        io_uring_buf_ring_advance(m_bufRing, m_providedCount);
+                    } else {
+                        m_capabilities.buffer_ring = false;
+                        m_freeProvided.reserve(m_providedCount);
+                        for (int id = m_providedCount; id-- > 0;) {
+                            m_freeProvided.push_back(id);
+                        }
+                    }
+                } else {
+                    // Every receive fails with ENOBUFS.
+                    m_capabilities.buffer_ring = false;
+                }
+                m_providedReady.store(true, std::memory_order_release);
+            }
+        }
+        return m_bufRing != nullptr;
+    }
+
+    int uring_queue::take_provided_buffer() noexcept {
+        std::lock_guard lock{m_providedMux};
+        if (m_freeProvided.empty()) {
+            return -1;
+        }
+        const int id = m_freeProvided.back();
+        m_freeProvided.pop_back();
+        return id;
+    }
+
+    void uring_queue::recycle_provided_buffer(int id) noexcept {
+        std::lock_guard lock{m_providedMux};
+        if (m_bufRing != nullptr) {
+            local::add_to_buf_ring(m_bufRing, m_providedCount, provided_buffer(id), m_providedSize, id, 0);
+            io_uring_buf_ring_advance(m_bufRing, 1);
         } else {
-            msg = reinterpret_cast<detail::lnx::io_message *>(io_uring_cqe_get_data(cqe));
+            m_freeProvided.push_back(id);
+        }
+    }
+
+    void uring_queue::free_provided_buffers() noexcept {
+        if (m_bufRing != nullptr) {
+            (void)io_uring_free_buf_ring(&m_sharedRing.ring, m_bufRing, m_providedCount, provided_buffer_group);
+        }
+        if (m_providedMemory != nullptr) {
+            ::munmap(m_providedMemory, std::size_t{m_providedCount} * m_providedSize);
+        }
+    }
+
+    bool uring_queue::is_registered_file(int fd) const noexcept {
+        return fd >= 0
+            && static_cast<unsigned>(fd) < m_fileTableSize.load(std::memory_order_acquire)
+            && m_registeredFiles[fd].load(std::memory_order_acquire);
+    }
+
+    bool uring_queue::enable_ring_per_thread() noexcept {
+        auto *probe = io_uring_get_probe_ring(&m_sharedRing.ring);
+        if (probe == nullptr) {
+            return false;
+        }
+        const bool supported = io_uring_opcode_supported(probe, IORING_OP_MSG_RING);
+        io_uring_free_probe(probe);
+        if (supported) {
+            m_ringPerThread.store(true, std::memory_order_relaxed);
+        }
+        return supported;
+    }
+
+    void uring_queue::wake_up(io_message &message) noexcept {
+        std::lock_guard guard(m_sqeMux);
+        if (auto *sqe = get_sqe(m_sharedRing)) {
+            io_uring_prep_nop(sqe);
+            io_uring_sqe_set_data(sqe, &message);
+            submit_pending(m_sharedRing);
+        }
+    }
+
+    void uring_queue::flush() noexcept {
+        if (auto *ring = cached_thread_ring();
+            ring != nullptr && ring->pendingSqes.load(std::memory_order_relaxed) != 0) {
+            submit_pending(*ring);
+        }
+        if (m_sharedRing.pendingSqes.load(std::memory_order_relaxed) == 0) {
+            return;
+        }
+        std::lock_guard guard(m_sqeMux);
+        if (m_sharedRing.pendingSqes.load(std::memory_order_relaxed) != 0) {
+            submit_pending(m_sharedRing);
+        }
+    }
+
+    submit_stats uring_queue::stats() noexcept {
+        submit_stats stats;
+        auto add = [&stats](const ring_state &ring) {
+            stats.submit_calls += ring.submitCalls.load(std::memory_order_relaxed);
+            stats.submitted_sqes += ring.submittedSqes.load(std::memory_order_relaxed);
+            stats.max_sqes_per_submit = std::max<std::uint64_t>(
+                stats.max_sqes_per_submit, ring.maxSqesPerSubmit.load(std::memory_order_relaxed));
+        };
+        add(m_sharedRing);
+        std::lock_guard guard(m_threadRingsMux);
+        for (auto &ring : m_threadRings) {
+            add(*ring);
+        }
+        return stats;
+    }
+
+    uring_queue::thread_ring *uring_queue::cached_thread_ring() noexcept {
+        return s_threadRingQueueId == m_id ? s_threadRing : nullptr;
+    }
+
+    uring_queue::thread_ring &uring_queue::current_thread_ring() {
+        if (auto *ring = cached_thread_ring()) {
+            return *ring;
+        }
+
+        const auto threadId = std::this_thread::get_id();
+
+        std::lock_guard guard(m_threadRingsMux);
+        auto it = std::find_if(m_threadRings.begin(), m_threadRings.end(), [&](auto &ring) {
+            return ring->owner == threadId;
+        });
+        if (it == m_threadRings.end()) {
+            auto ring = std::make_unique<thread_ring>();
+            ring->owner = threadId;
+
+            io_uring_params params{};
+            params.flags = IORING_SETUP_SINGLE_ISSUER | IORING_SETUP_DEFER_TASKRUN;
+            auto err = io_uring_queue_init_params(m_queueLength, &ring->ring, &params);
+            if (err == -EINVAL) {
+                // Kernel older than 6.1
+                params = io_uring_params{};
+                err = io_uring_queue_init_params(m_queueLength, &ring->ring, &params);
+            } else {
+                ring->deferTaskrun = true;
+            }
+            if (err < 0) {
+                throw std::system_error{static_cast<int>(-err),
+                                        std::system_category(),
+                                        "Error initializing thread uring"};
+            }
+
+            m_threadRings.push_back(std::move(ring));
+            it = std::prev(m_threadRings.end());
+            arm_doorbell(**it);
+            submit_pending(**it);
+        }
+
+        s_threadRing = it->get();
+        s_threadRingQueueId = m_id;
+        return **it;
+    }
+
+    void uring_queue::arm_doorbell(thread_ring &ring) noexcept {
+        // One-shot and level triggered: fires straight away if the shared ring
+        // already has completions waiting.
+        if (auto *sqe = get_sqe(ring)) {
+            io_uring_prep_poll_add(sqe, m_sharedRing.ring.ring_fd, POLLIN);
+            io_uring_sqe_set_data(sqe, &ring.doorbell);
+            ring.pendingSqes.fetch_add(1, std::memory_order_relaxed);
+        }
+    }
+
+    void uring_queue::prep_cancel_request(io_uring_sqe *sqe, const cancel_request &request) noexcept {
+        switch (request.opcode) {
+            case IORING_OP_TIMEOUT_REMOVE:
+                io_uring_prep_timeout_remove(sqe, reinterpret_cast<uint64_t>(request.message), request.flags);
+                break;
+            case IORING_OP_POLL_REMOVE:
+                // As io_uring_prep_poll_remove(), whose parameter type
+                // changed between liburing releases.
+                io_uring_prep_rw(IORING_OP_POLL_REMOVE, sqe, -1, request.message, 0, 0);
+                break;
+            default:
+                io_uring_prep_cancel(sqe, request.message, request.flags);
+                break;
+        }
+        // The completion of the request itself carries no message, the
+        // operation it removes completes with -ECANCELED on its own.
+        io_uring_sqe_set_data(sqe, nullptr);
+    }
+
+    void uring_queue::forward_cancel(const cancel_request &request, ring_state *submittedTo) noexcept {
+        if (submittedTo != &m_sharedRing) {
+            std::lock_guard guard(m_sqeMux);
+            if (auto *sqe = get_sqe(m_sharedRing)) {
+                prep_cancel_request(sqe, request);
+                submit_pending(m_sharedRing);
+            }
+        }
+
+        std::lock_guard guard(m_threadRingsMux);
+        for (auto &ring : m_threadRings) {
+            if (ring.get() == submittedTo) {
+                continue;
+            }
+
+            bool wakeOwner;
+            {
+                std::lock_guard remoteGuard(ring->remoteMux);
+                ring->remoteRequests.push_back(request);
+                wakeOwner = !ring->remotePending.exchange(true, std::memory_order_release);
+            }
+
+            if (wakeOwner) {
+                std::lock_guard sqeGuard(m_sqeMux);
+                if (auto *sqe = get_sqe(m_sharedRing)) {
+                    io_uring_prep_msg_ring(
+                        sqe, ring->ring.ring_fd, 0, reinterpret_cast<uint64_t>(&ring->remoteDoorbell), 0);
+                    // No message for the completion on the sending ring.
+                    io_uring_sqe_set_data(sqe, nullptr);
+                    submit_pending(m_sharedRing);
+                }
+            }
+        }
+    }
+
+    void uring_queue::process_remote_requests(thread_ring &ring) noexcept {
+        if (!ring.remotePending.load(std::memory_order_acquire)) {
+            return;
+        }
+
+        {
+            std::lock_guard guard(ring.remoteMux);
+            std::swap(ring.remoteRequests, ring.remoteRequestsScratch);
+            ring.remotePending.store(false, std::memory_order_relaxed);
+        }
+
+        auto request = ring.remoteRequestsScratch.begin();
+        for (; request != ring.remoteRequestsScratch.end(); ++request) {
+            auto *sqe = get_sqe(ring);
+            if (sqe == nullptr) {
+                break;
+            }
+            prep_cancel_request(sqe, *request);
+            ring.pendingSqes.fetch_add(1, std::memory_order_relaxed);
+        }
+
+        if (request != ring.remoteRequestsScratch.end()) {
+            // Out of submission queue entries; retry the rest on the next
+            // dequeue rather than leave their operations uncancelled.
+            std::lock_guard guard(ring.remoteMux);
+            ring.remoteRequests.insert(
+                ring.remoteRequests.begin(), request, ring.remoteRequestsScratch.end());
+            ring.remotePending.store(true, std::memory_order_relaxed);
+        }
+        ring.remoteRequestsScratch.clear();
+    }
+
+    bool uring_queue::dequeue(detail::lnx::io_message *&msg, bool wait) {
+        return dequeue(&msg, 1, wait) != 0;
+    }
+
+    std::size_t uring_queue::dequeue(detail::lnx::io_message **messages, std::size_t maxCount, bool wait) {
+        flush();
+        const auto batchSize = static_cast<unsigned>(std::min(maxCount, max_dequeue_batch));
+        if (m_ringPerThread.load(std::memory_order_relaxed)) {
+            return dequeue_thread(current_thread_ring(), messages, batchSize, wait);
+        }
+        return dequeue_shared(messages, batchSize, wait);
+    }
+
+    std::size_t uring_queue::dequeue_shared(detail::lnx::io_message **messages, unsigned maxCount, bool wait) {
+        std::lock_guard guard(m_outMux);
+        io_uring_cqe *cqes[max_dequeue_batch];
+        unsigned count = io_uring_peek_batch_cqe(&m_sharedRing.ring, cqes, maxCount);
+        if (count == 0) {
+            if (!wait) {
+                return 0;
+            }
+            io_uring_cqe *cqe;
+            int ret = io_uring_wait_cqe(&m_sharedRing.ring, &cqe);
+            if (ret == -EAGAIN) {
+                return 0;
+            } else if (ret < 0) {
+                throw std::system_error{-ret,
+                                        std::system_category(),
+                                        std::string{"io_uring_wait_cqe failed"}};
+            }
+            count = io_uring_peek_batch_cqe(&m_sharedRing.ring, cqes, maxCount);
+        }
+        for (unsigned i = 0; i < count; ++i) {
+            auto *msg = reinterpret_cast<detail::lnx::io_message *>(io_uring_cqe_get_data(cqes[i]));
+            if (msg != nullptr && msg->is_multishot()) {
+                const bool more = (cqes[i]->flags & IORING_CQE_F_MORE) != 0;
+                messages[i] = msg->on_multishot_completion(cqes[i]->res, more) ? msg : nullptr;
+                continue;
+            }
+            if (msg != nullptr
+                && msg->pendingCompletions != 0
+                && !local::complete_link(*msg, cqes[i]->res)) {
+                messages[i] = nullptr;
+                continue;
+            }
             if (msg != nullptr
                 && msg->result == -1) // manually set result eg.: -ECANCEL
             {
-                msg->result = cqe->res;
+                msg->result = cqes[i]->res;
+            }
+            if (msg != nullptr && (cqes[i]->flags & IORING_CQE_F_BUFFER)) {
+                // Recorded even if cancelled, so the buffer isn't lost.
+                msg->bufferId = static_cast<int>(cqes[i]->flags >> IORING_CQE_BUFFER_SHIFT);
+            }
+            if (cqes[i]->flags & IORING_CQE_F_MORE) {
+                // Only the last completion of the request, eg. the SEND_ZC
+                // notification, completes the message.
+                msg = nullptr;
+            }
+            messages[i] = msg;
+        }
+        io_uring_cq_advance(&m_sharedRing.ring, count);
+        return count;
+    }
+
+    std::size_t uring_queue::dequeue_thread(
+        thread_ring &ring, detail::lnx::io_message **messages, unsigned maxCount, bool wait) {
+        io_uring_cqe *cqes[max_dequeue_batch];
+        while (true) {
+            process_remote_requests(ring);
+            if (ring.pendingSqes.load(std::memory_order_relaxed) != 0) {
+                submit_pending(ring);
+            }
+
+            if (ring.deferTaskrun && !wait) {
+                // Completions are only posted once the owner enters the kernel.
+                io_uring_get_events(&ring.ring);
+            }
+            unsigned reaped = io_uring_peek_batch_cqe(&ring.ring, cqes, maxCount);
+            if (reaped == 0) {
+                if (!wait) {
+                    return 0;
+                }
+                io_uring_cqe *cqe;
+                int ret = io_uring_wait_cqe(&ring.ring, &cqe);
+                if (ret == -EAGAIN) {
+                    return 0;
+                } else if (ret < 0) {
+                    throw std::system_error{-ret,
+                                            std::system_category(),
+                                            std::string{"io_uring_wait_cqe failed"}};
+                }
+                reaped = io_uring_peek_batch_cqe(&ring.ring, cqes, maxCount);
+            }
+
+            // The doorbells are internal to the queue and not handed out.
+            bool doorbellRang = false;
+            std::size_t count = 0;
+            for (unsigned i = 0; i < reaped; ++i) {
+                auto *msg = reinterpret_cast<detail::lnx::io_message *>(io_uring_cqe_get_data(cqes[i]));
+                if (msg == &ring.doorbell) {
+                    doorbellRang = true;
+                    continue;
+                } else if (msg == &ring.remoteDoorbell) {
+                    continue;
+                } else if (msg != nullptr && msg->is_multishot()) {
+                    const bool more = (cqes[i]->flags & IORING_CQE_F_MORE) != 0;
+                    if (msg->on_multishot_completion(cqes[i]->res, more)) {
+                        messages[count++] = msg;
+                    }
+                    continue;
+                } else if (msg != nullptr
+                    && msg->pendingCompletions != 0
+                    && !local::complete_link(*msg, cqes[i]->res)) {
+                    continue;
+                } else if (msg != nullptr
+                    && msg->result == -1) // manually set result eg.: -ECANCEL
+                {
+                    msg->result = cqes[i]->res;
+                }
+                if (msg != nullptr && (cqes[i]->flags & IORING_CQE_F_BUFFER)) {
+                    msg->bufferId = static_cast<int>(cqes[i]->flags >> IORING_CQE_BUFFER_SHIFT);
+                }
+                if (cqes[i]->flags & IORING_CQE_F_MORE) {
+                    continue;
+                }
+                messages[count++] = msg;
+            }
+            io_uring_cq_advance(&ring.ring, reaped);
+
+            process_remote_requests(ring);
+
+            if (doorbellRang) {
+                // Re-arm before reaping so that completions arriving on the shared
+                // ring from now on ring the doorbell again.
+                arm_doorbell(ring);
+                if (count < maxCount) {
+                    count += dequeue_shared(messages + count, maxCount - static_cast<unsigned>(count), false);
+                }
+            }
+
+            if (ring.pendingSqes.load(std::memory_order_relaxed) != 0) {
+                submit_pending(ring);
+            }
+
+            if (count != 0 || !wait) {
+                return count;
             }
-            io_uring_cqe_seen(&ring_, cqe);
-            return true;  // completed
         }
     }
 
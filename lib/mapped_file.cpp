@@ -0,0 +1,133 @@
+///////////////////////////////////////////////////////////////////////////////
+// Copyright (c) Lewis Baker
+// Licenced under MIT license. See LICENSE.txt for details.
+///////////////////////////////////////////////////////////////////////////////
+
+#include <cppcoro/mapped_file.hpp>
+
+#include <algorithm>
+#include <cerrno>
+#include <system_error>
+#include <utility>
+
+#include <sys/mman.h>
+#include <unistd.h>
+
+namespace
+{
+	namespace local
+	{
+		std::uint64_t page_size() noexcept
+		{
+			static const auto pageSize = static_cast<std::uint64_t>(::sysconf(_SC_PAGESIZE));
+			return pageSize;
+		}
+
+		/// Widen [offset, offset + byteCount) to whole pages and clamp it to
+		/// the view, returning the page aligned offset and the length.
+		std::pair<std::uint64_t, std::uint64_t> page_range(
+			std::uint64_t offset, std::uint64_t byteCount, std::uint64_t size) noexcept
+		{
+			offset = std::min(offset, size);
+			const std::uint64_t end = offset + std::min(byteCount, size - offset);
+			const std::uint64_t start = offset & ~(page_size() - 1);
+			return { start, end - start };
+		}
+	}
+}
+
+cppcoro::mapped_file::mapped_file() noexcept
+	: m_ioService(nullptr)
+	, m_address(nullptr)
+	, m_size(0)
+{
+}
+
+cppcoro::mapped_file::mapped_file(
+	io_service& ioService, void* address, std::size_t size) noexcept
+	: m_ioService(&ioService)
+	, m_address(address)
+	, m_size(size)
+{
+}
+
+cppcoro::mapped_file::mapped_file(mapped_file&& other) noexcept
+	: m_ioService(other.m_ioService)
+	, m_address(std::exchange(other.m_address, nullptr))
+	, m_size(std::exchange(other.m_size, 0))
+{
+}
+
+cppcoro::mapped_file& cppcoro::mapped_file::operator=(mapped_file&& other) noexcept
+{
+	mapped_file temp{ std::move(other) };
+	std::swap(m_ioService, temp.m_ioService);
+	std::swap(m_address, temp.m_address);
+	std::swap(m_size, temp.m_size);
+	return *this;
+}
+
+cppcoro::mapped_file::~mapped_file()
+{
+	if (m_address != nullptr)
+	{
+		(void)::munmap(m_address, m_size);
+	}
+}
+
+cppcoro::mapped_file_advise_operation cppcoro::mapped_file::prefetch(
+	std::uint64_t offset, std::uint64_t byteCount) const noexcept
+{
+	return advise(offset, byteCount, MADV_WILLNEED);
+}
+
+cppcoro::mapped_file_advise_operation cppcoro::mapped_file::populate(
+	std::uint64_t offset, std::uint64_t byteCount) const noexcept
+{
+	return advise(offset, byteCount, MADV_POPULATE_READ);
+}
+
+bool cppcoro::mapped_file::is_resident(std::uint64_t offset, std::uint64_t byteCount) const
+{
+	auto [start, length] = local::page_range(offset, byteCount, m_size);
+	const std::uint64_t pageSize = local::page_size();
+
+	// Query a chunk of pages at a time rather than allocate a vector with
+	// an entry per page of the range.
+	unsigned char residency[256];
+	while (length > 0)
+	{
+		const std::uint64_t chunk = std::min<std::uint64_t>(length, sizeof(residency) * pageSize);
+		if (::mincore(static_cast<char*>(m_address) + start, chunk, residency) != 0)
+		{
+			throw std::system_error
+			{
+				static_cast<int>(errno),
+				std::system_category(),
+				"error querying page residency: mincore"
+			};
+		}
+
+		const std::uint64_t pageCount = (chunk + pageSize - 1) / pageSize;
+		if (!std::all_of(residency, residency + pageCount, [](unsigned char r) { return (r & 1) != 0; }))
+		{
+			return false;
+		}
+
+		start += chunk;
+		length -= chunk;
+	}
+	return true;
+}
+
+cppcoro::mapped_file_advise_operation cppcoro::mapped_file::advise(
+	std::uint64_t offset, std::uint64_t byteCount, int advice) const noexcept
+{
+	auto [start, length] = local::page_range(offset, byteCount, m_size);
+	return mapped_file_advise_operation{
+		*m_ioService,
+		static_cast<char*>(m_address) + start,
+		length,
+		advice
+	};
+}
@@ -0,0 +1,50 @@
+///////////////////////////////////////////////////////////////////////////////
+// Copyright (c) Lewis Baker
+// Licenced under MIT license. See LICENSE.txt for details.
+///////////////////////////////////////////////////////////////////////////////
+
+#include <cppcoro/mapped_file_advise_operation.hpp>
+
+#include <algorithm>
+
+bool cppcoro::mapped_file_advise_operation::await_suspend(
+	cppcoro::coroutine_handle<> awaitingCoroutine) noexcept
+{
+	m_awaitingCoroutine = awaitingCoroutine;
+	m_message.set_callback(&mapped_file_advise_operation::on_chunk_completed, this);
+	return advise_remaining();
+}
+
+bool cppcoro::mapped_file_advise_operation::advise_remaining() noexcept
+{
+	while (true)
+	{
+		const auto chunkLength = static_cast<std::uint32_t>(std::min(m_length, max_chunk_length));
+		// Completions only record their result over the initial -1.
+		m_message.result = -1;
+		if (m_ioQueue.transaction(m_message).madvise(m_address, chunkLength, m_advice).commit())
+		{
+			return true;
+		}
+
+		m_address += chunkLength;
+		m_length -= chunkLength;
+		if (m_message.result < 0 || m_length == 0)
+		{
+			return false;
+		}
+	}
+}
+
+void cppcoro::mapped_file_advise_operation::on_chunk_completed(void* context) noexcept
+{
+	auto& operation = *static_cast<mapped_file_advise_operation*>(context);
+	const std::uint64_t chunkLength = std::min(operation.m_length, max_chunk_length);
+	operation.m_address += chunkLength;
+	operation.m_length -= chunkLength;
+	if (operation.m_message.result >= 0 && operation.m_length != 0 && operation.advise_remaining())
+	{
+		return;
+	}
+	operation.m_awaitingCoroutine.resume();
+}
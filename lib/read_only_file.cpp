@@ -11,6 +11,9 @@
 # endif
 # include <Windows.h>
 #elif CPPCORO_OS_LINUX
+# include <sys/mman.h>
+# include <cerrno>
+# include <system_error>
 #define GENERIC_READ (S_IRUSR | S_IRGRP | S_IROTH)
 #endif
 
@@ -33,6 +36,48 @@ cppcoro::read_only_file cppcoro::read_only_file::open(
 	return std::move(file);
 }
 
+#if CPPCORO_OS_LINUX
+cppcoro::task<cppcoro::read_only_file> cppcoro::read_only_file::open_async(
+	io_service& ioService,
+	filesystem::path path,
+	file_share_mode shareMode,
+	file_buffering_mode bufferingMode)
+{
+	read_only_file file(co_await file::open_async(
+		GENERIC_READ,
+		ioService,
+		path,
+		file_open_mode::open_existing,
+		shareMode,
+		bufferingMode));
+	file.m_ioService = &ioService;
+	co_return std::move(file);
+}
+
+cppcoro::mapped_file cppcoro::read_only_file::map() const
+{
+	const std::uint64_t fileSize = size();
+	if (fileSize == 0)
+	{
+		// mmap() rejects empty mappings.
+		return mapped_file{ *m_ioService, nullptr, 0 };
+	}
+
+	void* address = ::mmap(
+		nullptr, static_cast<std::size_t>(fileSize), PROT_READ, MAP_SHARED, m_fileHandle.fd(), 0);
+	if (address == MAP_FAILED)
+	{
+		throw std::system_error
+		{
+			static_cast<int>(errno),
+			std::system_category(),
+			"error mapping file: mmap"
+		};
+	}
+	return mapped_file{ *m_ioService, address, static_cast<std::size_t>(fileSize) };
+}
+#endif
+
 cppcoro::read_only_file::read_only_file(
 	detail::safe_handle&& fileHandle) noexcept
 	: file(std::move(fileHandle))
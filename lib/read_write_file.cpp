@@ -35,6 +35,26 @@ cppcoro::read_write_file cppcoro::read_write_file::open(
 	return std::move(file);
 }
 
+#if CPPCORO_OS_LINUX
+cppcoro::task<cppcoro::read_write_file> cppcoro::read_write_file::open_async(
+	io_service& ioService,
+	filesystem::path path,
+	file_open_mode openMode,
+	file_share_mode shareMode,
+	file_buffering_mode bufferingMode)
+{
+	read_write_file file(co_await file::open_async(
+		GENERIC_READ | GENERIC_WRITE,
+		ioService,
+		path,
+		openMode,
+		shareMode,
+		bufferingMode));
+	file.m_ioService = &ioService;
+	co_return std::move(file);
+}
+#endif
+
 cppcoro::read_write_file::read_write_file(
 	detail::safe_handle&& fileHandle) noexcept
 	: file(std::move(fileHandle))
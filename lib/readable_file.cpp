@@ -36,3 +36,61 @@ cppcoro::file_read_operation_cancellable cppcoro::readable_file::read(
 		byteCount,
 		std::move(ct));
 }
+
+#if CPPCORO_OS_LINUX
+
+cppcoro::file_read_operation cppcoro::readable_file::read(
+	std::uint64_t offset,
+	const registered_buffer& buffer,
+	std::size_t byteCount) const noexcept
+{
+	return file_read_operation(
+		*m_ioService,
+		m_fileHandle.handle(),
+		offset,
+		buffer.data(),
+		byteCount,
+		buffer.buffer_index());
+}
+
+cppcoro::file_read_operation_cancellable cppcoro::readable_file::read(
+	std::uint64_t offset,
+	const registered_buffer& buffer,
+	std::size_t byteCount,
+	cancellation_token ct) const noexcept
+{
+	return file_read_operation_cancellable(
+		*m_ioService,
+		m_fileHandle.handle(),
+		offset,
+		buffer.data(),
+		byteCount,
+		buffer.buffer_index(),
+		std::move(ct));
+}
+
+cppcoro::file_read_operation cppcoro::readable_file::read(
+	std::uint64_t offset,
+	std::span<const iovec> buffers) const noexcept
+{
+	return file_read_operation(
+		*m_ioService,
+		m_fileHandle.handle(),
+		offset,
+		buffers);
+}
+
+cppcoro::file_read_operation_cancellable cppcoro::readable_file::read(
+	std::uint64_t offset,
+	std::span<const iovec> buffers,
+	cancellation_token ct) const noexcept
+{
+	return file_read_operation_cancellable(
+		*m_ioService,
+		m_fileHandle.handle(),
+		offset,
+		buffers,
+		std::move(ct));
+}
+
+#endif
@@ -0,0 +1,106 @@
+///////////////////////////////////////////////////////////////////////////////
+// Copyright (c) Lewis Baker
+// Licenced under MIT license. See LICENSE.txt for details.
+///////////////////////////////////////////////////////////////////////////////
+
+#include <cppcoro/registered_buffer_pool.hpp>
+#include <cppcoro/io_service.hpp>
+
+#include <cassert>
+#include <cerrno>
+#include <system_error>
+
+#include <sys/mman.h>
+#include <sys/uio.h>
+
+cppcoro::registered_buffer_pool::registered_buffer_pool(
+	io_service& ioService,
+	std::size_t slabSize,
+	std::uint32_t slabCount)
+	: m_ioService(ioService)
+	, m_slabSize(slabSize)
+	, m_slabCount(slabCount)
+	, m_memory(nullptr)
+	, m_registered(false)
+{
+	if (slabSize == 0 || slabCount == 0)
+	{
+		throw std::system_error
+		{
+			EINVAL,
+			std::system_category(),
+			"registered_buffer_pool: slab size and count must be non-zero"
+		};
+	}
+
+	void* memory = ::mmap(
+		nullptr,
+		slabSize * slabCount,
+		PROT_READ | PROT_WRITE,
+		MAP_PRIVATE | MAP_ANONYMOUS,
+		-1,
+		0);
+	if (memory == MAP_FAILED)
+	{
+		throw std::system_error
+		{
+			errno,
+			std::system_category(),
+			"registered_buffer_pool: mmap"
+		};
+	}
+	m_memory = static_cast<std::byte*>(memory);
+
+	// Hand out the low slabs first.
+	m_freeSlabs.reserve(slabCount);
+	for (std::uint32_t slab = slabCount; slab-- > 0;)
+	{
+		m_freeSlabs.push_back(slab);
+	}
+
+#if CPPCORO_USE_IO_RING
+	std::vector<iovec> buffers(slabCount);
+	for (std::uint32_t slab = 0; slab < slabCount; ++slab)
+	{
+		buffers[slab].iov_base = m_memory + slab * slabSize;
+		buffers[slab].iov_len = slabSize;
+	}
+	m_registered = m_ioService.io_queue().register_buffers(buffers.data(), slabCount) == 0;
+#endif
+}
+
+cppcoro::registered_buffer_pool::~registered_buffer_pool()
+{
+	assert(m_freeSlabs.size() == m_slabCount);
+#if CPPCORO_USE_IO_RING
+	if (m_registered)
+	{
+		m_ioService.io_queue().unregister_buffers();
+	}
+#endif
+	::munmap(m_memory, m_slabSize * m_slabCount);
+}
+
+cppcoro::registered_buffer cppcoro::registered_buffer_pool::try_lease() noexcept
+{
+	std::lock_guard lock{ m_mutex };
+	if (m_freeSlabs.empty())
+	{
+		return {};
+	}
+	const std::uint32_t slab = m_freeSlabs.back();
+	m_freeSlabs.pop_back();
+	return registered_buffer{ this, slab };
+}
+
+std::uint32_t cppcoro::registered_buffer_pool::available() const noexcept
+{
+	std::lock_guard lock{ m_mutex };
+	return static_cast<std::uint32_t>(m_freeSlabs.size());
+}
+
+void cppcoro::registered_buffer_pool::release(std::uint32_t slab) noexcept
+{
+	std::lock_guard lock{ m_mutex };
+	m_freeSlabs.push_back(slab);
+}
@@ -13,6 +13,9 @@
 
 #include <cppcoro/io_service.hpp>
 #include <cppcoro/on_scope_exit.hpp>
+#if CPPCORO_OS_LINUX
+# include <cppcoro/read_only_file.hpp>
+#endif
 
 #include "socket_helpers.hpp"
 
@@ -23,7 +26,9 @@
 # include <Windows.h>
 #define last_error WSAGetLastError()
 #elif CPPCORO_OS_LINUX
+#include <algorithm>
 #include <cstring>
+#include <fcntl.h>
 #include <netinet/in.h>
 #include <sys/ioctl.h>
 #include <sys/socket.h>
@@ -203,7 +208,20 @@ namespace
 			return std::make_tuple(socketHandle, skipCompletionPortOnSuccess);
 		}
 #else
+#if CPPCORO_USE_IO_RING
+		/// Size asked for the pipe of socket::send_file(), the default
+		/// /proc/sys/fs/pipe-max-size. Fewer, larger splices cost less.
+		constexpr int send_file_pipe_size = 1024 * 1024;
+#endif
+
+		/// Largest transfer of a single sendfile() call.
+		constexpr std::size_t max_sendfile_size = 0x7ffff000;
+
 		int create_socket(int domain, int type, int protocol) {
+#if !CPPCORO_USE_IO_RING
+			// The epoll queue relies on accept() and connect() not blocking.
+			type |= SOCK_NONBLOCK;
+#endif
 			int sock = socket(domain, type, protocol);
 			if (sock < 0)
 			{
@@ -318,6 +336,9 @@ cppcoro::net::socket::~socket()
 {
 	if (m_handle != INVALID_SOCKET)
 	{
+#if CPPCORO_USE_IO_RING
+		m_ioQueue.unregister_file(m_handle);
+#endif
 		::closesocket(m_handle);
 	}
 }
@@ -328,8 +349,18 @@ cppcoro::net::socket::operator=(socket&& other) noexcept
 	auto handle = std::exchange(other.m_handle, INVALID_SOCKET);
 	if (m_handle != INVALID_SOCKET)
 	{
+#if CPPCORO_USE_IO_RING
+		m_ioQueue.unregister_file(m_handle);
+#endif
 		::closesocket(m_handle);
 	}
+#if CPPCORO_USE_IO_RING
+	if (handle != INVALID_SOCKET && &other.m_ioQueue != &m_ioQueue)
+	{
+		other.m_ioQueue.unregister_file(handle);
+		m_ioQueue.register_file(handle);
+	}
+#endif
 
 	m_handle = handle;
 #if CPPCORO_OS_WINNT
@@ -525,6 +556,56 @@ cppcoro::net::socket_send_operation_cancellable cppcoro::net::socket::send(
 	};
 }
 
+#if CPPCORO_OS_LINUX
+cppcoro::net::socket_send_operation
+cppcoro::net::socket::send(const registered_buffer& buffer, std::size_t byteCount) noexcept
+{
+	return socket_send_operation
+	{
+		m_ioQueue, *this, buffer.data(), byteCount, buffer.buffer_index()
+	};
+}
+
+cppcoro::net::socket_send_operation_cancellable cppcoro::net::socket::send(
+	const registered_buffer& buffer, std::size_t byteCount, cancellation_token ct) noexcept
+{
+	return socket_send_operation_cancellable
+	{
+		m_ioQueue, *this, buffer.data(), byteCount, buffer.buffer_index(), std::move(ct)
+	};
+}
+
+cppcoro::net::socket_send_operation
+cppcoro::net::socket::send(std::span<const iovec> buffers) noexcept
+{
+	return socket_send_operation{ m_ioQueue, *this, buffers };
+}
+
+cppcoro::net::socket_send_operation_cancellable
+cppcoro::net::socket::send(std::span<const iovec> buffers, cancellation_token ct) noexcept
+{
+	return socket_send_operation_cancellable{ m_ioQueue, *this, buffers, std::move(ct) };
+}
+
+cppcoro::net::socket_send_operation
+cppcoro::net::socket::send_zero_copy(const void* buffer, std::size_t byteCount) noexcept
+{
+	return socket_send_operation
+	{
+		m_ioQueue, *this, buffer, byteCount, -1
+	};
+}
+
+cppcoro::net::socket_send_operation_cancellable cppcoro::net::socket::send_zero_copy(
+	const void* buffer, std::size_t byteCount, cancellation_token ct) noexcept
+{
+	return socket_send_operation_cancellable
+	{
+		m_ioQueue, *this, buffer, byteCount, -1, std::move(ct)
+	};
+}
+#endif
+
 cppcoro::net::socket_recv_operation
 cppcoro::net::socket::recv(void* buffer, std::size_t byteCount) noexcept
 {
@@ -549,6 +630,117 @@ cppcoro::net::socket::recv(void* buffer, std::size_t byteCount, cancellation_tok
 	};
 }
 
+#if CPPCORO_OS_LINUX
+cppcoro::net::socket_recv_operation
+cppcoro::net::socket::recv(std::span<const iovec> buffers) noexcept
+{
+	return socket_recv_operation{ m_ioQueue, *this, buffers };
+}
+
+cppcoro::net::socket_recv_operation_cancellable
+cppcoro::net::socket::recv(std::span<const iovec> buffers, cancellation_token ct) noexcept
+{
+	return socket_recv_operation_cancellable{ m_ioQueue, *this, buffers, std::move(ct) };
+}
+
+cppcoro::net::socket_recv_pooled_operation
+cppcoro::net::socket::recv_pooled() noexcept
+{
+	return socket_recv_pooled_operation{ m_ioQueue, *this };
+}
+
+cppcoro::net::socket_recv_pooled_operation_cancellable
+cppcoro::net::socket::recv_pooled(cancellation_token ct) noexcept
+{
+	return socket_recv_pooled_operation_cancellable{ m_ioQueue, *this, std::move(ct) };
+}
+
+cppcoro::task<std::size_t> cppcoro::net::socket::send_file(
+	read_only_file& file, std::uint64_t offset, std::size_t size, cancellation_token ct)
+{
+	using kind = socket_send_file_operation_impl::kind;
+
+	const int fileFd = file.m_fileHandle.fd();
+	std::size_t sent = 0;
+
+#if CPPCORO_USE_IO_RING
+	// Without ASYNC_CANCEL only the poll of the sendfile() path can be
+	// cancelled.
+	if (m_ioQueue.capabilities().splice && m_ioQueue.capabilities().async_cancel)
+	{
+		int fds[2];
+		if (::pipe2(fds, O_CLOEXEC) != 0)
+		{
+			throw std::system_error(
+				last_error, std::system_category(), "Error sending file: pipe2");
+		}
+		const cppcoro::detail::lnx::safe_fd pipeRead{ fds[0] };
+		const cppcoro::detail::lnx::safe_fd pipeWrite{ fds[1] };
+
+		// Growing the pipe fails past the limit, keep the default size then.
+		(void)::fcntl(pipeWrite.fd(), F_SETPIPE_SZ, local::send_file_pipe_size);
+		const int pipeSize = ::fcntl(pipeWrite.fd(), F_GETPIPE_SZ);
+		const std::size_t chunkSize = pipeSize > 0 ? static_cast<std::size_t>(pipeSize) : 64 * 1024;
+
+		while (sent < size)
+		{
+			// The pipe is empty here, so filling it never waits on the
+			// socket.
+			const std::size_t filled = co_await socket_send_file_operation_cancellable{
+				m_ioQueue,
+				kind::splice,
+				fileFd,
+				static_cast<std::int64_t>(offset + sent),
+				pipeWrite.fd(),
+				std::min(size - sent, chunkSize),
+				cancellation_token{ ct }
+			};
+			if (filled == 0)
+			{
+				// End of file.
+				break;
+			}
+
+			for (std::size_t drained = 0; drained < filled;)
+			{
+				const std::size_t n = co_await socket_send_file_operation_cancellable{
+					m_ioQueue, kind::splice, pipeRead.fd(), -1, m_handle, filled - drained, cancellation_token{ ct }
+				};
+				if (n == 0)
+				{
+					throw std::system_error(
+						EPIPE, std::system_category(), "Error sending file: splice");
+				}
+				drained += n;
+			}
+			sent += filled;
+		}
+		co_return sent;
+	}
+#endif
+
+	while (sent < size)
+	{
+		const std::size_t n = co_await socket_send_file_operation_cancellable{
+			m_ioQueue,
+			kind::sendfile,
+			fileFd,
+			static_cast<std::int64_t>(offset + sent),
+			m_handle,
+			std::min(size - sent, local::max_sendfile_size),
+			cancellation_token{ ct }
+		};
+		if (n == 0)
+		{
+			// End of file.
+			break;
+		}
+		sent += n;
+	}
+	co_return sent;
+}
+#endif
+
 cppcoro::net::socket_recv_from_operation
 cppcoro::net::socket::recv_from(void* buffer, std::size_t byteCount) noexcept
 {
@@ -634,4 +826,7 @@ cppcoro::net::socket::socket(
 	, m_ioQueue(ioQueue)
 #endif
 {
+#if CPPCORO_USE_IO_RING
+	m_ioQueue.register_file(m_handle);
+#endif
 }
@@ -128,8 +128,18 @@ void cppcoro::net::socket_accept_operation_impl::get_result(
 
 #else
 
+#include <poll.h>
+
 bool cppcoro::net::socket_accept_operation_impl::try_start(
     cppcoro::detail::io_operation_base &operation) noexcept {
+#if CPPCORO_USE_IO_RING
+    if (!operation.m_ioQueue.capabilities().accept || !operation.m_ioQueue.capabilities().async_cancel) {
+        // Wait for a pending connection, get_result() accepts it.
+        return operation.m_ioQueue.transaction(operation.m_message)
+            .poll(m_listeningSocket.native_handle(), POLLIN)
+            .commit();
+    }
+#endif
     return operation.m_ioQueue.transaction(operation.m_message)
         .accept(m_listeningSocket.native_handle(), &m_addressBuffer[0], &m_addressBufferLength)
         .commit();
@@ -144,6 +154,18 @@ void cppcoro::net::socket_accept_operation_impl::cancel(
 void cppcoro::net::socket_accept_operation_impl::get_result(
     cppcoro::detail::io_operation_base &operation) {
     auto fd = operation.get_result();
+#if CPPCORO_USE_IO_RING
+    if (!operation.m_ioQueue.capabilities().accept || !operation.m_ioQueue.capabilities().async_cancel) {
+        const int acceptedFd = ::accept(m_listeningSocket.native_handle(), nullptr, nullptr);
+        if (acceptedFd < 0) {
+            throw std::system_error{
+                errno,
+                std::generic_category()
+            };
+        }
+        fd = acceptedFd;
+    }
+#endif
     m_acceptingSocket = socket(operation.m_ioQueue, fd);
     m_addressBufferLength = sizeof(m_addressBuffer);
     if (getpeername(fd, reinterpret_cast<sockaddr *>(&m_addressBuffer[0]), &m_addressBufferLength) < 0) {
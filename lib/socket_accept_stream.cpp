@@ -0,0 +1,296 @@
+///////////////////////////////////////////////////////////////////////////////
+// Copyright (c) Lewis Baker
+// Licenced under MIT license. See LICENSE.txt for details.
+///////////////////////////////////////////////////////////////////////////////
+
+#include <cppcoro/net/socket.hpp>
+
+#include <cppcoro/cancellation_registration.hpp>
+#include <cppcoro/on_scope_exit.hpp>
+#include <cppcoro/operation_cancelled.hpp>
+
+#include "socket_helpers.hpp"
+
+#include <deque>
+#include <mutex>
+#include <optional>
+#include <system_error>
+
+#include <sys/socket.h>
+#include <unistd.h>
+
+namespace
+{
+	namespace local
+	{
+#if CPPCORO_USE_IO_RING
+		void set_endpoints(int fd, cppcoro::net::ip_endpoint& local, cppcoro::net::ip_endpoint& remote)
+		{
+			sockaddr_storage address;
+			socklen_t length = sizeof(address);
+			if (::getpeername(fd, reinterpret_cast<sockaddr*>(&address), &length) < 0)
+			{
+				throw std::system_error{ errno, std::generic_category() };
+			}
+			remote = cppcoro::net::detail::sockaddr_to_ip_endpoint(
+				*reinterpret_cast<sockaddr*>(&address));
+
+			length = sizeof(address);
+			if (::getsockname(fd, reinterpret_cast<sockaddr*>(&address), &length) < 0)
+			{
+				throw std::system_error{ errno, std::generic_category() };
+			}
+			local = cppcoro::net::detail::sockaddr_to_ip_endpoint(
+				*reinterpret_cast<sockaddr*>(&address));
+		}
+
+		/// Results of a multishot accept request, handed from the thread
+		/// reaping its completions to the accept_stream() coroutine.
+		///
+		/// If the request is still armed when the stream is released, the
+		/// request's last completion frees the state.
+		class multishot_accept
+		{
+		public:
+
+			multishot_accept(cppcoro::detail::lnx::io_queue& queue, int listeningFd) noexcept
+				: m_queue(queue)
+				, m_listeningFd(listeningFd)
+			{
+				m_message.set_multishot_handler(&multishot_accept::on_completion, this);
+			}
+
+			/// Submit the request unless it is already armed.
+			void arm() noexcept
+			{
+				{
+					std::lock_guard lock{ m_mutex };
+					if (m_armed)
+					{
+						return;
+					}
+					if (m_cancelled)
+					{
+						m_results.push_back(-ECANCELED);
+						return;
+					}
+					m_armed = true;
+				}
+
+				if (!m_queue.transaction(m_message).accept_multishot(m_listeningFd).commit())
+				{
+					std::lock_guard lock{ m_mutex };
+					m_armed = false;
+					m_results.push_back(std::exchange(m_message.result, -1));
+				}
+			}
+
+			void cancel() noexcept
+			{
+				bool armed;
+				{
+					std::lock_guard lock{ m_mutex };
+					m_cancelled = true;
+					armed = m_armed;
+				}
+				if (armed)
+				{
+					m_queue.transaction(m_message).cancel().commit();
+				}
+			}
+
+			/// Stop accepting and close connections not yet taken.
+			void release() noexcept
+			{
+				bool armed;
+				{
+					std::lock_guard lock{ m_mutex };
+					m_released = true;
+					armed = m_armed;
+					m_releasing = armed;
+					close_results();
+				}
+				if (armed)
+				{
+					m_queue.transaction(m_message).cancel().commit();
+
+					std::lock_guard lock{ m_mutex };
+					m_releasing = false;
+					armed = m_armed;
+				}
+				if (!armed)
+				{
+					delete this;
+				}
+			}
+
+			/// Wait for the next completion, an accepted fd or a negative
+			/// errno. The request is no longer armed once the last
+			/// completion has been taken.
+			auto next() noexcept
+			{
+				class awaiter
+				{
+				public:
+
+					explicit awaiter(multishot_accept& state) noexcept
+						: m_state(state)
+					{}
+
+					bool await_ready() const noexcept { return false; }
+
+					bool await_suspend(cppcoro::coroutine_handle<> awaitingCoroutine) noexcept
+					{
+						std::lock_guard lock{ m_state.m_mutex };
+						if (!m_state.m_results.empty())
+						{
+							return false;
+						}
+						m_state.m_message = awaitingCoroutine;
+						m_state.m_waiting = true;
+						return true;
+					}
+
+					int await_resume() noexcept
+					{
+						std::lock_guard lock{ m_state.m_mutex };
+						const int result = m_state.m_results.front();
+						m_state.m_results.pop_front();
+						return result;
+					}
+
+				private:
+
+					multishot_accept& m_state;
+
+				};
+
+				return awaiter{ *this };
+			}
+
+		private:
+
+			~multishot_accept() = default;
+
+			static bool on_completion(void* context, int result, bool more) noexcept
+			{
+				auto& state = *static_cast<multishot_accept*>(context);
+				bool freeState = false;
+				bool resume = false;
+				{
+					std::lock_guard lock{ state.m_mutex };
+					if (!more)
+					{
+						state.m_armed = false;
+					}
+					if (state.m_released)
+					{
+						if (result >= 0)
+						{
+							::close(result);
+						}
+						freeState = !more && !state.m_releasing;
+					}
+					else
+					{
+						state.m_results.push_back(result);
+						resume = std::exchange(state.m_waiting, false);
+					}
+				}
+				if (freeState)
+				{
+					delete &state;
+				}
+				return resume;
+			}
+
+			void close_results() noexcept
+			{
+				for (const int result : m_results)
+				{
+					if (result >= 0)
+					{
+						::close(result);
+					}
+				}
+				m_results.clear();
+			}
+
+			cppcoro::detail::lnx::io_queue& m_queue;
+			const int m_listeningFd;
+			cppcoro::detail::lnx::io_message m_message;
+
+			std::mutex m_mutex;
+			std::deque<int> m_results;
+			bool m_armed = false;
+			bool m_waiting = false;
+			bool m_cancelled = false;
+			bool m_released = false;
+			bool m_releasing = false;
+
+		};
+#endif
+	}
+}
+
+cppcoro::async_generator<cppcoro::net::socket>
+cppcoro::net::socket::accept_stream()
+{
+	return accept_stream(cancellation_token{});
+}
+
+cppcoro::async_generator<cppcoro::net::socket>
+cppcoro::net::socket::accept_stream(cancellation_token ct)
+{
+#if CPPCORO_USE_IO_RING
+	// The multishot accept is only stopped by ASYNC_CANCEL.
+	if (m_ioQueue.capabilities().accept && m_ioQueue.capabilities().async_cancel)
+	{
+		auto* state = new local::multishot_accept{ m_ioQueue, m_handle };
+		auto releaseState = on_scope_exit([state] { state->release(); });
+
+		// Destroyed first so that no cancellation callback runs past release().
+		std::optional<cancellation_registration> registration;
+		if (ct.can_be_cancelled())
+		{
+			registration.emplace(ct, [state] { state->cancel(); });
+		}
+
+		bool accepted = false;
+		while (true)
+		{
+			state->arm();
+			const int result = co_await state->next();
+			if (result >= 0)
+			{
+				accepted = true;
+				socket acceptedSocket{ m_ioQueue, result };
+				local::set_endpoints(
+					result, acceptedSocket.m_localEndPoint, acceptedSocket.m_remoteEndPoint);
+				co_yield std::move(acceptedSocket);
+			}
+			else if (result == -ECANCELED && ct.is_cancellation_requested())
+			{
+				throw operation_cancelled{};
+			}
+			else if (result == -EINVAL && !accepted)
+			{
+				// IORING_ACCEPT_MULTISHOT arrived in 5.19, accept one at a time.
+				break;
+			}
+			else
+			{
+				throw std::system_error{ -result, std::system_category() };
+			}
+		}
+	}
+#endif
+
+	while (true)
+	{
+		// accept() replaces the placeholder with the accepted socket.
+		socket acceptedSocket{ m_ioQueue, INVALID_SOCKET };
+		co_await accept(acceptedSocket, ct);
+		co_yield std::move(acceptedSocket);
+	}
+}
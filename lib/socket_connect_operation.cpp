@@ -177,14 +177,38 @@ void cppcoro::net::socket_connect_operation_impl::get_result(
 
 #else
 
+#include <fcntl.h>
+#include <poll.h>
+
 bool cppcoro::net::socket_connect_operation_impl::try_start(
     cppcoro::detail::io_operation_base& operation) noexcept
 {
-    SOCKADDR_STORAGE remoteSockaddrStorage;
     const int remoteLength =
-	    detail::ip_endpoint_to_sockaddr(m_remoteEndPoint, std::ref(remoteSockaddrStorage));
+	    detail::ip_endpoint_to_sockaddr(m_remoteEndPoint, std::ref(m_remoteSockaddrStorage));
+#if CPPCORO_USE_IO_RING
+    if (!operation.m_ioQueue.capabilities().connect || !operation.m_ioQueue.capabilities().async_cancel)
+    {
+        // Start the connection without blocking and wait for the socket to
+        // become writable, get_result() then checks SO_ERROR.
+        const int fd = m_socket.native_handle();
+        const int flags = ::fcntl(fd, F_GETFL);
+        ::fcntl(fd, F_SETFL, flags | O_NONBLOCK);
+        const int result = ::connect(
+            fd, reinterpret_cast<const sockaddr*>(&m_remoteSockaddrStorage), remoteLength);
+        const int error = result < 0 ? errno : 0;
+        ::fcntl(fd, F_SETFL, flags);
+        if (error != EINPROGRESS)
+        {
+            operation.m_message.result = -error;
+            return false;
+        }
+        return operation.m_ioQueue.transaction(operation.m_message)
+            .poll(fd, POLLOUT)
+            .commit();
+    }
+#endif
     return operation.m_ioQueue.transaction(operation.m_message)
-        .connect(m_socket.native_handle(), &remoteSockaddrStorage, remoteLength)
+        .connect(m_socket.native_handle(), &m_remoteSockaddrStorage, remoteLength)
         .commit();
 }
 
@@ -199,6 +223,25 @@ void cppcoro::net::socket_connect_operation_impl::cancel(
 void cppcoro::net::socket_connect_operation_impl::get_result(
     cppcoro::detail::io_operation_base& operation)
 {
+#if CPPCORO_USE_IO_RING
+    if (!operation.m_ioQueue.capabilities().connect || !operation.m_ioQueue.capabilities().async_cancel)
+    {
+        operation.get_result();
+        int error = 0;
+        socklen_t errorLength = sizeof(error);
+        if (getsockopt(m_socket.native_handle(), SOL_SOCKET, SO_ERROR, &error, &errorLength) < 0)
+        {
+            error = errno;
+        }
+        if (error != 0)
+        {
+            throw std::system_error{
+                error,
+                std::generic_category()
+            };
+        }
+    }
+#endif
     SOCKADDR_STORAGE remoteSockaddrStorage;
     socklen_t remoteSockaddrStorageLength = sizeof(remoteSockaddrStorage);
     if(getpeername(m_socket.native_handle(), reinterpret_cast<sockaddr*>(&remoteSockaddrStorage), &remoteSockaddrStorageLength) < 0) {
@@ -109,6 +109,10 @@ void cppcoro::net::socket_disconnect_operation_impl::get_result(
 bool cppcoro::net::socket_disconnect_operation_impl::try_start(
     cppcoro::detail::io_operation_base& operation) noexcept
 {
+#if CPPCORO_USE_IO_RING
+	// The fixed file table holds a reference that would keep the socket open.
+	operation.m_ioQueue.unregister_file(m_socket.native_handle());
+#endif
     return operation.m_ioQueue.transaction(operation.m_message)
 		.close(m_socket.native_handle()).commit();
 }
@@ -92,6 +92,8 @@ cppcoro::net::socket_recv_from_operation_impl::get_result(
 
 #elif CPPCORO_OS_LINUX
 
+#include <poll.h>
+
 bool cppcoro::net::socket_recv_from_operation_impl::try_start(
     cppcoro::detail::io_operation_base &operation) noexcept {
     m_vec.iov_base = m_buffer.buffer;
@@ -101,6 +103,15 @@ bool cppcoro::net::socket_recv_from_operation_impl::try_start(
     m_msgHdr.msg_namelen = sizeof(m_sourceSockaddrStorage);
     m_msgHdr.msg_iov = &m_vec;
     m_msgHdr.msg_iovlen = 1;
+#if CPPCORO_USE_IO_RING
+	if (!operation.m_ioQueue.capabilities().async_cancel)
+	{
+		// Wait for a datagram so that POLL_REMOVE can cancel, get_result() receives.
+		return operation.m_ioQueue.transaction(operation.m_message)
+			.poll(m_socket.native_handle(), POLLIN)
+			.commit();
+	}
+#endif
 	return operation.m_ioQueue.transaction(operation.m_message)
 		.recvmsg(m_socket.native_handle(), &m_msgHdr, m_socket.m_recvFlags)
 		.commit();
@@ -117,6 +128,18 @@ cppcoro::net::socket_recv_from_operation_impl::get_result(
     cppcoro::detail::io_operation_base &operation)
 {
 	auto size = operation.get_result();  // may throw errors
+#if CPPCORO_USE_IO_RING
+	if (!operation.m_ioQueue.capabilities().async_cancel)
+	{
+		const auto received =
+			::recvmsg(m_socket.native_handle(), &m_msgHdr, m_socket.m_recvFlags | MSG_DONTWAIT);
+		if (received < 0)
+		{
+			throw std::system_error{ errno, std::system_category() };
+		}
+		size = static_cast<std::size_t>(received);
+	}
+#endif
 	if (size > m_buffer.size)
 	{
 		throw std::system_error{
@@ -61,9 +61,47 @@ void cppcoro::net::socket_recv_operation_impl::cancel(
 
 #else
 
+#include <poll.h>
+
 bool cppcoro::net::socket_recv_operation_impl::try_start(
 	cppcoro::detail::io_operation_base& operation) noexcept
 {
+#if CPPCORO_USE_IO_RING
+	if (!operation.m_ioQueue.capabilities().async_cancel)
+	{
+		// Wait for data so that POLL_REMOVE can cancel, get_result() receives.
+		if (m_vecs != nullptr)
+		{
+			m_msgHdr = {};
+			m_msgHdr.msg_iov = const_cast<iovec*>(m_vecs);
+			m_msgHdr.msg_iovlen = m_vecCount;
+		}
+		return operation.m_ioQueue.transaction(operation.m_message)
+			.poll(m_socket.native_handle(), POLLIN)
+			.commit();
+	}
+#endif
+	if (m_vecs != nullptr)
+	{
+		m_msgHdr = {};
+		m_msgHdr.msg_iov = const_cast<iovec*>(m_vecs);
+		m_msgHdr.msg_iovlen = m_vecCount;
+		return operation.m_ioQueue.transaction(operation.m_message)
+			.recvmsg(m_socket.native_handle(), &m_msgHdr, m_socket.m_recvFlags)
+			.commit();
+	}
+#if CPPCORO_USE_IO_RING
+	if (!operation.m_ioQueue.capabilities().recv)
+	{
+		m_vec = { m_buffer.buffer, m_buffer.size };
+		m_msgHdr = {};
+		m_msgHdr.msg_iov = &m_vec;
+		m_msgHdr.msg_iovlen = 1;
+		return operation.m_ioQueue.transaction(operation.m_message)
+			.recvmsg(m_socket.native_handle(), &m_msgHdr, m_socket.m_recvFlags)
+			.commit();
+	}
+#endif
 	return operation.m_ioQueue.transaction(operation.m_message)
 		.recv(m_socket.native_handle(), m_buffer.buffer, m_buffer.size, m_socket.m_recvFlags)
 		.commit();
@@ -81,6 +119,20 @@ std::size_t
 cppcoro::net::socket_recv_operation_impl::get_result(cppcoro::detail::io_operation_base& operation)
 {
 	auto size = operation.get_result();
+#if CPPCORO_USE_IO_RING
+	if (!operation.m_ioQueue.capabilities().async_cancel)
+	{
+		const int flags = m_socket.m_recvFlags | MSG_DONTWAIT;
+		const auto received = m_vecs != nullptr
+			? ::recvmsg(m_socket.native_handle(), &m_msgHdr, flags)
+			: ::recv(m_socket.native_handle(), m_buffer.buffer, m_buffer.size, flags);
+		if (received < 0)
+		{
+			throw std::system_error{ errno, std::system_category() };
+		}
+		size = static_cast<std::size_t>(received);
+	}
+#endif
 	if (size > m_buffer.size)
 	{
 		throw std::system_error{
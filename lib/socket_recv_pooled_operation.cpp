@@ -0,0 +1,104 @@
+///////////////////////////////////////////////////////////////////////////////
+// Copyright (c) Lewis Baker
+// Licenced under MIT license. See LICENSE.txt for details.
+///////////////////////////////////////////////////////////////////////////////
+
+#include <cppcoro/net/socket_recv_pooled_operation.hpp>
+#include <cppcoro/net/socket.hpp>
+#include <cppcoro/io_service.hpp>
+
+#include <system_error>
+
+#include <poll.h>
+#include <sys/socket.h>
+
+const std::byte* cppcoro::net::pooled_buffer::data() const noexcept
+{
+	return m_id >= 0 ? m_queue->provided_buffer(m_id) : nullptr;
+}
+
+void cppcoro::net::pooled_buffer::reset() noexcept
+{
+	if (m_id >= 0)
+	{
+		m_queue->recycle_provided_buffer(std::exchange(m_id, -1));
+		m_size = 0;
+	}
+}
+
+bool cppcoro::net::socket_recv_pooled_operation_impl::try_start(
+	cppcoro::detail::io_operation_base& operation) noexcept
+{
+#if CPPCORO_USE_IO_RING
+	if (!operation.m_ioQueue.init_provided_buffers())
+	{
+		m_polled = true;
+		return operation.m_ioQueue.transaction(operation.m_message)
+			.poll(m_socket.native_handle(), POLLIN)
+			.commit();
+	}
+	// The buffer ring is only registered with the shared ring.
+	return operation.m_ioQueue.shared_transaction(operation.m_message)
+		.recv_provided(m_socket.native_handle(), m_socket.m_recvFlags)
+		.commit();
+#else
+	return operation.m_ioQueue.transaction(operation.m_message)
+		.recv_provided(m_socket.native_handle(), m_socket.m_recvFlags)
+		.commit();
+#endif
+}
+
+void cppcoro::net::socket_recv_pooled_operation_impl::cancel(
+	cppcoro::detail::io_operation_base& operation) noexcept
+{
+	operation.m_ioQueue.transaction(operation.m_message)
+		.cancel()
+		.commit();
+}
+
+cppcoro::net::pooled_buffer cppcoro::net::socket_recv_pooled_operation_impl::get_result(
+	cppcoro::detail::io_operation_base& operation)
+{
+	// Throws on failure, leaving any buffer to discard().
+	const std::size_t size = operation.get_result();
+
+#if CPPCORO_USE_IO_RING
+	if (m_polled)
+	{
+		const int id = operation.m_ioQueue.take_provided_buffer();
+		if (id < 0)
+		{
+			throw std::system_error{ ENOBUFS, std::system_category() };
+		}
+		const auto received = ::recv(
+			m_socket.native_handle(),
+			operation.m_ioQueue.provided_buffer(id),
+			operation.m_ioQueue.provided_buffer_size(),
+			m_socket.m_recvFlags | MSG_DONTWAIT);
+		if (received < 0)
+		{
+			const int error = errno;
+			operation.m_ioQueue.recycle_provided_buffer(id);
+			throw std::system_error{ error, std::system_category() };
+		}
+		return pooled_buffer{ operation.m_ioQueue, id, static_cast<std::size_t>(received) };
+	}
+#endif
+
+	const int id = std::exchange(operation.m_message.bufferId, -1);
+	if (id < 0)
+	{
+		return pooled_buffer{};
+	}
+	return pooled_buffer{ operation.m_ioQueue, id, size };
+}
+
+void cppcoro::net::socket_recv_pooled_operation_impl::discard(
+	cppcoro::detail::io_operation_base& operation) noexcept
+{
+	if (operation.m_message.bufferId >= 0)
+	{
+		operation.m_ioQueue.recycle_provided_buffer(
+			std::exchange(operation.m_message.bufferId, -1));
+	}
+}
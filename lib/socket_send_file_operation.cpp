@@ -0,0 +1,96 @@
+///////////////////////////////////////////////////////////////////////////////
+// Copyright (c) Lewis Baker
+// Licenced under MIT license. See LICENSE.txt for details.
+///////////////////////////////////////////////////////////////////////////////
+
+#include <cppcoro/net/socket_send_file_operation.hpp>
+
+#include <algorithm>
+#include <system_error>
+
+#include <linux/sockios.h>
+#include <poll.h>
+#include <sys/ioctl.h>
+#include <sys/sendfile.h>
+#include <sys/socket.h>
+
+#if CPPCORO_USE_IO_RING
+namespace
+{
+	namespace local
+	{
+		/// Bytes sendfile() can queue on the blocking socket \a fd without
+		/// waiting for buffer space.
+		std::size_t send_buffer_space(int fd)
+		{
+			int sendBuffer = 0;
+			socklen_t sendBufferLength = sizeof(sendBuffer);
+			int queued = 0;
+			if (::getsockopt(fd, SOL_SOCKET, SO_SNDBUF, &sendBuffer, &sendBufferLength) < 0 ||
+				::ioctl(fd, SIOCOUTQ, &queued) < 0)
+			{
+				throw std::system_error{ errno, std::system_category(), "Error sending file: SIOCOUTQ" };
+			}
+
+			// SO_SNDBUF reports twice the payload the buffer holds, the other
+			// half covers bookkeeping. The socket polled writable, which
+			// leaves room for a small write however full it looks.
+			constexpr std::size_t minSpace = 4096;
+			const int space = sendBuffer / 2 - queued;
+			return std::max(space > 0 ? static_cast<std::size_t>(space) : 0, minSpace);
+		}
+	}
+}
+#endif
+
+bool cppcoro::net::socket_send_file_operation_impl::try_start(
+	cppcoro::detail::io_operation_base& operation) noexcept
+{
+#if CPPCORO_USE_IO_RING
+	if (m_kind == kind::splice)
+	{
+		return operation.m_ioQueue.transaction(operation.m_message)
+			.splice(m_fdIn, m_offsetIn, m_fdOut, -1, static_cast<std::uint32_t>(m_byteCount), SPLICE_F_MOVE)
+			.commit();
+	}
+
+	// Wait for the socket to be writable, get_result() sends.
+	return operation.m_ioQueue.transaction(operation.m_message)
+		.poll(m_fdOut, POLLOUT)
+		.commit();
+#else
+	return operation.m_ioQueue.transaction(operation.m_message)
+		.sendfile(m_fdOut, m_fdIn, static_cast<std::uint64_t>(m_offsetIn), m_byteCount)
+		.commit();
+#endif
+}
+
+void cppcoro::net::socket_send_file_operation_impl::cancel(
+	cppcoro::detail::io_operation_base& operation) noexcept
+{
+	operation.m_ioQueue.transaction(operation.m_message)
+		.cancel()
+		.commit();
+}
+
+std::size_t cppcoro::net::socket_send_file_operation_impl::get_result(
+	cppcoro::detail::io_operation_base& operation)
+{
+	const std::size_t result = operation.get_result();
+#if CPPCORO_USE_IO_RING
+	if (m_kind == kind::sendfile)
+	{
+		// The socket blocks, send only what fits in its buffer. Its file
+		// flags are shared with every other user of the socket, leave them.
+		const std::size_t byteCount = std::min(m_byteCount, local::send_buffer_space(m_fdOut));
+		auto offset = static_cast<off_t>(m_offsetIn);
+		const auto sent = ::sendfile(m_fdOut, m_fdIn, &offset, byteCount);
+		if (sent < 0)
+		{
+			throw std::system_error{ errno, std::system_category(), "Error sending file: sendfile" };
+		}
+		return static_cast<std::size_t>(sent);
+	}
+#endif
+	return result;
+}
@@ -61,9 +61,62 @@ void cppcoro::net::socket_send_operation_impl::cancel(
 
 #else
 
+#include <poll.h>
+#include <system_error>
+
 bool cppcoro::net::socket_send_operation_impl::try_start(
     cppcoro::detail::io_operation_base& operation) noexcept
 {
+#if CPPCORO_USE_IO_RING
+	if (!operation.m_ioQueue.capabilities().async_cancel)
+	{
+		// Wait for buffer space so that POLL_REMOVE can cancel, get_result()
+		// sends, copying even when zero copy was asked for.
+		if (m_vecs != nullptr)
+		{
+			m_msgHdr = {};
+			m_msgHdr.msg_iov = const_cast<iovec*>(m_vecs);
+			m_msgHdr.msg_iovlen = m_vecCount;
+		}
+		return operation.m_ioQueue.transaction(operation.m_message)
+			.poll(m_socket.native_handle(), POLLOUT)
+			.commit();
+	}
+#endif
+	if (m_vecs != nullptr)
+	{
+		m_msgHdr = {};
+		m_msgHdr.msg_iov = const_cast<iovec*>(m_vecs);
+		m_msgHdr.msg_iovlen = m_vecCount;
+		return operation.m_ioQueue.transaction(operation.m_message)
+			.sendmsg(m_socket.native_handle(), &m_msgHdr)
+			.commit();
+	}
+#if CPPCORO_USE_IO_RING
+	// Without SEND_ZC, send_zc() would go out as SEND; copy below instead,
+	// which falls back to SENDMSG on kernels lacking that as well.
+	const bool zeroCopy = m_zeroCopy && operation.m_ioQueue.capabilities().send_zc;
+#else
+	const bool zeroCopy = m_zeroCopy;
+#endif
+	if (zeroCopy && (m_bufferIndex >= 0 || m_buffer.size >= zero_copy_threshold))
+	{
+		return operation.m_ioQueue.transaction(operation.m_message)
+			.send_zc(m_socket.native_handle(), m_buffer.buffer, m_buffer.size, 0, m_bufferIndex)
+			.commit();
+	}
+#if CPPCORO_USE_IO_RING
+	if (!operation.m_ioQueue.capabilities().send)
+	{
+		m_vec = { m_buffer.buffer, m_buffer.size };
+		m_msgHdr = {};
+		m_msgHdr.msg_iov = &m_vec;
+		m_msgHdr.msg_iovlen = 1;
+		return operation.m_ioQueue.transaction(operation.m_message)
+			.sendmsg(m_socket.native_handle(), &m_msgHdr)
+			.commit();
+	}
+#endif
 	return operation.m_ioQueue.transaction(operation.m_message)
 		.send(m_socket.native_handle(), m_buffer.buffer, m_buffer.size)
 		.commit();
@@ -77,4 +130,25 @@ void cppcoro::net::socket_send_operation_impl::cancel(
         .commit();
 }
 
+std::size_t cppcoro::net::socket_send_operation_impl::get_result(
+	cppcoro::detail::io_operation_base& operation)
+{
+	const std::size_t result = operation.get_result();
+#if CPPCORO_USE_IO_RING
+	if (!operation.m_ioQueue.capabilities().async_cancel)
+	{
+		const int flags = MSG_DONTWAIT | MSG_NOSIGNAL;
+		const auto sent = m_vecs != nullptr
+			? ::sendmsg(m_socket.native_handle(), &m_msgHdr, flags)
+			: ::send(m_socket.native_handle(), m_buffer.buffer, m_buffer.size, flags);
+		if (sent < 0)
+		{
+			throw std::system_error{ errno, std::system_category() };
+		}
+		return static_cast<std::size_t>(sent);
+	}
+#endif
+	return result;
+}
+
 #endif
@@ -66,6 +66,9 @@ void cppcoro::net::socket_send_to_operation_impl::cancel(
 		reinterpret_cast<HANDLE>(m_socket.native_handle()), operation.get_overlapped());
 }
 #elif CPPCORO_OS_LINUX
+
+#include <poll.h>
+
 bool cppcoro::net::socket_send_to_operation_impl::try_start(
 	cppcoro::detail::io_operation_base& operation) noexcept
 {
@@ -79,6 +82,15 @@ bool cppcoro::net::socket_send_to_operation_impl::try_start(
     m_msgHdr.msg_namelen = destinationLength;
     m_msgHdr.msg_iov = &m_vec;
     m_msgHdr.msg_iovlen = 1;
+#if CPPCORO_USE_IO_RING
+    if (!operation.m_ioQueue.capabilities().async_cancel)
+    {
+        // Wait for buffer space so that POLL_REMOVE can cancel, get_result() sends.
+        return operation.m_ioQueue.transaction(operation.m_message)
+            .poll(m_socket.native_handle(), POLLOUT)
+            .commit();
+    }
+#endif
     return operation.m_ioQueue.transaction(operation.m_message)
         .sendmsg(m_socket.native_handle(), &m_msgHdr)
         .commit();
@@ -91,4 +103,22 @@ void cppcoro::net::socket_send_to_operation_impl::cancel(
 	    .cancel().commit();
 }
 
+std::size_t cppcoro::net::socket_send_to_operation_impl::get_result(
+	cppcoro::detail::io_operation_base& operation)
+{
+    const std::size_t result = operation.get_result();
+#if CPPCORO_USE_IO_RING
+    if (!operation.m_ioQueue.capabilities().async_cancel)
+    {
+        const auto sent = ::sendmsg(m_socket.native_handle(), &m_msgHdr, MSG_DONTWAIT | MSG_NOSIGNAL);
+        if (sent < 0)
+        {
+            throw std::system_error{ errno, std::system_category() };
+        }
+        return static_cast<std::size_t>(sent);
+    }
+#endif
+    return result;
+}
+
 #endif
@@ -4,16 +4,27 @@
 ///////////////////////////////////////////////////////////////////////////////
 
 #include <cppcoro/static_thread_pool.hpp>
+#include <cppcoro/config.hpp>
+#include <cppcoro/filesystem.hpp>
 
-#include "auto_reset_event.hpp"
 #include "spin_mutex.hpp"
 #include "spin_wait.hpp"
+#include "thread_parker.hpp"
 
+#include <algorithm>
 #include <cassert>
 #include <mutex>
 #include <chrono>
+#include <fstream>
+#include <string>
+#include <system_error>
 #include <utility>
 
+#if CPPCORO_OS_LINUX
+# include <pthread.h>
+# include <sched.h>
+#endif
+
 namespace
 {
 	namespace local
@@ -21,6 +32,92 @@ namespace
 		// Keep each thread's local queue under 1MB
 		constexpr std::size_t max_local_queue_size = 1024 * 1024 / sizeof(void*);
 		constexpr std::size_t initial_local_queue_size = 256;
+
+		// Most operations taken from another thread's queue in one steal.
+		constexpr std::size_t max_steal_batch_size = 128;
+
+		using idle_clock = std::chrono::steady_clock;
+
+		std::chrono::nanoseconds::rep now_ns() noexcept
+		{
+			return std::chrono::duration_cast<std::chrono::nanoseconds>(
+				idle_clock::now().time_since_epoch()).count();
+		}
+
+		constexpr std::uint32_t unknown_node = static_cast<std::uint32_t>(-1);
+
+		/// Parse a sysfs CPU list such as "0-3,8,10-11".
+		std::vector<std::uint32_t> parse_cpu_list(const std::string& list)
+		{
+			std::vector<std::uint32_t> cpus;
+			std::size_t pos = 0;
+			while (pos < list.size())
+			{
+				const auto end = std::min(list.find(',', pos), list.size());
+				const auto range = list.substr(pos, end - pos);
+				pos = end + 1;
+
+				const auto dash = range.find('-');
+				try
+				{
+					const auto first = static_cast<std::uint32_t>(std::stoul(range.substr(0, dash)));
+					const auto last = dash == std::string::npos
+						? first
+						: static_cast<std::uint32_t>(std::stoul(range.substr(dash + 1)));
+					for (auto cpu = first; cpu <= last; ++cpu)
+					{
+						cpus.push_back(cpu);
+					}
+				}
+				catch (const std::logic_error&)
+				{
+					// Skip anything that isn't a number, e.g. the trailing newline.
+				}
+			}
+			return cpus;
+		}
+
+		std::vector<std::uint32_t> read_node_cpus(std::uint32_t node)
+		{
+			std::ifstream file{ "/sys/devices/system/node/node" + std::to_string(node) + "/cpulist" };
+			std::string list;
+			if (!std::getline(file, list))
+			{
+				return {};
+			}
+			return parse_cpu_list(list);
+		}
+
+		/// The NUMA node of each CPU, indexed by CPU number. Empty if the
+		/// topology isn't known.
+		std::vector<std::uint32_t> read_cpu_nodes()
+		{
+			std::vector<std::uint32_t> cpuNodes;
+
+			std::error_code ec;
+			cppcoro::filesystem::directory_iterator it{ "/sys/devices/system/node", ec };
+			for (; !ec && it != cppcoro::filesystem::directory_iterator{}; it.increment(ec))
+			{
+				const auto name = it->path().filename().string();
+				if (name.rfind("node", 0) != 0 || name.size() == 4 ||
+					name.find_first_not_of("0123456789", 4) != std::string::npos)
+				{
+					continue;
+				}
+
+				const auto node = static_cast<std::uint32_t>(std::stoul(name.substr(4)));
+				for (auto cpu : read_node_cpus(node))
+				{
+					if (cpu >= cpuNodes.size())
+					{
+						cpuNodes.resize(cpu + 1, unknown_node);
+					}
+					cpuNodes[cpu] = node;
+				}
+			}
+
+			return cpuNodes;
+		}
 	}
 }
 
@@ -44,20 +141,36 @@ namespace cppcoro
 		{
 		}
 
+		/// Set the index of the NUMA node of this thread and the threads to
+		/// steal from, the first \a sameNodeVictimCount of them being on the
+		/// same node.
+		void set_placement(
+			std::uint32_t threadIndex,
+			std::uint32_t nodeIndex,
+			std::vector<std::uint32_t> victims,
+			std::size_t sameNodeVictimCount)
+		{
+			m_nodeIndex = nodeIndex;
+			m_victims = std::move(victims);
+			m_sameNodeVictimCount = sameNodeVictimCount;
+			// Any non-zero seed will do, as long as threads differ.
+			m_randomState = 0x9E3779B9u * (threadIndex + 1);
+		}
+
+		std::uint32_t node_index() const noexcept { return m_nodeIndex; }
+
+		const std::vector<std::uint32_t>& victims() const noexcept { return m_victims; }
+
+		std::size_t same_node_victim_count() const noexcept { return m_sameNodeVictimCount; }
+
 		bool try_wake_up()
 		{
 			if (m_isSleeping.load(std::memory_order_seq_cst))
 			{
 				if (m_isSleeping.exchange(false, std::memory_order_seq_cst))
 				{
-					try
-					{
-						m_wakeUpEvent.set();
-					}
-					catch (...)
-					{
-						// TODO: What do we do here?
-					}
+					m_wakeRequestTime.store(local::now_ns(), std::memory_order_relaxed);
+					m_parker.unpark();
 					return true;
 				}
 			}
@@ -70,19 +183,89 @@ namespace cppcoro
 			m_isSleeping.store(true, std::memory_order_relaxed);
 		}
 
+		bool approx_is_sleeping() const noexcept
+		{
+			return m_isSleeping.load(std::memory_order_relaxed);
+		}
+
 		void sleep_until_woken() noexcept
 		{
-			try
+			increment(m_parkCount);
+
+			// Only measured after blocking, which is when the latency
+			// matters, unlike wake-ups of threads that were still spinning.
+			// Those leave an unpark() behind that the next park() consumes
+			// straight away, long after m_wakeRequestTime was set.
+			if (!m_parker.park())
 			{
-				m_wakeUpEvent.wait();
+				return;
 			}
-			catch (...)
+
+			const auto latency =
+				local::now_ns() - m_wakeRequestTime.load(std::memory_order_relaxed);
+			if (latency >= 0)
+			{
+				increment(m_wakeUpCount);
+				add(m_totalWakeLatency, latency);
+				if (latency > m_maxWakeLatency.load(std::memory_order_relaxed))
+				{
+					m_maxWakeLatency.store(latency, std::memory_order_relaxed);
+				}
+			}
+		}
+
+		/// How long to spin for before parking when running out of work.
+		std::chrono::nanoseconds spin_duration(
+			idle_policy policy, std::chrono::nanoseconds maxSpinDuration) const noexcept
+		{
+			switch (policy)
+			{
+			case idle_policy::park:
+				return std::chrono::nanoseconds{ 0 };
+			case idle_policy::spin:
+				break;
+			case idle_policy::adaptive:
+				// Work that arrives later than the spin time allows is
+				// better waited for parked.
+				if (2 * m_averageIdleTime <= maxSpinDuration)
+				{
+					return 2 * m_averageIdleTime;
+				}
+				return std::chrono::nanoseconds{ 0 };
+			}
+			return maxSpinDuration;
+		}
+
+		/// Record that the thread found work \a idleTime after running out,
+		/// having spun for \a spinTime.
+		void on_idle_end(
+			std::chrono::nanoseconds idleTime,
+			std::chrono::nanoseconds spinTime,
+			bool foundWhileSpinning) noexcept
+		{
+			// Exponential moving average over roughly the last 8 intervals.
+			m_averageIdleTime += (idleTime - m_averageIdleTime) / 8;
+
+			add(m_spinTime, spinTime.count());
+			if (foundWhileSpinning)
 			{
-				using namespace std::chrono_literals;
-				std::this_thread::sleep_for(1ms);
+				increment(m_spinSuccessCount);
 			}
 		}
 
+		void add_stats(idle_stats& stats) const noexcept
+		{
+			stats.spin_successes += m_spinSuccessCount.load(std::memory_order_relaxed);
+			stats.spin_time += std::chrono::nanoseconds{ m_spinTime.load(std::memory_order_relaxed) };
+			stats.parks += m_parkCount.load(std::memory_order_relaxed);
+			stats.wake_ups += m_wakeUpCount.load(std::memory_order_relaxed);
+			stats.total_wake_latency += std::chrono::nanoseconds{
+				m_totalWakeLatency.load(std::memory_order_relaxed) };
+			stats.max_wake_latency = std::max(
+				stats.max_wake_latency,
+				std::chrono::nanoseconds{ m_maxWakeLatency.load(std::memory_order_relaxed) });
+		}
+
 		bool approx_has_any_queued_work() const noexcept
 		{
 			return difference(
@@ -234,7 +417,15 @@ namespace cppcoro
 			return m_localQueue[newHead & m_mask].load(std::memory_order_relaxed);
 		}
 
-		schedule_operation* try_steal(bool* lockUnavailable = nullptr) noexcept
+		/// Steal up to half of the operations in the queue, at most \a maxCount,
+		/// oldest first.
+		///
+		/// \return
+		/// The number of operations stolen into \a operations.
+		std::size_t try_steal(
+			schedule_operation** operations,
+			std::size_t maxCount,
+			bool* lockUnavailable = nullptr) noexcept
 		{
 			if (lockUnavailable == nullptr)
 			{
@@ -243,7 +434,7 @@ namespace cppcoro
 			else if (!m_remoteMutex.try_lock())
 			{
 				*lockUnavailable = true;
-				return nullptr;
+				return 0;
 			}
 
 			std::scoped_lock lock{ std::adopt_lock, m_remoteMutex };
@@ -252,36 +443,63 @@ namespace cppcoro
 			auto head = m_head.load(std::memory_order_seq_cst);
 			if (difference(head, tail) <= 0)
 			{
-				return nullptr;
+				return 0;
 			}
 
-			// It looks like there are items in the queue.
-			// We'll speculatively try to steal one by incrementing
-			// the tail cursor. As this may be running concurrently
-			// with try_local_pop() which is also speculatively trying
-			// to remove an item from the other end of the queue we
-			// need to re-read  the 'head' cursor afterwards to see
-			// if there was a potential race to dequeue the last item.
-			// Use seq_cst memory order both here and in try_local_pop()
-			// to ensure that either we will see their write to head or
-			// they will see our write to tail or we will both see each
-			// other's writes.
-			m_tail.store(tail + 1, std::memory_order_seq_cst);
-			head = m_head.load(std::memory_order_seq_cst);
+			const auto batchSize = std::min(
+				static_cast<std::size_t>(difference(head, tail) + 1) / 2, maxCount);
 
-			if (difference(head, tail) > 0)
+			// Claim the operations one at a time, the owner pops without
+			// taking the lock and may be racing us for any of them.
+			//
+			// Claiming the whole batch with one increment of tail instead
+			// would free the slots before they have all been read, and the
+			// owner only leaves one slot free behind tail before wrapping
+			// around onto them.
+			std::size_t count = 0;
+			while (count < batchSize)
 			{
+				// It looks like there are items in the queue.
+				// We'll speculatively try to steal one by incrementing
+				// the tail cursor. As this may be running concurrently
+				// with try_local_pop() which is also speculatively trying
+				// to remove an item from the other end of the queue we
+				// need to re-read  the 'head' cursor afterwards to see
+				// if there was a potential race to dequeue the last item.
+				// Use seq_cst memory order both here and in try_local_pop()
+				// to ensure that either we will see their write to head or
+				// they will see our write to tail or we will both see each
+				// other's writes.
+				m_tail.store(tail + 1, std::memory_order_seq_cst);
+				head = m_head.load(std::memory_order_seq_cst);
+
+				if (difference(head, tail) <= 0)
+				{
+					// We failed to steal the last item.
+					// Restore the old tail position.
+					m_tail.store(tail, std::memory_order_seq_cst);
+					break;
+				}
+
 				// There was still an item in the queue after incrementing tail.
 				// We managed to steal an item from the bottom of the stack.
-				return m_localQueue[tail & m_mask].load(std::memory_order_relaxed);
-			}
-			else
-			{
-				// Otherwise we failed to steal the last item.
-				// Restore the old tail position.
-				m_tail.store(tail, std::memory_order_seq_cst);
-				return nullptr;
+				operations[count++] = m_localQueue[tail & m_mask].load(std::memory_order_relaxed);
+				++tail;
 			}
+
+			return count;
+		}
+
+		/// Returns a random number to pick victims with.
+		std::uint32_t next_random() noexcept
+		{
+			// xorshift32, only ever used by the owning thread.
+			auto x = m_randomState;
+			x ^= x << 13;
+			x ^= x >> 17;
+			x ^= x << 5;
+			m_randomState = x;
+			return x;
 		}
 
 	private:
@@ -293,9 +511,27 @@ namespace cppcoro
 			return static_cast<offset_t>(a - b);
 		}
 
+		// Counters are only written by the owning thread, no need for an
+		// atomic read-modify-write.
+		template<typename T>
+		static void add(std::atomic<T>& counter, T value) noexcept
+		{
+			counter.store(counter.load(std::memory_order_relaxed) + value, std::memory_order_relaxed);
+		}
+
+		static void increment(std::atomic<std::uint64_t>& counter) noexcept
+		{
+			add<std::uint64_t>(counter, 1);
+		}
+
 		std::unique_ptr<std::atomic<schedule_operation*>[]> m_localQueue;
 		std::size_t m_mask;
 
+		std::uint32_t m_nodeIndex = 0;
+		std::vector<std::uint32_t> m_victims;
+		std::size_t m_sameNodeVictimCount = 0;
+		std::uint32_t m_randomState = 1;
+
 #if CPPCORO_COMPILER_MSVC
 # pragma warning(push)
 # pragma warning(disable : 4324)
@@ -315,7 +551,166 @@ namespace cppcoro
 # pragma warning(pop)
 #endif
 
-		auto_reset_event m_wakeUpEvent;
+		thread_parker m_parker;
+
+		// local::now_ns() at the last try_wake_up().
+		std::atomic<std::chrono::nanoseconds::rep> m_wakeRequestTime{ 0 };
+
+		// Only used by the owning thread.
+		std::chrono::nanoseconds m_averageIdleTime{ 0 };
+
+		std::atomic<std::uint64_t> m_spinSuccessCount{ 0 };
+		std::atomic<std::chrono::nanoseconds::rep> m_spinTime{ 0 };
+		std::atomic<std::uint64_t> m_parkCount{ 0 };
+		std::atomic<std::uint64_t> m_wakeUpCount{ 0 };
+		std::atomic<std::chrono::nanoseconds::rep> m_totalWakeLatency{ 0 };
+		std::atomic<std::chrono::nanoseconds::rep> m_maxWakeLatency{ 0 };
+
+	};
+
+	/// Lock-free queue that any thread can push operations to, taken from by
+	/// the worker threads.
+	///
+	/// Operations are pushed onto an intrusive stack with a CAS. Consumers
+	/// don't pop them one at a time but take the whole stack with a single
+	/// exchange, so there is no ABA problem and no lock, and spread it over
+	/// their local queue, or for a node's queue hold it for the node's
+	/// threads. Each consumer thus touches the shared cache line once per
+	/// batch rather than once per operation.
+	class static_thread_pool::injection_queue
+	{
+	public:
+
+		injection_queue()
+			: m_tail(nullptr)
+		{
+		}
+
+		/// Push the operations linked through m_next from \a newest down to
+		/// \a oldest.
+		void push(schedule_operation* newest, schedule_operation* oldest) noexcept
+		{
+			auto* tail = m_tail.load(std::memory_order_relaxed);
+			do
+			{
+				oldest->m_next = tail;
+			} while (!m_tail.compare_exchange_weak(
+				tail,
+				newest,
+				std::memory_order_seq_cst,
+				std::memory_order_relaxed));
+		}
+
+		/// Take every queued operation.
+		///
+		/// \return
+		/// The oldest operation, linked to the next oldest through m_next,
+		/// or nullptr if the queue was empty.
+		schedule_operation* try_pop_all() noexcept
+		{
+			// Use seq-cst memory order so that when we check for an item in the
+			// queue after signalling an intent to sleep that either we will see
+			// their enqueue or they will see our signal to sleep and wake us up.
+			if (m_tail.load(std::memory_order_seq_cst) == nullptr)
+			{
+				return nullptr;
+			}
+
+			// Acquire the entire set of queued operations in a single operation.
+			auto* tail = m_tail.exchange(nullptr, std::memory_order_acquire);
+
+			// Reverse the list 
+			schedule_operation* head = nullptr;
+			while (tail != nullptr)
+			{
+				auto* next = std::exchange(tail->m_next, head);
+				head = std::exchange(tail, next);
+			}
+
+			return head;
+		}
+
+		bool has_any_queued_work() const noexcept
+		{
+			return m_tail.load(std::memory_order_seq_cst) != nullptr;
+		}
+
+		bool approx_has_any_queued_work() const noexcept
+		{
+			return m_tail.load(std::memory_order_relaxed) != nullptr;
+		}
+
+	private:
+
+		//alignas(std::hardware_destructive_interference_size)
+		std::atomic<schedule_operation*> m_tail;
+
+	};
+
+	class static_thread_pool::node_state
+	{
+	public:
+
+		/// NUMA node number, or local::unknown_node.
+		std::uint32_t m_node = local::unknown_node;
+
+		/// Threads on the node.
+		std::vector<std::uint32_t> m_threadIndices;
+
+		injection_queue m_queue;
+
+		/// Take the oldest operation queued for the node.
+		///
+		/// Only the node's threads call this. The operations taken from
+		/// m_queue along with it wait in m_pending for them, rather than in
+		/// the caller's local queue where threads of any node could steal
+		/// them.
+		///
+		/// \param morePending
+		/// Set to whether other operations are left in m_pending.
+		schedule_operation* try_pop(bool& morePending) noexcept
+		{
+			if (!has_any_queued_work())
+			{
+				return nullptr;
+			}
+
+			std::lock_guard lock{ m_mutex };
+			auto* operation = m_pending.load(std::memory_order_relaxed);
+			if (operation == nullptr)
+			{
+				operation = m_queue.try_pop_all();
+				if (operation == nullptr)
+				{
+					return nullptr;
+				}
+			}
+
+			// seq_cst, as with the queue, so that a thread of the node that
+			// is about to sleep either sees the rest or is woken up for it.
+			m_pending.store(operation->m_next, std::memory_order_seq_cst);
+			morePending = operation->m_next != nullptr;
+			return operation;
+		}
+
+		bool has_any_queued_work() const noexcept
+		{
+			return m_pending.load(std::memory_order_seq_cst) != nullptr ||
+				m_queue.has_any_queued_work();
+		}
+
+		bool approx_has_any_queued_work() const noexcept
+		{
+			return m_pending.load(std::memory_order_relaxed) != nullptr ||
+				m_queue.approx_has_any_queued_work();
+		}
+
+	private:
+
+		spin_mutex m_mutex;
+
+		// Taken from m_queue, oldest first, linked through m_next.
+		std::atomic<schedule_operation*> m_pending{ nullptr };
 
 	};
 
@@ -326,25 +721,143 @@ namespace cppcoro
 		m_threadPool->schedule_impl(this);
 	}
 
+	static_thread_pool::bulk_schedule_operation::bulk_schedule_operation(
+		static_thread_pool* tp, std::uint32_t count)
+		: m_threadPool(tp)
+		, m_operations(count, schedule_operation{ tp })
+		, m_claimedCount(0)
+		, m_suspendedCount(0)
+	{
+	}
+
+	void static_thread_pool::bulk_schedule_operation::awaiter::await_suspend(
+		cppcoro::coroutine_handle<> awaitingCoroutine) noexcept
+	{
+		auto& bulk = m_operation;
+		const auto index = bulk.m_claimedCount.fetch_add(1, std::memory_order_relaxed);
+		assert(index < bulk.size());
+		bulk.m_operations[index].m_awaitingCoroutine = awaitingCoroutine;
+
+		// The last coroutine to finish suspending queues them all. Use
+		// acq_rel so that it sees the writes of the others.
+		if (bulk.m_suspendedCount.fetch_add(1, std::memory_order_acq_rel) + 1 == bulk.size())
+		{
+			bulk.m_threadPool->schedule_bulk_impl(bulk.m_operations.data(), bulk.size());
+		}
+	}
+
 	static_thread_pool::static_thread_pool()
 		: static_thread_pool(std::thread::hardware_concurrency())
 	{
 	}
 
 	static_thread_pool::static_thread_pool(std::uint32_t threadCount)
+		: static_thread_pool(threadCount, {})
+	{
+	}
+
+	static_thread_pool::static_thread_pool(
+		std::uint32_t threadCount, std::vector<std::uint32_t> cpus)
 		: m_threadCount(threadCount > 0 ? threadCount : 1)
 		, m_threadStates(std::make_unique<thread_state[]>(m_threadCount))
+		, m_nodeCount(0)
 		, m_stopRequested(false)
-		, m_globalQueueHead(nullptr)
-		, m_globalQueueTail(nullptr)
+		, m_idlePolicy(idle_policy::spin)
+		, m_spinDuration(default_spin_duration.count())
+		, m_globalQueue(std::make_unique<injection_queue>())
 		, m_sleepingThreadCount(0)
 	{
-		m_threads.reserve(threadCount);
+		// Group the threads by the node of their CPU, in order of first
+		// appearance.
+		std::vector<std::uint32_t> threadNodes(m_threadCount, local::unknown_node);
+		if (!cpus.empty())
+		{
+			const auto cpuNodes = local::read_cpu_nodes();
+			for (std::uint32_t i = 0; i < m_threadCount; ++i)
+			{
+				const auto cpu = cpus[i % cpus.size()];
+				if (cpu < cpuNodes.size())
+				{
+					threadNodes[i] = cpuNodes[cpu];
+				}
+			}
+		}
+
+		std::vector<std::uint32_t> nodes;
+		std::vector<std::uint32_t> threadNodeIndices(m_threadCount);
+		for (std::uint32_t i = 0; i < m_threadCount; ++i)
+		{
+			auto it = std::find(nodes.begin(), nodes.end(), threadNodes[i]);
+			if (it == nodes.end())
+			{
+				it = nodes.insert(nodes.end(), threadNodes[i]);
+			}
+			threadNodeIndices[i] = static_cast<std::uint32_t>(it - nodes.begin());
+		}
+
+		m_nodeCount = static_cast<std::uint32_t>(nodes.size());
+		m_nodes = std::make_unique<node_state[]>(m_nodeCount);
+		for (std::uint32_t i = 0; i < m_threadCount; ++i)
+		{
+			auto& node = m_nodes[threadNodeIndices[i]];
+			node.m_node = threadNodes[i] == local::unknown_node && m_nodeCount == 1
+				? 0
+				: threadNodes[i];
+			node.m_threadIndices.push_back(i);
+		}
+
+		// Steal from the threads of the same node first, starting after
+		// this thread, then from the threads of the other nodes.
+		for (std::uint32_t i = 0; i < m_threadCount; ++i)
+		{
+			const auto nodeIndex = threadNodeIndices[i];
+			const auto& sameNode = m_nodes[nodeIndex].m_threadIndices;
+			const auto position = static_cast<std::size_t>(
+				std::find(sameNode.begin(), sameNode.end(), i) - sameNode.begin());
+
+			std::vector<std::uint32_t> victims;
+			victims.reserve(m_threadCount - 1);
+			for (std::size_t j = 1; j < sameNode.size(); ++j)
+			{
+				victims.push_back(sameNode[(position + j) % sameNode.size()]);
+			}
+			for (std::uint32_t other = 0; other < m_threadCount; ++other)
+			{
+				if (threadNodeIndices[other] != nodeIndex)
+				{
+					victims.push_back(other);
+				}
+			}
+
+			m_threadStates[i].set_placement(i, nodeIndex, std::move(victims), sameNode.size() - 1);
+		}
+
+		m_threads.reserve(m_threadCount);
 		try
 		{
 			for (std::uint32_t i = 0; i < m_threadCount; ++i)
 			{
 				m_threads.emplace_back([this, i] { this->run_worker_thread(i); });
+
+				if (!cpus.empty())
+				{
+#if CPPCORO_OS_LINUX
+					cpu_set_t cpuSet;
+					CPU_ZERO(&cpuSet);
+					CPU_SET(cpus[i % cpus.size()], &cpuSet);
+					const int error = ::pthread_setaffinity_np(
+						m_threads.back().native_handle(), sizeof(cpuSet), &cpuSet);
+					if (error != 0)
+					{
+						throw std::system_error
+						{
+							error,
+							std::system_category(),
+							"static_thread_pool: pthread_setaffinity_np"
+						};
+					}
+#endif
+				}
 			}
 		}
 		catch (...)
@@ -367,6 +880,50 @@ namespace cppcoro
 		shutdown();
 	}
 
+	void static_thread_pool::set_idle_policy(
+		idle_policy policy, std::chrono::nanoseconds spinDuration) noexcept
+	{
+		m_spinDuration.store(spinDuration.count(), std::memory_order_relaxed);
+		m_idlePolicy.store(policy, std::memory_order_relaxed);
+	}
+
+	static_thread_pool::idle_stats static_thread_pool::stats() const noexcept
+	{
+		idle_stats stats;
+		for (std::uint32_t i = 0; i < m_threadCount; ++i)
+		{
+			m_threadStates[i].add_stats(stats);
+		}
+		return stats;
+	}
+
+	std::vector<std::uint32_t> static_thread_pool::numa_node_cpus(std::uint32_t node)
+	{
+		return local::read_node_cpus(node);
+	}
+
+	std::uint32_t static_thread_pool::current_node() const noexcept
+	{
+		if (s_currentThreadPool != this)
+		{
+			return local::unknown_node;
+		}
+		return m_nodes[s_currentState->node_index()].m_node;
+	}
+
+	static_thread_pool::schedule_operation
+	static_thread_pool::schedule_on_node(std::uint32_t node) noexcept
+	{
+		for (std::uint32_t i = 0; i < m_nodeCount; ++i)
+		{
+			if (m_nodes[i].m_node == node)
+			{
+				return schedule_operation{ this, i };
+			}
+		}
+		return schedule_operation{ this };
+	}
+
 	void static_thread_pool::run_worker_thread(std::uint32_t threadIndex) noexcept
 	{
 		auto& localState = m_threadStates[threadIndex];
@@ -375,15 +932,20 @@ namespace cppcoro
 
 		auto tryGetRemote = [&]()
 		{
-			// Try to get some new work first from the global queue
-			// then if that queue is empty then try to steal from
-			// the local queues of other worker threads.
+			// Try to get some new work first from the queue of work for
+			// this thread's node and the global queue, then if those are
+			// empty then try to steal from the local queues of other
+			// worker threads.
 			// We try to get new work from the global queue first
 			// before stealing as stealing from other threads has
 			// the side-effect of those threads running out of work
 			// sooner and then having to steal work which increases
 			// contention.
-			auto* op = try_global_dequeue();
+			auto* op = try_node_dequeue(localState.node_index());
+			if (op == nullptr)
+			{
+				op = try_dequeue(*m_globalQueue);
+			}
 			if (op == nullptr)
 			{
 				op = try_steal_from_other_thread(threadIndex);
@@ -413,15 +975,25 @@ namespace cppcoro
 
 			// No more operations in the local queue or remote queue.
 			//
-			// We spin for a little while waiting for new items
-			// to be enqueued. This avoids the expensive operation
-			// of putting the thread to sleep and waking it up again
-			// in the case that an external thread is queueing new work
+			// Unless the idle policy says otherwise, we spin for a little
+			// while waiting for new items to be enqueued. This avoids the
+			// expensive operation of putting the thread to sleep and waking
+			// it up again in the case that an external thread is queueing
+			// new work
+
+			const auto idleStart = local::idle_clock::now();
+			const auto spinDuration = localState.spin_duration(
+				m_idlePolicy.load(std::memory_order_relaxed),
+				std::chrono::nanoseconds{ m_spinDuration.load(std::memory_order_relaxed) });
+			std::chrono::nanoseconds spinTime{ 0 };
+			bool foundWhileSpinning = false;
 
 			cppcoro::spin_wait spinWait;
 			while (true)
 			{
-				for (int i = 0; i < 30; ++i)
+				const auto spinStart = local::idle_clock::now();
+				auto spinEnd = spinStart;
+				while (spinEnd - spinStart < spinDuration)
 				{
 					if (is_shutdown_requested())
 					{
@@ -439,10 +1011,15 @@ namespace cppcoro
 							// return to normal processing since this work
 							// might have queued some more work to the local
 							// queue which we should process first.
+							spinTime += local::idle_clock::now() - spinStart;
+							foundWhileSpinning = true;
 							goto normal_processing;
 						}
 					}
+
+					spinEnd = local::idle_clock::now();
 				}
+				spinTime += spinEnd - spinStart;
 
 				// We didn't find any work after spinning for a while, let's
 				// put ourselves to sleep and wait to be woken up.
@@ -468,9 +1045,9 @@ namespace cppcoro
 						// up instead which could have resulted in increased parallelism.
 						//
 						// However, it's possible that some other thread may have already
-						// tried to wake us up, in which case the auto_reset_event used to
-						// wake up this thread may already be in the 'set' state. Leaving
-						// it in this state won't really hurt. It'll just mean we might get
+						// tried to wake us up, in which case the thread_parker used to
+						// wake up this thread may already be unparked. Leaving it in
+						// this state won't really hurt. It'll just mean we might get
 						// a spurious wake-up next time we try to go to sleep.
 						try_clear_intent_to_sleep(threadIndex);
 
@@ -488,6 +1065,8 @@ namespace cppcoro
 
 		normal_processing:
 			assert(op != nullptr);
+			localState.on_idle_end(
+				local::idle_clock::now() - idleStart, spinTime, foundWhileSpinning);
 			op->m_awaitingCoroutine.resume();
 		}
 	}
@@ -516,6 +1095,16 @@ namespace cppcoro
 
 	void static_thread_pool::schedule_impl(schedule_operation* operation) noexcept
 	{
+		const auto nodeIndex = operation->m_nodeIndex;
+		if (nodeIndex != any_node)
+		{
+			// Even from a thread of the node, as any thread may steal from
+			// its local queue.
+			m_nodes[nodeIndex].m_queue.push(operation, operation);
+			wake_threads(1, nodeIndex);
+			return;
+		}
+
 		if (s_currentThreadPool != this ||
 			!s_currentState->try_local_enqueue(operation))
 		{
@@ -527,25 +1116,55 @@ namespace cppcoro
 
 	void static_thread_pool::remote_enqueue(schedule_operation* operation) noexcept
 	{
-		auto* tail = m_globalQueueTail.load(std::memory_order_relaxed);
-		do
+		remote_enqueue(operation, operation);
+	}
+
+	void static_thread_pool::remote_enqueue(
+		schedule_operation* newest, schedule_operation* oldest) noexcept
+	{
+		m_globalQueue->push(newest, oldest);
+	}
+
+	void static_thread_pool::schedule_bulk_impl(
+		schedule_operation* operations, std::uint32_t count) noexcept
+	{
+		// Link whatever doesn't fit in this thread's local queue, newest
+		// first, so it can be pushed to the global queue with one CAS.
+		schedule_operation* newest = nullptr;
+		schedule_operation* oldest = nullptr;
+		const bool isWorkerThread = s_currentThreadPool == this;
+		for (std::uint32_t i = 0; i < count; ++i)
 		{
-			operation->m_next = tail;
-		} while (!m_globalQueueTail.compare_exchange_weak(
-			tail,
-			operation,
-			std::memory_order_seq_cst,
-			std::memory_order_relaxed));
+			auto* operation = &operations[i];
+			if (isWorkerThread && s_currentState->try_local_enqueue(operation))
+			{
+				continue;
+			}
+
+			operation->m_next = newest;
+			newest = operation;
+			if (oldest == nullptr)
+			{
+				oldest = operation;
+			}
+		}
+
+		if (newest != nullptr)
+		{
+			remote_enqueue(newest, oldest);
+		}
+
+		wake_threads(count);
 	}
 
 	bool static_thread_pool::has_any_queued_work_for(std::uint32_t threadIndex) noexcept
 	{
-		if (m_globalQueueTail.load(std::memory_order_seq_cst) != nullptr)
+		if (m_globalQueue->has_any_queued_work())
 		{
 			return true;
 		}
 
-		if (m_globalQueueHead.load(std::memory_order_seq_cst) != nullptr)
+		if (m_nodes[m_threadStates[threadIndex].node_index()].has_any_queued_work())
 		{
 			return true;
 		}
@@ -569,12 +1188,12 @@ namespace cppcoro
 		// don't bounce cache-lines around between threads/cores unnecessarily when
 		// multiple threads are all spinning waiting for work.
 
-		if (m_globalQueueTail.load(std::memory_order_relaxed) != nullptr)
+		if (m_globalQueue->approx_has_any_queued_work())
 		{
 			return true;
 		}
 
-		if (m_globalQueueHead.load(std::memory_order_relaxed) != nullptr)
+		if (m_nodes[m_threadStates[threadIndex].node_index()].approx_has_any_queued_work())
 		{
 			return true;
 		}
@@ -642,53 +1261,121 @@ namespace cppcoro
 	}
 
 	static_thread_pool::schedule_operation*
-	static_thread_pool::try_global_dequeue() noexcept
+	static_thread_pool::try_dequeue(injection_queue& queue) noexcept
 	{
-		std::scoped_lock lock{ m_globalQueueMutex };
-
-		auto* head = m_globalQueueHead.load(std::memory_order_relaxed);
+		auto* head = queue.try_pop_all();
 		if (head == nullptr)
 		{
-			// Use seq-cst memory order so that when we check for an item in the
-			// global queue after signalling an intent to sleep that either we
-			// will see their enqueue or they will see our signal to sleep and
-			// wake us up.
-			if (m_globalQueueTail.load(std::memory_order_seq_cst) == nullptr)
-			{
-				return nullptr;
-			}
-
-			// Acquire the entire set of queued operations in a single operation.
-			auto* tail = m_globalQueueTail.exchange(nullptr, std::memory_order_acquire);
-			if (tail == nullptr)
-			{
-				return nullptr;
-			}
+			return nullptr;
+		}
 
-			// Reverse the list 
+		// Run the oldest and move the others to the local queue, from where
+		// other threads steal them if this one can't keep up.
+		auto* operation = head->m_next;
+		if (operation != nullptr)
+		{
+			auto& localState = *s_currentState;
 			do
 			{
-				auto* next = std::exchange(tail->m_next, head);
-				head = std::exchange(tail, next);
-			} while (tail != nullptr);
-		}
+				auto* next = operation->m_next;
+				if (!localState.try_local_enqueue(operation))
+				{
+					// Local queue full, put the rest back with a single push,
+					// relinked newest to oldest as the queue holds them so
+					// that they keep their order.
+					auto* oldest = operation;
+					schedule_operation* newest = nullptr;
+					while (operation != nullptr)
+					{
+						auto* newer = std::exchange(operation->m_next, newest);
+						newest = std::exchange(operation, newer);
+					}
+					queue.push(newest, oldest);
+					break;
+				}
+				operation = next;
+			} while (operation != nullptr);
 
-		m_globalQueueHead = head->m_next;
+			wake_one_thread();
+		}
 
 		return head;
 	}
 
+	static_thread_pool::schedule_operation*
+	static_thread_pool::try_node_dequeue(std::uint32_t nodeIndex) noexcept
+	{
+		bool morePending = false;
+		auto* operation = m_nodes[nodeIndex].try_pop(morePending);
+		if (morePending)
+		{
+			// Let a sleeping thread of the node help with the rest. Threads
+			// of other nodes can't, so don't wake one up instead. Missing a
+			// thread that is just going to sleep is fine, this one carries
+			// on with the rest.
+			for (auto i : m_nodes[nodeIndex].m_threadIndices)
+			{
+				if (m_threadStates[i].approx_is_sleeping())
+				{
+					wake_threads(1, nodeIndex);
+					break;
+				}
+			}
+		}
+		return operation;
+	}
+
 	static_thread_pool::schedule_operation*
 	static_thread_pool::try_steal_from_other_thread(std::uint32_t thisThreadIndex) noexcept
 	{
+		auto& thisThreadState = m_threadStates[thisThreadIndex];
+
+		// Threads of the same node come first. Start each group at a random
+		// victim so that idle threads don't all contend on the same one.
+		const auto& victims = thisThreadState.victims();
+		const std::size_t sameNodeCount = thisThreadState.same_node_victim_count();
+		const std::size_t otherNodeCount = victims.size() - sameNodeCount;
+		const std::uint32_t random = thisThreadState.next_random();
+		const std::size_t sameNodeStart = sameNodeCount > 0 ? random % sameNodeCount : 0;
+		const std::size_t otherNodeStart = otherNodeCount > 0 ? random % otherNodeCount : 0;
+		auto victimAt = [&](std::size_t i)
+		{
+			return i < sameNodeCount
+				? victims[(sameNodeStart + i) % sameNodeCount]
+				: victims[sameNodeCount + (otherNodeStart + i - sameNodeCount) % otherNodeCount];
+		};
+
+		// Take half of the victim's queue. The first operation is run
+		// straight away, the rest go to this thread's local queue where
+		// other idle threads can in turn steal them.
+		schedule_operation* stolen[local::max_steal_batch_size];
+		auto tryStealFrom = [&](std::uint32_t otherThreadIndex, bool* lockUnavailable)
+			-> schedule_operation*
+		{
+			const auto count = m_threadStates[otherThreadIndex].try_steal(
+				stolen, std::size(stolen), lockUnavailable);
+			for (std::size_t i = 1; i < count; ++i)
+			{
+				auto* operation = stolen[i];
+				if (!thisThreadState.try_local_enqueue(operation))
+				{
+					remote_enqueue(operation);
+				}
+			}
+			if (count > 1)
+			{
+				// Let a sleeping thread help with the rest.
+				wake_one_thread();
+			}
+			return count > 0 ? stolen[0] : nullptr;
+		};
+
 		// Try first with non-blocking steal attempts.
 
 		bool anyLocksUnavailable = false;
-		for (std::uint32_t otherThreadIndex = 0; otherThreadIndex < m_threadCount; ++otherThreadIndex)
+		for (std::size_t i = 0; i < victims.size(); ++i)
 		{
-			if (otherThreadIndex == thisThreadIndex) continue;
-			auto& otherThreadState = m_threadStates[otherThreadIndex];
-			auto* op = otherThreadState.try_steal(&anyLocksUnavailable);
+			auto* op = tryStealFrom(victimAt(i), &anyLocksUnavailable);
 			if (op != nullptr)
 			{
 				return op;
@@ -699,11 +1386,9 @@ namespace cppcoro
 		{
 			// We didn't check all of the other threads for work to steal yet.
 			// Try again, this time waiting to acquire the locks.
-			for (std::uint32_t otherThreadIndex = 0; otherThreadIndex < m_threadCount; ++otherThreadIndex)
+			for (std::size_t i = 0; i < victims.size(); ++i)
 			{
-				if (otherThreadIndex == thisThreadIndex) continue;
-				auto& otherThreadState = m_threadStates[otherThreadIndex];
-				auto* op = otherThreadState.try_steal();
+				auto* op = tryStealFrom(victimAt(i), nullptr);
 				if (op != nullptr)
 				{
 					return op;
@@ -716,35 +1401,54 @@ namespace cppcoro
 
 	void static_thread_pool::wake_one_thread() noexcept
 	{
-		// First try to claim responsibility for waking up one thread.
+		wake_threads(1);
+	}
+
+	void static_thread_pool::wake_threads(std::uint32_t count, std::uint32_t nodeIndex) noexcept
+	{
+		// First try to claim responsibility for waking up that many threads,
+		// or as many as are asleep.
 		// This first read must be seq_cst to ensure that either we have
 		// visibility of another thread going to sleep or they have
 		// visibility of our prior enqueue of an item.
 		std::uint32_t oldSleepingCount = m_sleepingThreadCount.load(std::memory_order_seq_cst);
+		std::uint32_t wakeCount;
 		do
 		{
-			if (oldSleepingCount == 0)
+			if (oldSleepingCount == 0 || count == 0)
 			{
 				// No sleeping threads.
 				// Someone must have woken us up.
 				return;
 			}
+			wakeCount = std::min(count, oldSleepingCount);
 		} while (!m_sleepingThreadCount.compare_exchange_weak(
 			oldSleepingCount,
-			oldSleepingCount - 1,
+			oldSleepingCount - wakeCount,
 			std::memory_order_acquire,
 			std::memory_order_relaxed));
 
-		// Now that we have claimed responsibility for waking a thread up
-		// we need to find a sleeping thread and wake it up. We should be
-		// guaranteed of finding a thread to wake-up here, but not necessarily
-		// in a single pass due to threads potentially waking themselves up
-		// in try_clear_intent_to_sleep().
+		// Now that we have claimed responsibility for waking the threads up
+		// we need to find sleeping threads and wake them up. We should be
+		// guaranteed of finding enough threads to wake-up here, but not
+		// necessarily in a single pass due to threads potentially waking
+		// themselves up in try_clear_intent_to_sleep().
 		while (true)
 		{
+			if (nodeIndex != any_node)
+			{
+				for (auto i : m_nodes[nodeIndex].m_threadIndices)
+				{
+					if (m_threadStates[i].try_wake_up() && --wakeCount == 0)
+					{
+						return;
+					}
+				}
+			}
+
 			for (std::uint32_t i = 0; i < m_threadCount; ++i)
 			{
-				if (m_threadStates[i].try_wake_up())
+				if (m_threadStates[i].try_wake_up() && --wakeCount == 0)
 				{
 					return;
 				}
@@ -0,0 +1,102 @@
+///////////////////////////////////////////////////////////////////////////////
+// Copyright (c) Lewis Baker
+// Licenced under MIT license. See LICENSE.txt for details.
+///////////////////////////////////////////////////////////////////////////////
+
+#include "thread_parker.hpp"
+
+#if CPPCORO_OS_LINUX
+# include <linux/futex.h>
+# include <sys/syscall.h>
+# include <unistd.h>
+#else
+# include <chrono>
+# include <thread>
+#endif
+
+namespace cppcoro
+{
+#if CPPCORO_OS_LINUX
+
+	thread_parker::thread_parker() noexcept
+		: m_state(empty)
+	{
+	}
+
+	bool thread_parker::park() noexcept
+	{
+		// Consume a pending unpark() without blocking.
+		if (m_state.exchange(empty, std::memory_order_acquire) == notified)
+		{
+			return false;
+		}
+
+		std::uint32_t expected = empty;
+		if (!m_state.compare_exchange_strong(
+			expected, parked, std::memory_order_acquire, std::memory_order_acquire))
+		{
+			// unpark() was called in between.
+			m_state.store(empty, std::memory_order_relaxed);
+			return false;
+		}
+
+		while (true)
+		{
+			// Returns straight away if m_state is no longer 'parked'. Errors
+			// (EINTR, EAGAIN) are handled by re-checking the state.
+			(void)::syscall(
+				SYS_futex, &m_state, FUTEX_WAIT_PRIVATE, parked, nullptr, nullptr, 0);
+
+			expected = notified;
+			if (m_state.compare_exchange_strong(
+				expected, empty, std::memory_order_acquire, std::memory_order_relaxed))
+			{
+				return true;
+			}
+
+			// Spurious wake-up.
+		}
+	}
+
+	void thread_parker::unpark() noexcept
+	{
+		if (m_state.exchange(notified, std::memory_order_release) == parked)
+		{
+			(void)::syscall(SYS_futex, &m_state, FUTEX_WAKE_PRIVATE, 1, nullptr, nullptr, 0);
+		}
+	}
+
+#else
+
+	thread_parker::thread_parker() noexcept
+	{
+	}
+
+	bool thread_parker::park() noexcept
+	{
+		try
+		{
+			m_event.wait();
+		}
+		catch (...)
+		{
+			using namespace std::chrono_literals;
+			std::this_thread::sleep_for(1ms);
+		}
+		return true;
+	}
+
+	void thread_parker::unpark() noexcept
+	{
+		try
+		{
+			m_event.set();
+		}
+		catch (...)
+		{
+			// TODO: What do we do here?
+		}
+	}
+
+#endif
+}
@@ -0,0 +1,59 @@
+///////////////////////////////////////////////////////////////////////////////
+// Copyright (c) Lewis Baker
+// Licenced under MIT license. See LICENSE.txt for details.
+///////////////////////////////////////////////////////////////////////////////
+#ifndef CPPCORO_THREAD_PARKER_HPP_INCLUDED
+#define CPPCORO_THREAD_PARKER_HPP_INCLUDED
+
+#include <cppcoro/config.hpp>
+
+#if CPPCORO_OS_LINUX
+# include <atomic>
+# include <cstdint>
+#else
+# include "auto_reset_event.hpp"
+#endif
+
+namespace cppcoro
+{
+	/// Lets one thread block until another wakes it up.
+	///
+	/// On Linux this is a futex on a single word: unpark() only makes a
+	/// syscall if the thread is actually blocked in park(), and neither side
+	/// takes a lock. Elsewhere it falls back to an auto_reset_event.
+	class thread_parker
+	{
+	public:
+
+		thread_parker() noexcept;
+
+		/// Block the calling thread until unpark() is called, returning
+		/// straight away if it was called since the last park().
+		///
+		/// Only one thread may park at a time.
+		///
+		/// \return
+		/// Whether the thread blocked, false if it consumed an earlier
+		/// unpark(). The fallback can't tell and always returns true.
+		bool park() noexcept;
+
+		/// Wake up the parked thread, or make its next park() return
+		/// straight away.
+		void unpark() noexcept;
+
+	private:
+
+#if CPPCORO_OS_LINUX
+		static constexpr std::uint32_t empty = 0;
+		static constexpr std::uint32_t notified = 1;
+		static constexpr std::uint32_t parked = 2;
+
+		std::atomic<std::uint32_t> m_state;
+#else
+		auto_reset_event m_event;
+#endif
+
+	};
+}
+
+#endif
@@ -93,3 +93,128 @@ cppcoro::file_write_operation_cancellable cppcoro::writable_file::write(
 		std::move(ct)
 	};
 }
+
+#if CPPCORO_OS_LINUX
+
+cppcoro::file_write_operation cppcoro::writable_file::write(
+	std::uint64_t offset,
+	const registered_buffer& buffer,
+	std::size_t byteCount) noexcept
+{
+	return file_write_operation{
+		*m_ioService,
+		m_fileHandle.handle(),
+		offset,
+		buffer.data(),
+		byteCount,
+		buffer.buffer_index()
+	};
+}
+
+cppcoro::file_write_operation_cancellable cppcoro::writable_file::write(
+	std::uint64_t offset,
+	const registered_buffer& buffer,
+	std::size_t byteCount,
+	cancellation_token ct) noexcept
+{
+	return file_write_operation_cancellable{
+		*m_ioService,
+		m_fileHandle.handle(),
+		offset,
+		buffer.data(),
+		byteCount,
+		buffer.buffer_index(),
+		std::move(ct)
+	};
+}
+
+cppcoro::file_write_operation cppcoro::writable_file::write(
+	std::uint64_t offset,
+	std::span<const iovec> buffers) noexcept
+{
+	return file_write_operation{
+		*m_ioService,
+		m_fileHandle.handle(),
+		offset,
+		buffers
+	};
+}
+
+cppcoro::file_write_operation_cancellable cppcoro::writable_file::write(
+	std::uint64_t offset,
+	std::span<const iovec> buffers,
+	cancellation_token ct) noexcept
+{
+	return file_write_operation_cancellable{
+		*m_ioService,
+		m_fileHandle.handle(),
+		offset,
+		buffers,
+		std::move(ct)
+	};
+}
+
+cppcoro::file_sync_operation cppcoro::writable_file::flush(
+	file_durability durability) noexcept
+{
+	return file_sync_operation{
+		*m_ioService,
+		m_fileHandle.handle(),
+		file_sync_operation::kind::flush,
+		durability,
+		0,
+		0
+	};
+}
+
+cppcoro::file_sync_operation cppcoro::writable_file::sync_range(
+	std::uint64_t offset,
+	std::uint64_t byteCount) noexcept
+{
+	return file_sync_operation{
+		*m_ioService,
+		m_fileHandle.handle(),
+		file_sync_operation::kind::sync_range,
+		file_durability::data,
+		offset,
+		byteCount
+	};
+}
+
+cppcoro::file_sync_operation cppcoro::writable_file::allocate(
+	std::uint64_t offset,
+	std::uint64_t byteCount) noexcept
+{
+	return file_sync_operation{
+		*m_ioService,
+		m_fileHandle.handle(),
+		file_sync_operation::kind::allocate,
+		file_durability::data,
+		offset,
+		byteCount
+	};
+}
+
+cppcoro::file_chain_operation cppcoro::writable_file::write_chain(
+	std::span<const file_chain_step> steps) noexcept
+{
+	return file_chain_operation{
+		*m_ioService,
+		m_fileHandle.handle(),
+		steps
+	};
+}
+
+cppcoro::file_chain_operation_cancellable cppcoro::writable_file::write_chain(
+	std::span<const file_chain_step> steps,
+	cancellation_token ct) noexcept
+{
+	return file_chain_operation_cancellable{
+		*m_ioService,
+		m_fileHandle.handle(),
+		steps,
+		std::move(ct)
+	};
+}
+
+#endif
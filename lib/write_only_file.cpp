@@ -34,6 +34,26 @@ cppcoro::write_only_file cppcoro::write_only_file::open(
 	return std::move(file);
 }
 
+#if CPPCORO_OS_LINUX
+cppcoro::task<cppcoro::write_only_file> cppcoro::write_only_file::open_async(
+	io_service& ioService,
+	filesystem::path path,
+	file_open_mode openMode,
+	file_share_mode shareMode,
+	file_buffering_mode bufferingMode)
+{
+	write_only_file file(co_await file::open_async(
+		GENERIC_WRITE,
+		ioService,
+		path,
+		openMode,
+		shareMode,
+		bufferingMode));
+	file.m_ioService = &ioService;
+	co_return std::move(file);
+}
+#endif
+
 cppcoro::write_only_file::write_only_file(
 	detail::safe_handle&& fileHandle) noexcept
 	: file(std::move(fileHandle))
@@ -12,12 +12,22 @@
 #include <cppcoro/when_all.hpp>
 #include <cppcoro/cancellation_source.hpp>
 #include <cppcoro/on_scope_exit.hpp>
+#include <cppcoro/aligned_buffer.hpp>
+#include <cppcoro/mapped_file_advise_operation.hpp>
 
+#include <algorithm>
+#include <cstring>
+#include <optional>
 #include <random>
 #include <thread>
 #include <cassert>
 #include <string>
 
+#if CPPCORO_OS_LINUX
+# include <sys/mman.h>
+# include <unistd.h>
+#endif
+
 #include "io_service_fixture.hpp"
 
 #include <ostream>
@@ -183,6 +193,405 @@ TEST_CASE_FIXTURE(tmp_dir_with_io_service_fixture, "read write file")
 	cppcoro::sync_wait(run());
 }
 
+#if CPPCORO_OS_LINUX
+TEST_CASE_FIXTURE(tmp_dir_with_io_service_fixture, "vectored read write file")
+{
+	auto run = [&]() -> cppcoro::task<>
+	{
+		cppcoro::io_work_scope ioScope{ io_service() };
+		auto f = cppcoro::read_write_file::open(io_service(), temp_dir() / "foo.txt");
+
+		char header[16];
+		char body[84];
+		std::memset(header, 0xAB, sizeof(header));
+		std::memset(body, 0xCD, sizeof(body));
+		const iovec writeVecs[] = {
+			{ header, sizeof(header) },
+			{ body, sizeof(body) },
+		};
+		CHECK(co_await f.write(0, writeVecs) == 100);
+
+		// Split the record differently on the way back.
+		char first[40];
+		char second[60];
+		const iovec readVecs[] = {
+			{ first, sizeof(first) },
+			{ second, sizeof(second) },
+		};
+		cppcoro::cancellation_source canceller;
+		CHECK(co_await f.read(0, readVecs, canceller.token()) == 100);
+		CHECK(std::memcmp(first, header, sizeof(header)) == 0);
+		CHECK(std::memcmp(first + sizeof(header), body, sizeof(first) - sizeof(header)) == 0);
+		CHECK(std::memcmp(second, body + sizeof(first) - sizeof(header), sizeof(second)) == 0);
+	};
+
+	cppcoro::sync_wait(run());
+}
+
+TEST_CASE_FIXTURE(tmp_dir_with_io_service_fixture, "write chain file")
+{
+	auto run = [&]() -> cppcoro::task<>
+	{
+		cppcoro::io_work_scope ioScope{ io_service() };
+		auto f = cppcoro::read_write_file::open(io_service(), temp_dir() / "foo.log");
+
+		char record[100];
+		std::memset(record, 0xAB, sizeof(record));
+		const char marker[] = "commit";
+		const cppcoro::file_chain_step steps[] = {
+			cppcoro::file_chain_step::write(0, record, sizeof(record)),
+			cppcoro::file_chain_step::flush(),
+			cppcoro::file_chain_step::write(sizeof(record), marker, sizeof(marker)),
+		};
+		CHECK(co_await f.write_chain(steps) == sizeof(marker));
+
+		char readBack[sizeof(record) + sizeof(marker)];
+		CHECK(co_await f.read(0, readBack, sizeof(readBack)) == sizeof(readBack));
+		CHECK(std::memcmp(readBack, record, sizeof(record)) == 0);
+		CHECK(std::memcmp(readBack + sizeof(record), marker, sizeof(marker)) == 0);
+
+		// A failed write cancels the rest of the chain.
+		const cppcoro::file_chain_step failing[] = {
+			cppcoro::file_chain_step::write(200, nullptr, 10),
+			cppcoro::file_chain_step::write(300, marker, sizeof(marker)),
+		};
+		int error = 0;
+		try
+		{
+			(void)co_await f.write_chain(failing);
+		}
+		catch (const std::system_error& e)
+		{
+			error = e.code().value();
+		}
+		CHECK(error == EFAULT);
+		CHECK(f.size() < 300);
+
+		// Unless the failing step continues on failure, which is still reported.
+		const cppcoro::file_chain_step continuing[] = {
+			cppcoro::file_chain_step::write(200, nullptr, 10).continue_on_failure(),
+			cppcoro::file_chain_step::write(300, marker, sizeof(marker)),
+		};
+		cppcoro::cancellation_source canceller;
+		error = 0;
+		try
+		{
+			(void)co_await f.write_chain(continuing, canceller.token());
+		}
+		catch (const std::system_error& e)
+		{
+			error = e.code().value();
+		}
+		CHECK(error == EFAULT);
+		CHECK(f.size() == 300 + sizeof(marker));
+	};
+
+	cppcoro::sync_wait(run());
+}
+
+TEST_CASE_FIXTURE(tmp_dir_with_io_service_fixture, "flush sync_range and allocate file")
+{
+	auto run = [&]() -> cppcoro::task<>
+	{
+		cppcoro::io_work_scope ioScope{ io_service() };
+		auto f = cppcoro::read_write_file::open(io_service(), temp_dir() / "foo.bin");
+
+		co_await f.allocate(0, 64 * 1024);
+		CHECK(f.size() == 64 * 1024);
+
+		char buffer[4096];
+		std::memset(buffer, 0xAB, sizeof(buffer));
+		CHECK(co_await f.write(4096, buffer, sizeof(buffer)) == sizeof(buffer));
+		co_await f.sync_range(4096, sizeof(buffer));
+		co_await f.flush(cppcoro::file_durability::data);
+		co_await f.flush();
+
+		// Preallocated space reads back as zeroes.
+		char readBack[8192];
+		CHECK(co_await f.read(0, readBack, sizeof(readBack)) == sizeof(readBack));
+		CHECK(std::all_of(readBack, readBack + 4096, [](char c) { return c == 0; }));
+		CHECK(std::memcmp(readBack + 4096, buffer, sizeof(buffer)) == 0);
+		CHECK(f.size() == 64 * 1024);
+	};
+
+	cppcoro::sync_wait(run());
+}
+
+namespace
+{
+	cppcoro::task<> check_open_async(cppcoro::io_service& ioService, const fs::path& dir)
+	{
+		cppcoro::io_work_scope ioScope{ ioService };
+
+		char buffer[100];
+		std::memset(buffer, 0xAB, sizeof(buffer));
+		{
+			auto f = co_await cppcoro::write_only_file::open_async(
+				ioService, dir / "foo.bin", cppcoro::file_open_mode::create_always);
+			CHECK(co_await f.write(0, buffer, sizeof(buffer)) == sizeof(buffer));
+			CHECK(co_await f.size_async() == sizeof(buffer));
+			co_await f.close_async();
+		}
+
+		auto f = co_await cppcoro::read_write_file::open_async(
+			ioService, dir / "foo.bin", cppcoro::file_open_mode::open_existing);
+		CHECK(co_await f.size_async() == sizeof(buffer));
+		char readBack[sizeof(buffer)];
+		CHECK(co_await f.read(0, readBack, sizeof(readBack)) == sizeof(readBack));
+		CHECK(std::memcmp(readBack, buffer, sizeof(buffer)) == 0);
+		co_await f.close_async();
+
+		int error = 0;
+		try
+		{
+			(void)co_await cppcoro::read_only_file::open_async(ioService, dir / "missing");
+		}
+		catch (const std::system_error& e)
+		{
+			error = e.code().value();
+		}
+		CHECK(error == ENOENT);
+	}
+}
+
+TEST_CASE_FIXTURE(tmp_dir_with_io_service_fixture, "open size and close file asynchronously")
+{
+	cppcoro::sync_wait(check_open_async(io_service(), temp_dir()));
+}
+
+namespace
+{
+	cppcoro::task<> check_map(cppcoro::io_service& ioService, const fs::path& dir)
+	{
+		cppcoro::io_work_scope ioScope{ ioService };
+
+		// A few pages and a partial one.
+		std::string contents(3 * 4096 + 100, '\0');
+		for (std::size_t i = 0; i < contents.size(); ++i)
+		{
+			contents[i] = static_cast<char>(i % 251);
+		}
+		{
+			auto f = cppcoro::write_only_file::open(ioService, dir / "index.bin");
+			CHECK(co_await f.write(0, contents.data(), contents.size()) == contents.size());
+		}
+
+		auto view = cppcoro::read_only_file::open(ioService, dir / "index.bin").map();
+		REQUIRE(view.size() == contents.size());
+
+		co_await view.prefetch(4096 + 10, 100);
+		co_await view.populate(0, view.size());
+		CHECK(view.is_resident(0, view.size()));
+		CHECK(std::memcmp(view.data(), contents.data(), contents.size()) == 0);
+
+		// Ranges past the end are clamped.
+		co_await view.prefetch(view.size() - 1, 1 << 20);
+		co_await view.populate(view.size() + 4096, 10);
+		CHECK(view.is_resident(view.size() - 1, 1 << 20));
+
+		cppcoro::mapped_file moved{ std::move(view) };
+		CHECK(view.size() == 0);
+		CHECK(moved.bytes()[contents.size() - 1] == std::byte(contents.back()));
+
+		{
+			auto f = cppcoro::write_only_file::open(ioService, dir / "empty.bin");
+		}
+		auto empty = cppcoro::read_only_file::open(ioService, dir / "empty.bin").map();
+		CHECK(empty.size() == 0);
+		co_await empty.prefetch(0, 100);
+		CHECK(empty.is_resident(0, 100));
+	}
+}
+
+TEST_CASE_FIXTURE(tmp_dir_with_io_service_fixture, "map file")
+{
+	cppcoro::sync_wait(check_map(io_service(), temp_dir()));
+}
+
+namespace
+{
+	// Advises a range longer than IORING_OP_MADVISE takes, with a hole in
+	// its last 4 GiB that the advice must reach to fail.
+	cppcoro::task<> check_advise_long_range(cppcoro::io_service& ioService)
+	{
+		cppcoro::io_work_scope ioScope{ ioService };
+
+		constexpr std::uint64_t length = std::uint64_t{ 5 } << 30;
+		const auto pageSize = static_cast<std::uint64_t>(::sysconf(_SC_PAGESIZE));
+		void* address = ::mmap(
+			nullptr, length, PROT_NONE, MAP_PRIVATE | MAP_ANONYMOUS | MAP_NORESERVE, -1, 0);
+		REQUIRE(address != MAP_FAILED);
+		auto unmapOnExit = cppcoro::on_scope_exit([&] { ::munmap(address, length); });
+
+		const std::uint64_t holeOffset = (std::uint64_t{ 9 } << 29) & ~(pageSize - 1);
+		REQUIRE(::munmap(static_cast<char*>(address) + holeOffset, pageSize) == 0);
+
+		co_await cppcoro::mapped_file_advise_operation{ ioService, address, holeOffset, MADV_NORMAL };
+
+		int error = 0;
+		try
+		{
+			co_await cppcoro::mapped_file_advise_operation{ ioService, address, length, MADV_NORMAL };
+		}
+		catch (const std::system_error& e)
+		{
+			error = e.code().value();
+		}
+		CHECK(error == ENOMEM);
+	}
+}
+
+TEST_CASE_FIXTURE(io_service_fixture, "advise range longer than IORING_OP_MADVISE takes")
+{
+	cppcoro::sync_wait(check_advise_long_range(io_service()));
+}
+#endif
+
+#if CPPCORO_USE_IO_RING
+TEST_CASE_FIXTURE(tmp_dir_with_io_service_fixture, "open size and close file without OPENAT/STATX/CLOSE")
+{
+	cppcoro::detail::lnx::uring_capabilities restricted;
+	restricted.openat = false;
+	restricted.statx = false;
+	restricted.close = false;
+	io_service().io_queue().restrict_capabilities(restricted);
+
+	cppcoro::sync_wait(check_open_async(io_service(), temp_dir()));
+}
+
+TEST_CASE_FIXTURE(tmp_dir_with_io_service_fixture, "allocate file without IORING_OP_FALLOCATE")
+{
+	cppcoro::detail::lnx::uring_capabilities restricted;
+	restricted.fallocate = false;
+	io_service().io_queue().restrict_capabilities(restricted);
+
+	auto run = [&]() -> cppcoro::task<>
+	{
+		cppcoro::io_work_scope ioScope{ io_service() };
+		auto f = cppcoro::read_write_file::open(io_service(), temp_dir() / "foo.bin");
+
+		co_await f.allocate(0, 8192);
+		CHECK(f.size() == 8192);
+	};
+
+	cppcoro::sync_wait(run());
+}
+
+TEST_CASE_FIXTURE(tmp_dir_with_io_service_fixture, "map file without IORING_OP_MADVISE")
+{
+	cppcoro::detail::lnx::uring_capabilities restricted;
+	restricted.madvise = false;
+	io_service().io_queue().restrict_capabilities(restricted);
+
+	cppcoro::sync_wait(check_map(io_service(), temp_dir()));
+}
+
+TEST_CASE_FIXTURE(io_service_fixture, "advise range longer than IORING_OP_MADVISE takes without IORING_OP_MADVISE")
+{
+	cppcoro::detail::lnx::uring_capabilities restricted;
+	restricted.madvise = false;
+	io_service().io_queue().restrict_capabilities(restricted);
+
+	cppcoro::sync_wait(check_advise_long_range(io_service()));
+}
+#endif
+
+#if CPPCORO_USE_IO_RING
+TEST_CASE_FIXTURE(tmp_dir_with_io_service_fixture, "read write file without IORING_OP_READ/WRITE")
+{
+	cppcoro::detail::lnx::uring_capabilities restricted;
+	restricted.read_write = false;
+	io_service().io_queue().restrict_capabilities(restricted);
+
+	auto run = [&]() -> cppcoro::task<>
+	{
+		cppcoro::io_work_scope ioScope{ io_service() };
+		auto f = cppcoro::read_write_file::open(io_service(), temp_dir() / "foo.txt");
+
+		char buffer1[100];
+		std::memset(buffer1, 0xAB, sizeof(buffer1));
+
+		CHECK(co_await f.write(0, buffer1, sizeof(buffer1)) == sizeof(buffer1));
+
+		char buffer2[100];
+		std::memset(buffer2, 0xCC, sizeof(buffer2));
+
+		CHECK(co_await f.read(0, buffer2, sizeof(buffer2)) == sizeof(buffer2));
+		CHECK(std::memcmp(buffer1, buffer2, sizeof(buffer1)) == 0);
+	};
+
+	cppcoro::sync_wait(run());
+}
+#endif
+
+#if CPPCORO_OS_LINUX
+TEST_CASE_FIXTURE(tmp_dir_with_io_service_fixture, "unbuffered read write file")
+{
+	std::optional<cppcoro::read_write_file> f;
+	try
+	{
+		f.emplace(cppcoro::read_write_file::open(
+			io_service(),
+			temp_dir() / "foo.bin",
+			cppcoro::file_open_mode::create_always,
+			cppcoro::file_share_mode::none,
+			cppcoro::file_buffering_mode::unbuffered | cppcoro::file_buffering_mode::sequential));
+	}
+	catch (const std::system_error& e)
+	{
+		CHECK(e.code().value() == EINVAL);
+		WARN("temp directory doesn't support unbuffered I/O");
+		return;
+	}
+
+	auto run = [&]() -> cppcoro::task<>
+	{
+		cppcoro::io_work_scope ioScope{ io_service() };
+
+		const std::size_t alignment = f->unbuffered_alignment();
+		cppcoro::aligned_buffer written{ 2 * alignment, alignment };
+		CHECK(reinterpret_cast<std::uintptr_t>(written.data()) % alignment == 0);
+		for (std::size_t i = 0; i < written.size(); ++i)
+		{
+			written.data()[i] = static_cast<std::byte>(i * 7);
+		}
+		CHECK(co_await f->write(0, written.data(), written.size()) == written.size());
+
+		cppcoro::aligned_buffer read{ written.size(), alignment };
+		CHECK(co_await f->read(0, read.data(), read.size()) == read.size());
+		CHECK(std::memcmp(written.data(), read.data(), read.size()) == 0);
+	};
+
+	cppcoro::sync_wait(run());
+}
+
+TEST_CASE_FIXTURE(tmp_dir_with_io_service_fixture, "temporary file is unnamed")
+{
+	auto run = [&]() -> cppcoro::task<>
+	{
+		cppcoro::io_work_scope ioScope{ io_service() };
+		auto f = cppcoro::read_write_file::open(
+			io_service(),
+			temp_dir(),
+			cppcoro::file_open_mode::create_always,
+			cppcoro::file_share_mode::none,
+			cppcoro::file_buffering_mode::temporary | cppcoro::file_buffering_mode::write_through);
+
+		char buffer1[100];
+		std::memset(buffer1, 0xAB, sizeof(buffer1));
+		CHECK(co_await f.write(0, buffer1, sizeof(buffer1)) == sizeof(buffer1));
+
+		char buffer2[100];
+		CHECK(co_await f.read(0, buffer2, sizeof(buffer2)) == sizeof(buffer2));
+		CHECK(std::memcmp(buffer1, buffer2, sizeof(buffer1)) == 0);
+
+		CHECK(fs::is_empty(temp_dir()));
+	};
+
+	cppcoro::sync_wait(run());
+}
+#endif
+
 TEST_CASE_FIXTURE(tmp_dir_with_io_service_fixture, "cancel read")
 {
 	cppcoro::sync_wait([&]() -> cppcoro::task<>
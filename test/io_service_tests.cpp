@@ -104,6 +104,154 @@ TEST_CASE_FIXTURE(multi_io_thread_servicing_events_fixture, "multiple I/O thread
 	CHECK(completedCount == operations);
 }
 
+TEST_CASE("process_pending_events dispatches a burst of completions")
+{
+	cppcoro::io_service service{ 512 };
+
+	constexpr std::size_t operationCount = 300;
+	std::size_t completedCount = 0;
+
+	auto startTask = [&]() -> cppcoro::task<>
+	{
+		co_await service.schedule();
+		++completedCount;
+	};
+
+	std::vector<cppcoro::task<>> tasks;
+	for (std::size_t i = 0; i < operationCount; ++i)
+	{
+		tasks.emplace_back(startTask());
+	}
+
+	cppcoro::sync_wait(cppcoro::when_all_ready(
+		cppcoro::when_all_ready(std::move(tasks)),
+		[&]() -> cppcoro::task<>
+		{
+			CHECK(completedCount == 0);
+
+			// Completions are reaped in batches but every one of them
+			// must still be dispatched and counted.
+			std::uint64_t eventCount = 0;
+			while (completedCount < operationCount)
+			{
+				eventCount += service.process_pending_events();
+			}
+
+			CHECK(eventCount == operationCount);
+			CHECK(completedCount == operationCount);
+
+			co_return;
+		}()));
+}
+
+#if CPPCORO_USE_IO_RING
+using deferred_submission_fixture = io_service_fixture_with_threads<1, 64>;
+
+TEST_CASE_FIXTURE(deferred_submission_fixture, "operations started while dispatching are submitted in one batch")
+{
+	auto& queue = io_service().io_queue();
+	queue.set_submit_high_water_mark(32);
+
+	constexpr std::size_t operationCount = 16;
+	std::atomic<std::size_t> completedCount = 0;
+
+	auto scheduleTask = [&]() -> cppcoro::task<>
+	{
+		co_await io_service().schedule();
+		++completedCount;
+	};
+
+	auto runOnIoThread = [&]() -> cppcoro::task<>
+	{
+		co_await io_service().schedule();
+
+		// All of these schedule() calls are made from within a single
+		// dispatch and so should share one io_uring_submit().
+		std::vector<cppcoro::task<>> tasks;
+		for (std::size_t i = 0; i < operationCount; ++i)
+		{
+			tasks.emplace_back(scheduleTask());
+		}
+
+		co_await cppcoro::when_all(std::move(tasks));
+	};
+
+	cppcoro::sync_wait(runOnIoThread());
+
+	CHECK(completedCount == operationCount);
+
+	const auto stats = queue.stats();
+	CHECK(stats.max_sqes_per_submit >= operationCount);
+	CHECK(stats.submitted_sqes > stats.submit_calls);
+}
+
+TEST_CASE("ring per thread"
+	* doctest::timeout{ 5.0 })
+{
+	using namespace std::literals::chrono_literals;
+
+	cppcoro::io_service ioService{ 64 };
+	if (!ioService.io_queue().enable_ring_per_thread())
+	{
+		MESSAGE("IORING_OP_MSG_RING not supported, skipping");
+		return;
+	}
+
+	std::vector<std::thread> ioThreads;
+	auto stopOnExit = cppcoro::on_scope_exit([&]
+	{
+		ioService.stop();
+		for (auto& thread : ioThreads)
+		{
+			thread.join();
+		}
+	});
+	for (int i = 0; i < 2; ++i)
+	{
+		ioThreads.emplace_back([&] { ioService.process_events(); });
+	}
+
+	constexpr int taskCount = 100;
+	std::atomic<int> completedCount = 0;
+
+	auto startTask = [&]() -> cppcoro::task<>
+	{
+		co_await ioService.schedule();
+		// Now on an I/O thread, these go to that thread's own ring.
+		co_await ioService.schedule();
+		co_await ioService.schedule_after(1ms);
+		++completedCount;
+	};
+
+	std::vector<cppcoro::task<>> tasks;
+	for (int i = 0; i < taskCount; ++i)
+	{
+		tasks.emplace_back(startTask());
+	}
+
+	cppcoro::sync_wait(cppcoro::when_all(std::move(tasks)));
+
+	CHECK(completedCount == taskCount);
+
+	// Cancel a timer armed on an I/O thread's ring from this thread.
+	cppcoro::cancellation_source source;
+	cppcoro::sync_wait(cppcoro::when_all_ready(
+		[&]() -> cppcoro::task<>
+		{
+			co_await ioService.schedule();
+			CHECK_THROWS_AS(
+				co_await ioService.schedule_after(20'000ms, source.token()),
+				const cppcoro::operation_cancelled&);
+		}(),
+		[&]() -> cppcoro::task<>
+		{
+			std::this_thread::sleep_for(50ms);
+			source.request_cancellation();
+			co_return;
+		}()));
+}
+#endif
+
 TEST_CASE("Multiple concurrent timers")
 {
 	cppcoro::io_service ioService;
@@ -203,6 +351,126 @@ TEST_CASE("Timer cancellation"
 		}()));
 }
 
+#if CPPCORO_USE_IO_RING
+TEST_CASE("opcode capabilities are probed")
+{
+	cppcoro::io_service ioService;
+	auto& queue = ioService.io_queue();
+
+	const auto probed = queue.capabilities();
+	MESSAGE("send: " << probed.send << ", accept: " << probed.accept
+		<< ", connect: " << probed.connect << ", close: " << probed.close
+		<< ", timeout_remove: " << probed.timeout_remove
+		<< ", async_cancel: " << probed.async_cancel);
+
+	cppcoro::detail::lnx::uring_capabilities restricted;
+	restricted.timeout_remove = false;
+	queue.restrict_capabilities(restricted);
+
+	CHECK_FALSE(queue.capabilities().timeout_remove);
+	CHECK(queue.capabilities().async_cancel == probed.async_cancel);
+	CHECK(queue.capabilities().send == probed.send);
+}
+
+TEST_CASE("Timer cancellation without IORING_OP_TIMEOUT_REMOVE"
+	* doctest::timeout{ 5.0 })
+{
+	using namespace std::literals::chrono_literals;
+
+	cppcoro::io_service ioService;
+	if (!ioService.io_queue().capabilities().async_cancel)
+	{
+		MESSAGE("IORING_OP_ASYNC_CANCEL not supported, skipping");
+		return;
+	}
+
+	cppcoro::detail::lnx::uring_capabilities restricted;
+	restricted.timeout_remove = false;
+	ioService.io_queue().restrict_capabilities(restricted);
+
+	cppcoro::cancellation_source source;
+	cppcoro::sync_wait(cppcoro::when_all_ready(
+		[&]() -> cppcoro::task<>
+		{
+			auto stopOnExit = cppcoro::on_scope_exit([&] { ioService.stop(); });
+			co_await cppcoro::when_all_ready(
+				[&]() -> cppcoro::task<>
+				{
+					CHECK_THROWS_AS(
+						co_await ioService.schedule_after(20'000ms, source.token()),
+						const cppcoro::operation_cancelled&);
+				}(),
+				[&]() -> cppcoro::task<>
+				{
+					co_await ioService.schedule_after(1ms);
+					source.request_cancellation();
+				}());
+		}(),
+		[&]() -> cppcoro::task<>
+		{
+			ioService.process_events();
+			co_return;
+		}()));
+}
+
+TEST_CASE("Cancelled timers don't submit an SQE each"
+	* doctest::timeout{ 5.0 })
+{
+	using namespace std::literals::chrono_literals;
+
+	cppcoro::io_service ioService;
+	auto& queue = ioService.io_queue();
+
+	constexpr std::uint32_t timerCount = 1'000;
+	std::uint32_t cancelledCount = 0;
+
+	cppcoro::cancellation_source source;
+	auto longWait = [&](std::chrono::milliseconds duration) -> cppcoro::task<>
+	{
+		try
+		{
+			co_await ioService.schedule_after(duration, source.token());
+		}
+		catch (const cppcoro::operation_cancelled&)
+		{
+			++cancelledCount;
+		}
+	};
+
+	cppcoro::sync_wait(cppcoro::when_all_ready(
+		[&]() -> cppcoro::task<>
+		{
+			auto stopOnExit = cppcoro::on_scope_exit([&] { ioService.stop(); });
+			co_await ioService.schedule();
+
+			const auto submittedBefore = queue.stats().submitted_sqes;
+
+			std::vector<cppcoro::task<>> tasks;
+			tasks.reserve(timerCount);
+			for (std::uint32_t i = 0; i < timerCount; ++i)
+			{
+				tasks.emplace_back(longWait(10'000ms + std::chrono::milliseconds{ i * 7 }));
+			}
+			co_await cppcoro::when_all_ready(
+				cppcoro::when_all_ready(std::move(tasks)),
+				[&]() -> cppcoro::task<>
+				{
+					co_await ioService.schedule_after(1ms);
+					source.request_cancellation();
+				}());
+
+			CHECK(queue.stats().submitted_sqes - submittedBefore < 10);
+		}(),
+		[&]() -> cppcoro::task<>
+		{
+			ioService.process_events();
+			co_return;
+		}()));
+
+	CHECK(cancelledCount == timerCount);
+}
+#endif
+
 #if CPPCORO_USE_IO_RING
 using many_concurrent_fixture = io_service_fixture_with_threads<1, 10>;
 #else
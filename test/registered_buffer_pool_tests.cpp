@@ -0,0 +1,196 @@
+///////////////////////////////////////////////////////////////////////////////
+// Copyright (c) Lewis Baker
+// Licenced under MIT license. See LICENSE.txt for details.
+///////////////////////////////////////////////////////////////////////////////
+
+#include <cppcoro/registered_buffer_pool.hpp>
+#include <cppcoro/io_service.hpp>
+#include <cppcoro/read_write_file.hpp>
+#include <cppcoro/net/socket.hpp>
+#include <cppcoro/task.hpp>
+#include <cppcoro/sync_wait.hpp>
+#include <cppcoro/when_all.hpp>
+#include <cppcoro/on_scope_exit.hpp>
+
+#include <cstring>
+#include <random>
+#include <string>
+
+#include "io_service_fixture.hpp"
+
+#include "doctest/cppcoro_doctest.h"
+
+using namespace cppcoro;
+using namespace cppcoro::net;
+
+TEST_SUITE_BEGIN("registered_buffer_pool");
+
+TEST_CASE("lease and return slabs")
+{
+	io_service ioSvc;
+	registered_buffer_pool pool{ ioSvc, 4096, 2 };
+
+#if CPPCORO_USE_IO_RING
+	CHECK(pool.is_registered());
+#else
+	CHECK(!pool.is_registered());
+#endif
+	CHECK(pool.slab_size() == 4096);
+	CHECK(pool.slab_count() == 2);
+
+	auto a = pool.try_lease();
+	auto b = pool.try_lease();
+	REQUIRE(a);
+	REQUIRE(b);
+	CHECK(a.size() == 4096);
+	CHECK(a.data() != b.data());
+	CHECK(reinterpret_cast<std::uintptr_t>(a.data()) % 4096 == 0);
+	if (pool.is_registered())
+	{
+		CHECK(a.buffer_index() == 0);
+		CHECK(b.buffer_index() == 1);
+	}
+
+	CHECK(pool.available() == 0);
+	CHECK(!pool.try_lease());
+
+	registered_buffer moved = std::move(a);
+	CHECK(!a);
+	CHECK(pool.available() == 0);
+
+	moved.reset();
+	CHECK(pool.available() == 1);
+
+	auto c = pool.try_lease();
+	REQUIRE(c);
+	CHECK(pool.available() == 0);
+}
+
+TEST_CASE("second pool on an io_service is not registered")
+{
+	io_service ioSvc;
+	registered_buffer_pool first{ ioSvc, 64, 1 };
+	registered_buffer_pool second{ ioSvc, 64, 1 };
+
+	CHECK(!second.is_registered());
+	auto lease = second.try_lease();
+	REQUIRE(lease);
+	CHECK(lease.buffer_index() == -1);
+}
+
+TEST_CASE_FIXTURE(io_service_fixture, "read write file with leased buffers")
+{
+	std::random_device random;
+	const auto path = filesystem::temp_directory_path() /
+		("cppcoro_registered_buffer_" + std::to_string(random()));
+	auto removeOnExit = on_scope_exit([&] { filesystem::remove(path); });
+
+	registered_buffer_pool pool{ io_service(), 4096, 2 };
+
+	auto run = [&]() -> task<>
+	{
+		io_work_scope ioScope{ io_service() };
+		auto f = read_write_file::open(io_service(), path);
+
+		auto out = pool.try_lease();
+		auto in = pool.try_lease();
+		std::memset(out.data(), 0xAB, out.size());
+		std::memset(in.data(), 0xCC, in.size());
+
+		CHECK(co_await f.write(0, out, out.size()) == out.size());
+		CHECK(co_await f.read(0, in, in.size()) == in.size());
+		CHECK(std::memcmp(out.data(), in.data(), in.size()) == 0);
+	};
+
+	sync_wait(run());
+}
+
+namespace
+{
+	void check_send_leased(io_service& ioSvc)
+	{
+		registered_buffer_pool pool{ ioSvc, 1024, 1 };
+
+		auto listeningSocket = socket::create_tcpv4(ioSvc);
+		listeningSocket.bind(ipv4_endpoint{ ipv4_address::loopback(), 0 });
+		listeningSocket.listen(3);
+
+		constexpr std::size_t rounds = 8;
+
+		auto server = [&]() -> task<int>
+		{
+			auto acceptingSocket = socket::create_tcpv4(ioSvc);
+			co_await listeningSocket.accept(acceptingSocket);
+
+			std::uint8_t buffer[1024];
+			std::size_t totalBytesReceived = 0;
+			std::size_t bytesReceived;
+			bool ok = true;
+			do
+			{
+				bytesReceived = co_await acceptingSocket.recv(buffer, sizeof(buffer));
+				for (std::size_t i = 0; i < bytesReceived; ++i)
+				{
+					ok = ok && buffer[i] == static_cast<std::uint8_t>((totalBytesReceived + i) / 1024);
+				}
+				totalBytesReceived += bytesReceived;
+			} while (bytesReceived > 0);
+
+			CHECK(ok);
+			CHECK(totalBytesReceived == rounds * 1024);
+			co_return 0;
+		};
+
+		auto client = [&]() -> task<int>
+		{
+			auto connectingSocket = socket::create_tcpv4(ioSvc);
+			co_await connectingSocket.connect(listeningSocket.local_endpoint());
+
+			// A single slab, reused as soon as each send completes.
+			auto lease = pool.try_lease();
+			REQUIRE(lease);
+			for (std::size_t round = 0; round < rounds; ++round)
+			{
+				std::memset(lease.data(), static_cast<int>(round), lease.size());
+				CHECK(co_await connectingSocket.send(lease, lease.size()) == lease.size());
+			}
+			connectingSocket.close_send();
+			co_return 0;
+		};
+
+		(void)sync_wait(when_all(
+			[&]() -> task<int>
+			{
+				auto stopOnExit = on_scope_exit([&] { ioSvc.stop(); });
+				(void)co_await when_all(client(), server());
+				co_return 0;
+			}(),
+			[&]() -> task<int>
+			{
+				ioSvc.process_events();
+				co_return 0;
+			}()));
+	}
+}
+
+TEST_CASE("send TCP/IPv4 from leased buffers")
+{
+	io_service ioSvc;
+	check_send_leased(ioSvc);
+}
+
+#if CPPCORO_USE_IO_RING
+TEST_CASE("send TCP/IPv4 from leased buffers without SEND_ZC and SEND")
+{
+	io_service ioSvc;
+
+	detail::lnx::uring_capabilities restricted;
+	restricted.send_zc = false;
+	restricted.send = false;
+	ioSvc.io_queue().restrict_capabilities(restricted);
+
+	check_send_leased(ioSvc);
+}
+#endif
+
+TEST_SUITE_END();
@@ -5,6 +5,8 @@
 
 #include <cppcoro/io_service.hpp>
 #include <cppcoro/net/socket.hpp>
+#include <cppcoro/read_only_file.hpp>
+#include <cppcoro/write_only_file.hpp>
 #include <cppcoro/task.hpp>
 #include <cppcoro/when_all.hpp>
 #include <cppcoro/sync_wait.hpp>
@@ -13,11 +15,49 @@
 #include <cppcoro/cancellation_token.hpp>
 #include <cppcoro/async_scope.hpp>
 
+#include <atomic>
+#include <chrono>
+#include <cstdlib>
+#include <cstring>
+#include <new>
+#include <random>
+#include <string>
+#include <string_view>
+#include <tuple>
+#include <vector>
+
 #include "doctest/cppcoro_doctest.h"
 
 using namespace cppcoro;
 using namespace cppcoro::net;
 
+namespace
+{
+	std::atomic<std::size_t> allocationCount{ 0 };
+}
+
+// Count every allocation made by this test binary so that tests can assert
+// that a steady-state I/O loop doesn't touch the heap.
+void* operator new(std::size_t size)
+{
+	allocationCount.fetch_add(1, std::memory_order_relaxed);
+	if (void* p = std::malloc(size == 0 ? 1 : size))
+	{
+		return p;
+	}
+	throw std::bad_alloc{};
+}
+
+void operator delete(void* p) noexcept
+{
+	std::free(p);
+}
+
+void operator delete(void* p, std::size_t) noexcept
+{
+	std::free(p);
+}
+
 TEST_SUITE_BEGIN("socket");
 
 TEST_CASE("create TCP/IPv4")
@@ -93,6 +133,87 @@ TEST_CASE("TCP/IPv4 connect/disconnect")
 		}()));
 }
 
+TEST_CASE("TCP/IPv4 recv loop does not allocate")
+{
+	io_service ioSvc;
+
+	auto listeningSocket = socket::create_tcpv4(ioSvc);
+
+	listeningSocket.bind(ipv4_endpoint{ ipv4_address::loopback(), 0 });
+	listeningSocket.listen(3);
+
+	constexpr std::size_t warmUpCount = 16;
+	constexpr std::size_t byteCount = 4096;
+	std::size_t allocationsDuringLoop = 0;
+
+	auto receiver = [&]() -> task<std::size_t>
+	{
+		auto acceptingSocket = socket::create_tcpv4(ioSvc);
+
+		co_await listeningSocket.accept(acceptingSocket);
+
+		// Receive one byte at a time so that each recv() is a separate
+		// I/O operation.
+		std::uint8_t byte;
+		std::size_t totalBytesReceived = 0;
+		std::size_t allocationCountAtStart = 0;
+		while (totalBytesReceived < byteCount)
+		{
+			if (totalBytesReceived == warmUpCount)
+			{
+				allocationCountAtStart = allocationCount.load(std::memory_order_relaxed);
+			}
+
+			const std::size_t bytesReceived = co_await acceptingSocket.recv(&byte, 1);
+			if (bytesReceived == 0)
+			{
+				break;
+			}
+			totalBytesReceived += bytesReceived;
+		}
+		allocationsDuringLoop =
+			allocationCount.load(std::memory_order_relaxed) - allocationCountAtStart;
+
+		co_return totalBytesReceived;
+	};
+
+	auto sender = [&]() -> task<std::size_t>
+	{
+		auto connectingSocket = socket::create_tcpv4(ioSvc);
+		connectingSocket.bind(ipv4_endpoint{});
+		co_await connectingSocket.connect(listeningSocket.local_endpoint());
+
+		std::vector<std::uint8_t> buffer(byteCount, 0xAB);
+		std::size_t totalBytesSent = 0;
+		while (totalBytesSent < byteCount)
+		{
+			totalBytesSent += co_await connectingSocket.send(
+				buffer.data() + totalBytesSent,
+				byteCount - totalBytesSent);
+		}
+
+		co_return totalBytesSent;
+	};
+
+	auto [transferred, unused] = sync_wait(when_all(
+		[&]() -> task<std::tuple<std::size_t, std::size_t>>
+		{
+			auto stopOnExit = on_scope_exit([&] { ioSvc.stop(); });
+			co_return co_await when_all(receiver(), sender());
+		}(),
+		[&]() -> task<int>
+		{
+			ioSvc.process_events();
+			co_return 0;
+		}()));
+	(void)unused;
+
+	auto [bytesReceived, bytesSent] = transferred;
+	CHECK(bytesReceived == byteCount);
+	CHECK(bytesSent == byteCount);
+	CHECK(allocationsDuringLoop == 0);
+}
+
 TEST_CASE("send/recv TCP/IPv4")
 {
 	io_service ioSvc;
@@ -206,6 +327,680 @@ TEST_CASE("send/recv TCP/IPv4")
 		}()));
 }
 
+namespace
+{
+	// Streams more data than the pool holds, so buffers must be recycled.
+	void check_recv_pooled(io_service& ioSvc)
+	{
+		ioSvc.io_queue().set_provided_buffers(4, 64);
+
+		auto listeningSocket = socket::create_tcpv4(ioSvc);
+		listeningSocket.bind(ipv4_endpoint{ ipv4_address::loopback(), 0 });
+		listeningSocket.listen(3);
+
+		std::vector<std::uint8_t> message(1000);
+		for (std::size_t i = 0; i < message.size(); ++i)
+		{
+			message[i] = static_cast<std::uint8_t>(i * 7);
+		}
+
+		auto server = [&]() -> task<int>
+		{
+			auto acceptingSocket = socket::create_tcpv4(ioSvc);
+			co_await listeningSocket.accept(acceptingSocket);
+
+			std::vector<std::uint8_t> received;
+			while (true)
+			{
+				auto buffer = co_await acceptingSocket.recv_pooled();
+				if (buffer.size() == 0)
+				{
+					break;
+				}
+				CHECK(buffer.size() <= 64);
+				const auto* data = reinterpret_cast<const std::uint8_t*>(buffer.data());
+				received.insert(received.end(), data, data + buffer.size());
+			}
+
+			CHECK(received == message);
+			co_return 0;
+		};
+
+		auto client = [&]() -> task<int>
+		{
+			auto connectingSocket = socket::create_tcpv4(ioSvc);
+			co_await connectingSocket.connect(listeningSocket.local_endpoint());
+
+			std::size_t bytesSent = 0;
+			while (bytesSent < message.size())
+			{
+				bytesSent += co_await connectingSocket.send(
+					message.data() + bytesSent, message.size() - bytesSent);
+			}
+			connectingSocket.close_send();
+			co_return 0;
+		};
+
+		(void)sync_wait(when_all(
+			[&]() -> task<int>
+			{
+				auto stopOnExit = on_scope_exit([&] { ioSvc.stop(); });
+				(void)co_await when_all(client(), server());
+				co_return 0;
+			}(),
+			[&]() -> task<int>
+			{
+				ioSvc.process_events();
+				co_return 0;
+			}()));
+	}
+}
+
+TEST_CASE("recv_pooled TCP/IPv4")
+{
+	io_service ioSvc;
+	check_recv_pooled(ioSvc);
+}
+
+namespace
+{
+	void check_accept_stream(io_service& ioSvc)
+	{
+		constexpr int connectionCount = 8;
+
+		auto listeningSocket = socket::create_tcpv4(ioSvc);
+		listeningSocket.bind(ipv4_endpoint{ ipv4_address::loopback(), 0 });
+		listeningSocket.listen(connectionCount);
+
+		std::vector<net::socket> clientSockets;
+		cancellation_source canceller;
+
+		auto server = [&]() -> task<int>
+		{
+			int accepted = 0;
+			{
+				auto connections = listeningSocket.accept_stream();
+				for (auto it = co_await connections.begin(); it != connections.end(); co_await ++it)
+				{
+					net::socket s = std::move(*it);
+					CHECK(s.local_endpoint() == listeningSocket.local_endpoint());
+					CHECK(s.remote_endpoint().to_ipv4().address() == ipv4_address::loopback());
+
+					std::uint8_t byte = 0;
+					CHECK(co_await s.recv(&byte, 1) == 1);
+					CHECK(byte == accepted);
+					if (++accepted == connectionCount)
+					{
+						break;
+					}
+				}
+			}
+
+			auto connections = listeningSocket.accept_stream(canceller.token());
+			(void)co_await when_all(
+				[&]() -> task<int>
+				{
+					bool cancelled = false;
+					try
+					{
+						(void)co_await connections.begin();
+					}
+					catch (const operation_cancelled&)
+					{
+						cancelled = true;
+					}
+					CHECK(cancelled);
+					co_return 0;
+				}(),
+				[&]() -> task<int>
+				{
+					co_await ioSvc.schedule();
+					canceller.request_cancellation();
+					co_return 0;
+				}());
+
+			co_return accepted;
+		};
+
+		auto client = [&]() -> task<int>
+		{
+			for (int i = 0; i < connectionCount; ++i)
+			{
+				auto s = socket::create_tcpv4(ioSvc);
+				s.bind(ipv4_endpoint{ ipv4_address::loopback(), 0 });
+				co_await s.connect(listeningSocket.local_endpoint());
+				const auto byte = static_cast<std::uint8_t>(i);
+				CHECK(co_await s.send(&byte, 1) == 1);
+				clientSockets.push_back(std::move(s));
+			}
+			co_return 0;
+		};
+
+		(void)sync_wait(when_all(
+			[&]() -> task<int>
+			{
+				auto stopOnExit = on_scope_exit([&] { ioSvc.stop(); });
+				auto [accepted, _] = co_await when_all(server(), client());
+				CHECK(accepted == connectionCount);
+				co_return 0;
+			}(),
+			[&]() -> task<int>
+			{
+				ioSvc.process_events();
+				co_return 0;
+			}()));
+	}
+}
+
+TEST_CASE("accept_stream TCP/IPv4")
+{
+	io_service ioSvc;
+	check_accept_stream(ioSvc);
+}
+
+TEST_CASE("vectored send/recv TCP/IPv4")
+{
+	io_service ioSvc;
+
+	auto listeningSocket = socket::create_tcpv4(ioSvc);
+	listeningSocket.bind(ipv4_endpoint{ ipv4_address::loopback(), 0 });
+	listeningSocket.listen(1);
+
+	auto server = [&]() -> task<int>
+	{
+		auto s = socket::create_tcpv4(ioSvc);
+		co_await listeningSocket.accept(s);
+
+		char header[6] = {};
+		char rest[32] = {};
+		std::size_t totalReceived = 0;
+		while (totalReceived < sizeof(header))
+		{
+			iovec vecs[] = {
+				{ header + totalReceived, sizeof(header) - totalReceived },
+				{ rest, sizeof(rest) },
+			};
+			totalReceived += co_await s.recv(vecs);
+		}
+		std::string_view restView{ rest, totalReceived - sizeof(header) };
+		std::string received{ restView };
+		while (std::size_t count = co_await s.recv(rest, sizeof(rest)))
+		{
+			received.append(rest, count);
+		}
+		CHECK(std::string_view(header, sizeof(header)) == "HEADER");
+		CHECK(received == "payload|trailer");
+		co_return 0;
+	};
+
+	auto client = [&]() -> task<int>
+	{
+		auto s = socket::create_tcpv4(ioSvc);
+		s.bind(ipv4_endpoint{ ipv4_address::loopback(), 0 });
+		co_await s.connect(listeningSocket.local_endpoint());
+
+		char header[] = "HEADER";
+		char payload[] = "payload";
+		char trailer[] = "|trailer";
+		const iovec vecs[] = {
+			{ header, 6 },
+			{ payload, 7 },
+			{ trailer, 8 },
+		};
+		cancellation_source canceller;
+		CHECK(co_await s.send(vecs, canceller.token()) == 21);
+		s.close_send();
+		co_return 0;
+	};
+
+	(void)sync_wait(when_all(
+		[&]() -> task<int>
+		{
+			auto stopOnExit = on_scope_exit([&] { ioSvc.stop(); });
+			(void)co_await when_all(server(), client());
+			co_return 0;
+		}(),
+		[&]() -> task<int>
+		{
+			ioSvc.process_events();
+			co_return 0;
+		}()));
+}
+
+namespace
+{
+	// Sends one buffer well above the zero copy threshold and one below it.
+	void check_send_zero_copy(io_service& ioSvc)
+	{
+		std::vector<std::uint8_t> data(256 * 1024 + 100);
+		for (std::size_t i = 0; i < data.size(); ++i)
+		{
+			data[i] = static_cast<std::uint8_t>(i * 31);
+		}
+		const std::size_t largeSize = data.size() - 100;
+
+		auto listeningSocket = socket::create_tcpv4(ioSvc);
+		listeningSocket.bind(ipv4_endpoint{ ipv4_address::loopback(), 0 });
+		listeningSocket.listen(1);
+
+		auto server = [&]() -> task<int>
+		{
+			auto s = socket::create_tcpv4(ioSvc);
+			co_await listeningSocket.accept(s);
+
+			std::vector<std::uint8_t> received(data.size() + 1);
+			std::size_t totalReceived = 0;
+			while (std::size_t count = co_await s.recv(
+				received.data() + totalReceived, received.size() - totalReceived))
+			{
+				totalReceived += count;
+			}
+			CHECK(totalReceived == data.size());
+			received.resize(totalReceived);
+			CHECK(received == data);
+			co_return 0;
+		};
+
+		auto client = [&]() -> task<int>
+		{
+			auto s = socket::create_tcpv4(ioSvc);
+			s.bind(ipv4_endpoint{ ipv4_address::loopback(), 0 });
+			co_await s.connect(listeningSocket.local_endpoint());
+
+			std::size_t totalSent = 0;
+			while (totalSent < largeSize)
+			{
+				totalSent += co_await s.send_zero_copy(data.data() + totalSent, largeSize - totalSent);
+			}
+			while (totalSent < data.size())
+			{
+				totalSent += co_await s.send_zero_copy(data.data() + totalSent, data.size() - totalSent);
+			}
+			s.close_send();
+			co_return 0;
+		};
+
+		(void)sync_wait(when_all(
+			[&]() -> task<int>
+			{
+				auto stopOnExit = on_scope_exit([&] { ioSvc.stop(); });
+				(void)co_await when_all(server(), client());
+				co_return 0;
+			}(),
+			[&]() -> task<int>
+			{
+				ioSvc.process_events();
+				co_return 0;
+			}()));
+	}
+}
+
+TEST_CASE("send_zero_copy TCP/IPv4")
+{
+	io_service ioSvc;
+	check_send_zero_copy(ioSvc);
+}
+
+namespace
+{
+	// Sends a file larger than a pipe, from an offset and past its end.
+	void check_send_file(io_service& ioSvc)
+	{
+		std::vector<char> data(3 * 1024 * 1024 + 123);
+		for (std::size_t i = 0; i < data.size(); ++i)
+		{
+			data[i] = static_cast<char>(i % 251);
+		}
+		const std::size_t offset = 100;
+
+		const auto path = filesystem::temp_directory_path() /
+			("cppcoro_send_file_" + std::to_string(std::random_device{}()));
+		auto removeOnExit = on_scope_exit([&] { filesystem::remove(path); });
+
+		auto listeningSocket = socket::create_tcpv4(ioSvc);
+		listeningSocket.bind(ipv4_endpoint{ ipv4_address::loopback(), 0 });
+		listeningSocket.listen(1);
+
+		auto server = [&]() -> task<int>
+		{
+			auto s = socket::create_tcpv4(ioSvc);
+			co_await listeningSocket.accept(s);
+
+			std::vector<char> received(data.size());
+			std::size_t totalReceived = 0;
+			while (std::size_t count = co_await s.recv(
+				received.data() + totalReceived, received.size() - totalReceived))
+			{
+				totalReceived += count;
+			}
+			CHECK(totalReceived == data.size() - offset);
+			CHECK(std::memcmp(received.data(), data.data() + offset, data.size() - offset) == 0);
+			co_return 0;
+		};
+
+		auto client = [&]() -> task<int>
+		{
+			{
+				auto f = write_only_file::open(ioSvc, path);
+				CHECK(co_await f.write(0, data.data(), data.size()) == data.size());
+			}
+			auto f = read_only_file::open(ioSvc, path);
+
+			auto s = socket::create_tcpv4(ioSvc);
+			s.bind(ipv4_endpoint{ ipv4_address::loopback(), 0 });
+			co_await s.connect(listeningSocket.local_endpoint());
+
+			cancellation_source canceller;
+			CHECK(co_await s.send_file(f, offset, 16, canceller.token()) == 16);
+			CHECK(co_await s.send_file(f, offset + 16, data.size()) == data.size() - offset - 16);
+			CHECK(co_await s.send_file(f, data.size(), 100) == 0);
+			s.close_send();
+			co_return 0;
+		};
+
+		(void)sync_wait(when_all(
+			[&]() -> task<int>
+			{
+				auto stopOnExit = on_scope_exit([&] { ioSvc.stop(); });
+				(void)co_await when_all(server(), client());
+				co_return 0;
+			}(),
+			[&]() -> task<int>
+			{
+				ioSvc.process_events();
+				co_return 0;
+			}()));
+	}
+}
+
+TEST_CASE("send_file TCP/IPv4")
+{
+	io_service ioSvc;
+	check_send_file(ioSvc);
+}
+
+namespace
+{
+	// Cancels a recv waiting on an idle connection.
+	void check_cancel_recv(io_service& ioSvc)
+	{
+		auto listeningSocket = socket::create_tcpv4(ioSvc);
+		listeningSocket.bind(ipv4_endpoint{ ipv4_address::loopback(), 0 });
+		listeningSocket.listen(1);
+
+		auto acceptingSocket = socket::create_tcpv4(ioSvc);
+		cancellation_source canceller;
+
+		auto server = [&]() -> task<int>
+		{
+			co_await listeningSocket.accept(acceptingSocket, canceller.token());
+
+			std::uint8_t byte = 0;
+			CHECK(co_await acceptingSocket.recv(&byte, 1, canceller.token()) == 1);
+			CHECK(byte == 42);
+
+			bool cancelled = false;
+			try
+			{
+				(void)co_await acceptingSocket.recv(&byte, 1, canceller.token());
+			}
+			catch (const operation_cancelled&)
+			{
+				cancelled = true;
+			}
+			CHECK(cancelled);
+			co_return 0;
+		};
+
+		auto client = [&]() -> task<int>
+		{
+			auto s = socket::create_tcpv4(ioSvc);
+			co_await s.connect(listeningSocket.local_endpoint(), canceller.token());
+			const std::uint8_t byte = 42;
+			CHECK(co_await s.send(&byte, 1, canceller.token()) == 1);
+
+			// Give the server time to wait for more.
+			co_await ioSvc.schedule_after(std::chrono::milliseconds{ 10 });
+			canceller.request_cancellation();
+			co_return 0;
+		};
+
+		(void)sync_wait(when_all(
+			[&]() -> task<int>
+			{
+				auto stopOnExit = on_scope_exit([&] { ioSvc.stop(); });
+				(void)co_await when_all(server(), client());
+				co_return 0;
+			}(),
+			[&]() -> task<int>
+			{
+				ioSvc.process_events();
+				co_return 0;
+			}()));
+	}
+}
+
+TEST_CASE("cancel recv TCP/IPv4")
+{
+	io_service ioSvc;
+	check_cancel_recv(ioSvc);
+}
+
+#if CPPCORO_USE_IO_RING
+TEST_CASE("sockets are registered as fixed files while open")
+{
+	io_service ioSvc;
+	io_service otherIoSvc;
+
+	auto s = socket::create_tcpv4(ioSvc);
+	const int fd = s.native_handle();
+	CHECK(ioSvc.io_queue().is_registered_file(fd));
+
+	{
+		auto moved = std::move(s);
+		CHECK(ioSvc.io_queue().is_registered_file(fd));
+
+		// Assigning to a socket of another io_service moves the registration.
+		auto other = socket::create_tcpv4(otherIoSvc);
+		const int otherFd = other.native_handle();
+		other = std::move(moved);
+		CHECK(!otherIoSvc.io_queue().is_registered_file(otherFd));
+		CHECK(!ioSvc.io_queue().is_registered_file(fd));
+		CHECK(otherIoSvc.io_queue().is_registered_file(fd));
+	}
+
+	CHECK(!otherIoSvc.io_queue().is_registered_file(fd));
+}
+
+TEST_CASE("recv_pooled TCP/IPv4 without a buffer ring")
+{
+	io_service ioSvc;
+
+	detail::lnx::uring_capabilities restricted;
+	restricted.buffer_ring = false;
+	ioSvc.io_queue().restrict_capabilities(restricted);
+
+	check_recv_pooled(ioSvc);
+}
+
+TEST_CASE("accept_stream TCP/IPv4 without accept")
+{
+	io_service ioSvc;
+
+	detail::lnx::uring_capabilities restricted;
+	restricted.accept = false;
+	ioSvc.io_queue().restrict_capabilities(restricted);
+
+	check_accept_stream(ioSvc);
+}
+
+TEST_CASE("send_file TCP/IPv4 without splice")
+{
+	io_service ioSvc;
+
+	detail::lnx::uring_capabilities restricted;
+	restricted.splice = false;
+	ioSvc.io_queue().restrict_capabilities(restricted);
+
+	check_send_file(ioSvc);
+}
+
+TEST_CASE("send_zero_copy TCP/IPv4 without SEND_ZC and SEND")
+{
+	io_service ioSvc;
+
+	detail::lnx::uring_capabilities restricted;
+	restricted.send_zc = false;
+	restricted.send = false;
+	ioSvc.io_queue().restrict_capabilities(restricted);
+
+	check_send_zero_copy(ioSvc);
+}
+
+TEST_CASE("cancel recv TCP/IPv4 without ASYNC_CANCEL")
+{
+	io_service ioSvc;
+
+	detail::lnx::uring_capabilities restricted;
+	restricted.async_cancel = false;
+	ioSvc.io_queue().restrict_capabilities(restricted);
+
+	check_cancel_recv(ioSvc);
+}
+
+TEST_CASE("accept_stream TCP/IPv4 without ASYNC_CANCEL")
+{
+	io_service ioSvc;
+
+	detail::lnx::uring_capabilities restricted;
+	restricted.async_cancel = false;
+	ioSvc.io_queue().restrict_capabilities(restricted);
+
+	check_accept_stream(ioSvc);
+}
+
+TEST_CASE("recv_pooled TCP/IPv4 without ASYNC_CANCEL")
+{
+	io_service ioSvc;
+
+	detail::lnx::uring_capabilities restricted;
+	restricted.async_cancel = false;
+	ioSvc.io_queue().restrict_capabilities(restricted);
+
+	check_recv_pooled(ioSvc);
+}
+
+TEST_CASE("send_file TCP/IPv4 without ASYNC_CANCEL")
+{
+	io_service ioSvc;
+
+	detail::lnx::uring_capabilities restricted;
+	restricted.async_cancel = false;
+	ioSvc.io_queue().restrict_capabilities(restricted);
+
+	check_send_file(ioSvc);
+}
+
+TEST_CASE("send/recv TCP/IPv4 with opcode fallbacks")
+{
+	io_service ioSvc;
+
+	// Behave as on a kernel without any of the optional opcodes.
+	static_assert(
+		sizeof(detail::lnx::uring_capabilities) == 15,
+		"turn off capabilities added to uring_capabilities here as well");
+	detail::lnx::uring_capabilities none;
+	none.read_write = false;
+	none.send = false;
+	none.recv = false;
+	none.accept = false;
+	none.connect = false;
+	none.close = false;
+	none.timeout_remove = false;
+	none.async_cancel = false;
+	none.send_zc = false;
+	none.buffer_ring = false;
+	none.fallocate = false;
+	none.openat = false;
+	none.statx = false;
+	none.madvise = false;
+	none.splice = false;
+	ioSvc.io_queue().restrict_capabilities(none);
+
+	auto listeningSocket = socket::create_tcpv4(ioSvc);
+	listeningSocket.bind(ipv4_endpoint{ ipv4_address::loopback(), 0 });
+	listeningSocket.listen(3);
+
+	auto echoServer = [&]() -> task<int>
+	{
+		auto acceptingSocket = socket::create_tcpv4(ioSvc);
+		co_await listeningSocket.accept(acceptingSocket);
+
+		std::uint8_t buffer[64];
+		std::size_t bytesReceived;
+		do
+		{
+			bytesReceived = co_await acceptingSocket.recv(buffer, sizeof(buffer));
+			std::size_t bytesSent = 0;
+			while (bytesSent < bytesReceived)
+			{
+				bytesSent += co_await acceptingSocket.send(
+					buffer + bytesSent, bytesReceived - bytesSent);
+			}
+		} while (bytesReceived > 0);
+
+		acceptingSocket.close_send();
+		co_await acceptingSocket.disconnect();
+		co_return 0;
+	};
+
+	auto echoClient = [&]() -> task<int>
+	{
+		auto connectingSocket = socket::create_tcpv4(ioSvc);
+		co_await connectingSocket.connect(listeningSocket.local_endpoint());
+		CHECK(connectingSocket.remote_endpoint() == listeningSocket.local_endpoint());
+
+		const char message[] = "hello fallback";
+		std::size_t bytesSent = 0;
+		while (bytesSent < sizeof(message))
+		{
+			bytesSent += co_await connectingSocket.send(
+				message + bytesSent, sizeof(message) - bytesSent);
+		}
+		connectingSocket.close_send();
+
+		char buffer[sizeof(message)] = {};
+		std::size_t totalBytesReceived = 0;
+		std::size_t bytesReceived;
+		do
+		{
+			bytesReceived = co_await connectingSocket.recv(
+				buffer + totalBytesReceived, sizeof(buffer) - totalBytesReceived);
+			totalBytesReceived += bytesReceived;
+		} while (bytesReceived > 0 && totalBytesReceived < sizeof(buffer));
+
+		CHECK(totalBytesReceived == sizeof(message));
+		CHECK(std::string_view{ buffer } == message);
+
+		co_await connectingSocket.disconnect();
+		co_return 0;
+	};
+
+	(void)sync_wait(when_all(
+		[&]() -> task<int>
+		{
+			auto stopOnExit = on_scope_exit([&] { ioSvc.stop(); });
+			(void)co_await when_all(echoClient(), echoServer());
+			co_return 0;
+		}(),
+		[&]() -> task<int>
+		{
+			ioSvc.process_events();
+			co_return 0;
+		}()));
+}
+#endif
+
 #if !CPPCORO_COMPILER_MSVC || CPPCORO_COMPILER_MSVC >= 192000000 || !CPPCORO_CPU_X86
 // HACK: Don't compile this function under MSVC x86.
 // It results in an ICE under VS 2017.15 and earlier.
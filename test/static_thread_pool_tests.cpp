@@ -7,13 +7,20 @@
 #include <cppcoro/task.hpp>
 #include <cppcoro/sync_wait.hpp>
 #include <cppcoro/when_all.hpp>
+#include <cppcoro/when_all_on.hpp>
 
+#include <atomic>
 #include <vector>
 #include <thread>
 #include <cassert>
 #include <chrono>
 #include <iostream>
 #include <numeric>
+#include <algorithm>
+
+#if CPPCORO_OS_LINUX
+# include <sched.h>
+#endif
 
 #include "doctest/cppcoro_doctest.h"
 
@@ -65,6 +72,256 @@ TEST_CASE("launch many tasks remotely")
 	cppcoro::sync_wait(cppcoro::when_all(std::move(tasks)));
 }
 
+TEST_CASE("launch many tasks remotely with schedule_bulk")
+{
+	cppcoro::static_thread_pool threadPool;
+
+	constexpr std::uint32_t taskCount = 10'000;
+
+	auto initiatingThreadId = std::this_thread::get_id();
+	std::atomic<std::uint32_t> runCount = 0;
+
+	auto bulkOperation = threadPool.schedule_bulk(taskCount);
+	auto makeTask = [&]() -> cppcoro::task<>
+	{
+		co_await bulkOperation;
+		CHECK(std::this_thread::get_id() != initiatingThreadId);
+		runCount.fetch_add(1, std::memory_order_relaxed);
+	};
+
+	std::vector<cppcoro::task<>> tasks;
+	for (std::uint32_t i = 0; i < taskCount; ++i)
+	{
+		tasks.push_back(makeTask());
+	}
+
+	cppcoro::sync_wait(cppcoro::when_all(std::move(tasks)));
+
+	CHECK(runCount == taskCount);
+}
+
+TEST_CASE("when_all_on fans out from inside the thread pool")
+{
+	cppcoro::static_thread_pool threadPool{ 4 };
+
+	auto square = [&](std::uint64_t x) -> cppcoro::task<std::uint64_t>
+	{
+		co_return x * x;
+	};
+
+	auto result = cppcoro::sync_wait([&]() -> cppcoro::task<std::uint64_t>
+	{
+		co_await threadPool.schedule();
+
+		std::vector<cppcoro::task<std::uint64_t>> tasks;
+		for (std::uint64_t i = 0; i < 1000; ++i)
+		{
+			tasks.push_back(square(i));
+		}
+
+		auto squares = co_await cppcoro::when_all_on(threadPool, std::move(tasks));
+		co_return std::accumulate(squares.begin(), squares.end(), std::uint64_t(0));
+	}());
+
+	CHECK(result == 332'833'500);
+
+	// An empty batch completes without being scheduled.
+	cppcoro::sync_wait(cppcoro::when_all_on(threadPool, std::vector<cppcoro::task<>>{}));
+}
+
+TEST_CASE("schedule_on_node runs on the node's CPUs")
+{
+	const auto cpus = cppcoro::static_thread_pool::numa_node_cpus(0);
+	if (cpus.empty())
+	{
+		MESSAGE("NUMA topology not available, skipping");
+		return;
+	}
+
+	cppcoro::static_thread_pool threadPool{ static_cast<std::uint32_t>(cpus.size()), cpus };
+
+	cppcoro::sync_wait([&]() -> cppcoro::task<>
+	{
+		for (int i = 0; i < 10; ++i)
+		{
+			co_await threadPool.schedule_on_node(0);
+#if CPPCORO_OS_LINUX
+			const auto cpu = static_cast<std::uint32_t>(::sched_getcpu());
+			CHECK(std::find(cpus.begin(), cpus.end(), cpu) != cpus.end());
+#endif
+		}
+
+		// No thread is on that node, runs anywhere.
+		co_await threadPool.schedule_on_node(1'000);
+	}());
+}
+
+TEST_CASE("schedule_on_node never resumes on another node")
+{
+	// Pin to the NUMA nodes if there are any, else the unpinned threads all
+	// count as node 0.
+	std::vector<std::uint32_t> nodes{ 0 };
+	std::vector<std::uint32_t> cpus = cppcoro::static_thread_pool::numa_node_cpus(0);
+	const auto otherNodeCpus = cppcoro::static_thread_pool::numa_node_cpus(1);
+	if (!cpus.empty() && !otherNodeCpus.empty())
+	{
+		nodes.push_back(1);
+		cpus.insert(cpus.end(), otherNodeCpus.begin(), otherNodeCpus.end());
+	}
+
+	cppcoro::static_thread_pool tp{
+		std::max(static_cast<std::uint32_t>(cpus.size()), 4u), cpus };
+
+	CHECK(tp.current_node() == static_cast<std::uint32_t>(-1));
+
+	std::atomic<std::uint32_t> wrongNodeCount = 0;
+	auto runOnNode = [&](std::uint32_t node) -> cppcoro::task<>
+	{
+		co_await tp.schedule_on_node(node);
+		if (tp.current_node() != node)
+		{
+			wrongNodeCount.fetch_add(1, std::memory_order_relaxed);
+		}
+
+		// Long enough for idle threads to try stealing the others.
+		const auto start = std::chrono::steady_clock::now();
+		while (std::chrono::steady_clock::now() - start < std::chrono::microseconds(50))
+		{
+		}
+	};
+
+	// Fan out from a thread of each node, and of each other node, to the
+	// node, so that the operations are also queued by threads of the node.
+	cppcoro::sync_wait([&]() -> cppcoro::task<>
+	{
+		for (auto from : nodes)
+		{
+			for (auto to : nodes)
+			{
+				co_await tp.schedule_on_node(from);
+				CHECK(tp.current_node() == from);
+
+				std::vector<cppcoro::task<>> tasks;
+				for (int i = 0; i < 500; ++i)
+				{
+					tasks.push_back(runOnNode(to));
+				}
+				co_await cppcoro::when_all(std::move(tasks));
+			}
+		}
+	}());
+
+	CHECK(wrongNodeCount == 0);
+}
+
+TEST_CASE("remote enqueue from many external threads")
+{
+	cppcoro::static_thread_pool tp;
+
+	constexpr std::uint32_t producerCount = 8;
+	constexpr std::uint32_t tasksPerProducer = 20'000;
+
+	std::atomic<std::uint32_t> completedCount = 0;
+	auto work = [&]() -> cppcoro::task<>
+	{
+		co_await tp.schedule();
+		completedCount.fetch_add(1, std::memory_order_relaxed);
+	};
+
+	auto start = std::chrono::high_resolution_clock::now();
+
+	// Each producer thread starts all of its tasks before waiting for any,
+	// so they all contend on the global queue at once.
+	std::vector<std::thread> producers;
+	for (std::uint32_t i = 0; i < producerCount; ++i)
+	{
+		producers.emplace_back([&]
+		{
+			std::vector<cppcoro::task<>> tasks;
+			tasks.reserve(tasksPerProducer);
+			for (std::uint32_t j = 0; j < tasksPerProducer; ++j)
+			{
+				tasks.push_back(work());
+			}
+			cppcoro::sync_wait(cppcoro::when_all(std::move(tasks)));
+		});
+	}
+
+	for (auto& producer : producers)
+	{
+		producer.join();
+	}
+
+	auto end = std::chrono::high_resolution_clock::now();
+
+	const auto us = std::chrono::duration_cast<std::chrono::microseconds>(end - start).count();
+	std::cout << "remote enqueue of " << producerCount * tasksPerProducer << " tasks from "
+		<< producerCount << " threads took " << us << "us" << std::endl;
+
+	CHECK(completedCount == producerCount * tasksPerProducer);
+}
+
+TEST_CASE("idle policies")
+{
+	using namespace std::chrono_literals;
+
+	cppcoro::static_thread_pool tp{ 2 };
+
+	// Hand work to the pool at intervals, so that it runs out in between.
+	auto runWithGaps = [&]
+	{
+		for (int i = 0; i < 20; ++i)
+		{
+			cppcoro::sync_wait([&]() -> cppcoro::task<>
+			{
+				co_await tp.schedule();
+			}());
+			std::this_thread::sleep_for(200us);
+		}
+	};
+
+	{
+		tp.set_idle_policy(cppcoro::static_thread_pool::idle_policy::park);
+		// Let threads that were already idle pick up the new policy.
+		runWithGaps();
+
+		const auto before = tp.stats();
+		runWithGaps();
+		const auto after = tp.stats();
+
+		CHECK(after.spin_successes == before.spin_successes);
+		CHECK(after.parks > before.parks);
+		CHECK(after.wake_ups > before.wake_ups);
+		CHECK(after.total_wake_latency > before.total_wake_latency);
+		CHECK(after.max_wake_latency > 0ns);
+	}
+
+	{
+		tp.set_idle_policy(cppcoro::static_thread_pool::idle_policy::spin, 100ms);
+		runWithGaps();
+
+		const auto before = tp.stats();
+		runWithGaps();
+		const auto after = tp.stats();
+
+		CHECK(after.spin_successes > before.spin_successes);
+		CHECK(after.spin_time > before.spin_time);
+	}
+
+	{
+		tp.set_idle_policy(cppcoro::static_thread_pool::idle_policy::adaptive, 100ms);
+		runWithGaps();
+		runWithGaps();
+
+		const auto stats = tp.stats();
+		MESSAGE("spin successes: " << stats.spin_successes
+			<< ", spin time: " << stats.spin_time.count() << "ns"
+			<< ", parks: " << stats.parks
+			<< ", wake-ups: " << stats.wake_ups
+			<< ", max wake latency: " << stats.max_wake_latency.count() << "ns");
+	}
+}
+
 cppcoro::task<std::uint64_t> sum_of_squares(
 	std::uint32_t start,
 	std::uint32_t end,
@@ -129,6 +386,78 @@ TEST_CASE("launch sub-task with many sub-tasks")
 	CHECK(result == sum);
 }
 
+cppcoro::task<std::uint64_t> fib(std::uint32_t n, cppcoro::static_thread_pool& tp)
+{
+	co_await tp.schedule();
+
+	if (n < 2)
+	{
+		co_return n;
+	}
+
+	auto[a, b] = co_await cppcoro::when_all(fib(n - 1, tp), fib(n - 2, tp));
+	co_return a + b;
+}
+
+TEST_CASE("fork-join fib steals from the forking threads")
+{
+	// At least a few threads so that there is stealing to measure.
+	cppcoro::static_thread_pool tp{ std::max(std::thread::hardware_concurrency(), 4u) };
+
+	auto start = std::chrono::high_resolution_clock::now();
+
+	auto result = cppcoro::sync_wait(fib(25, tp));
+
+	auto end = std::chrono::high_resolution_clock::now();
+
+	std::cout << "fork-join fib(25) on " << tp.thread_count() << " threads took "
+		<< std::chrono::duration_cast<std::chrono::microseconds>(end - start).count()
+		<< "us" << std::endl;
+
+	CHECK(result == 75'025);
+}
+
+TEST_CASE("idle threads steal from a flooding producer")
+{
+	// At least a few threads so that there is stealing to measure.
+	cppcoro::static_thread_pool tp{ std::max(std::thread::hardware_concurrency(), 4u) };
+
+	constexpr std::uint32_t taskCount = 200'000;
+
+	std::atomic<std::uint32_t> completedCount = 0;
+	auto work = [&]() -> cppcoro::task<>
+	{
+		co_await tp.schedule();
+		completedCount.fetch_add(1, std::memory_order_relaxed);
+	};
+
+	auto start = std::chrono::high_resolution_clock::now();
+
+	cppcoro::sync_wait([&]() -> cppcoro::task<>
+	{
+		// Every task is queued to this one thread's local queue, the
+		// others only get work by stealing it.
+		co_await tp.schedule();
+
+		std::vector<cppcoro::task<>> tasks;
+		tasks.reserve(taskCount);
+		for (std::uint32_t i = 0; i < taskCount; ++i)
+		{
+			tasks.push_back(work());
+		}
+		co_await cppcoro::when_all(std::move(tasks));
+	}());
+
+	auto end = std::chrono::high_resolution_clock::now();
+
+	std::cout << "producer flood of " << taskCount << " tasks on " << tp.thread_count()
+		<< " threads took "
+		<< std::chrono::duration_cast<std::chrono::microseconds>(end - start).count()
+		<< "us" << std::endl;
+
+	CHECK(completedCount == taskCount);
+}
+
 struct fork_join_operation
 {
 	std::atomic<std::size_t> m_count;